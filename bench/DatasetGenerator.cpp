@@ -0,0 +1,55 @@
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "Datasets.h"
+
+/**
+ * @brief Prints the usage of the program.
+ * @param program Name of the executable.
+ */
+static void PrintUsage(const char* program){
+    std::cerr << "Usage: " << program << " <kind> <nodes_count> <output_file> [--repeat <fraction>] [--seed <seed>]\n"
+              << "Kinds:";
+    for (const auto& kind : DatasetKinds()) std::cerr << ' ' << kind;
+    std::cerr << "\n";
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 4 || argc % 2 != 0){
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    try{
+        DatasetOptions options;
+        options.kind = argv[1];
+        options.nodesCount = std::stoul(argv[2]);
+        for (int i = 4; i + 1 < argc; i += 2){
+            std::string flag = argv[i];
+            if (flag == "--repeat") options.repeatFraction = std::stod(argv[i + 1]);
+            else if (flag == "--seed") options.seed = static_cast<unsigned>(std::stoul(argv[i + 1]));
+            else{
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        }
+
+        auto poly = GenerateDataset(options);
+        if (!WritePolyline(poly, argv[3])){
+            std::cerr << "Error opening file: " << argv[3];
+            return 2;
+        }
+        std::cout << "Generated " << poly.GetNodesCount() << " nodes\n";
+
+    } catch (const std::invalid_argument& e){
+        std::cerr << "Invalid argument: " << e.what() << "\n";
+        return 3;
+
+    } catch (const std::out_of_range& e) {
+        std::cerr << "Argument out of range.\n";
+        return 4;
+    }
+
+    return 0;
+}
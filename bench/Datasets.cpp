@@ -0,0 +1,82 @@
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include "Datasets.h"
+#include <vector>
+
+std::vector<std::string> DatasetKinds(){
+    return {"random-walk", "helix", "zigzag", "symmetric"};
+}
+
+Polyline3D GenerateDataset(const DatasetOptions& options){
+    std::mt19937 gen(options.seed);
+    std::uniform_real_distribution<double> unit(-1.0, 1.0);
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+    const auto pi = std::acos(-1.0);
+
+    std::vector<Point3D> nodes;
+    nodes.reserve(options.nodesCount);
+    Point3D current;
+    for (size_t i = 0; i < options.nodesCount; ++i){
+        auto t = static_cast<double>(i);
+        if (options.kind == "random-walk"){
+            nodes.push_back(current);
+            current = Point3D(current.GetX() + unit(gen), current.GetY() + unit(gen), current.GetZ() + unit(gen));
+        }
+        else if (options.kind == "helix"){
+            auto angle = 2.0 * pi * t / 64.0;
+            nodes.push_back(Point3D(10.0 * std::cos(angle), 10.0 * std::sin(angle), 0.05 * t));
+        }
+        else if (options.kind == "zigzag"){
+            nodes.push_back(Point3D(0.01 * t, i % 2 == 0 ? 0.0 : 1.0, 0.0));
+        }
+        else if (options.kind == "symmetric"){
+            auto angle = 2.0 * pi * static_cast<double>(i % 64) / 64.0;
+            nodes.push_back(Point3D(10.0 * std::cos(angle), 10.0 * std::sin(angle), 0.0));
+        }
+        else{
+            throw std::invalid_argument("Unknown dataset kind: " + options.kind);
+        }
+
+        if (chance(gen) < options.repeatFraction) nodes.push_back(nodes.back());
+    }
+    return Polyline3D(std::move(nodes));
+}
+
+std::vector<Point3D> GenerateQueries(const Polyline3D& poly, size_t count, unsigned seed){
+    std::vector<Point3D> points;
+    const auto& nodes = poly.GetNodes();
+    if (nodes.empty()) return points;
+
+    Box3D bounds;
+    for (const auto& node : nodes) bounds.Extend(node);
+    auto margin = [](double min, double max){ return 0.1 * (max - min) + 1.0; };
+    auto mx = margin(bounds.GetMin().GetX(), bounds.GetMax().GetX());
+    auto my = margin(bounds.GetMin().GetY(), bounds.GetMax().GetY());
+    auto mz = margin(bounds.GetMin().GetZ(), bounds.GetMax().GetZ());
+
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> x(bounds.GetMin().GetX() - mx, bounds.GetMax().GetX() + mx);
+    std::uniform_real_distribution<double> y(bounds.GetMin().GetY() - my, bounds.GetMax().GetY() + my);
+    std::uniform_real_distribution<double> z(bounds.GetMin().GetZ() - mz, bounds.GetMax().GetZ() + mz);
+    std::uniform_int_distribution<size_t> node(0, nodes.size() - 1);
+
+    for (size_t i = 0; i < count; ++i){
+        if (i % 10 == 0) points.push_back(nodes[node(gen)]);
+        else points.push_back(Point3D(x(gen), y(gen), z(gen)));
+    }
+    for (auto height : {0.0, 1.0, 5.0}) points.push_back(Point3D(0.0, 0.0, height));
+    return points;
+}
+
+bool WritePolyline(const Polyline3D& poly, const std::string& filename){
+    std::ofstream file(filename);
+    if (!file.is_open()) return false;
+
+    file.precision(17);
+    for (const auto& node : poly.GetNodes()){
+        file << node.GetX() << ' ' << node.GetY() << ' ' << node.GetZ() << '\n';
+    }
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "static/GeometryObjects.h"
+#include <string>
+#include <vector>
+
+/**
+ * @struct DatasetOptions
+ * @brief Parameters of a synthetic polyline.
+ */
+struct DatasetOptions{
+    std::string kind = "random-walk"; ///< One of DatasetKinds().
+    size_t nodesCount = 10000;        ///< Number of distinct nodes before duplication.
+    double repeatFraction = 0.0;      ///< Fraction of nodes that are repeated, creating degenerate segments.
+    unsigned seed = 1;                ///< Seed of the random generator.
+};
+
+/**
+ * @brief Get the names of the supported dataset kinds.
+ *
+ * random-walk: steps with uniformly distributed coordinates in [-1, 1].
+ * helix: a helix of radius 10 with 64 nodes per turn.
+ * zigzag: a dense zig-zag between two parallel lines with small steps.
+ * symmetric: a regular 64-gon traversed repeatedly in the plane z = 0, like example2.txt,
+ * producing many ties for points on its axis.
+ *
+ * @return Vector of kind names.
+ */
+std::vector<std::string> DatasetKinds();
+
+/**
+ * @brief Generates a synthetic polyline.
+ * @param options Parameters of the polyline.
+ * @return The generated polyline.
+ * @throw std::invalid_argument If the kind is unknown.
+ */
+Polyline3D GenerateDataset(const DatasetOptions& options);
+
+/**
+ * @brief Generates query points around a polyline.
+ *
+ * Points are uniformly distributed in the bounding box of the polyline expanded by 10%,
+ * a tenth of them are placed exactly on nodes, and points on the Z axis are added, which
+ * are equidistant from symmetric polylines.
+ *
+ * @param poly The polyline.
+ * @param count Number of random points.
+ * @param seed Seed of the random generator.
+ * @return The query points.
+ */
+std::vector<Point3D> GenerateQueries(const Polyline3D& poly, size_t count, unsigned seed);
+
+/**
+ * @brief Writes a polyline in the format of the files in data/.
+ * @param poly The polyline.
+ * @param filename Output file name.
+ * @return True on success.
+ */
+bool WritePolyline(const Polyline3D& poly, const std::string& filename);
@@ -0,0 +1,148 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "static/GeometryObjects.h"
+#include "static/3DMathOperations.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/SegmentIndex.h"
+#include "static/DistanceQueries.h"
+#include "Datasets.h"
+#include <vector>
+
+/**
+ * @struct Variant
+ * @brief A named way of answering a distance question for every query point.
+ */
+struct Variant{
+    std::string name;                 ///< Name used in the report.
+    std::string reference;            ///< Name of the variant the speedup is relative to, empty for none.
+    std::function<double(const Point3D&)> query; ///< Returns the distance, or 1/0 for threshold checks.
+};
+
+/**
+ * @brief Prints the usage of the program.
+ * @param program Name of the executable.
+ */
+static void PrintUsage(const char* program){
+    std::cerr << "Usage: " << program << " [--kind <kind>] [--nodes <count>] [--queries <count>] [--seed <seed>]\n";
+}
+
+int main(int argc, char* argv[])
+{
+    DatasetOptions options;
+    options.nodesCount = 20000;
+    size_t queriesCount = 1000;
+
+    try{
+        for (int i = 1; i < argc; ++i){
+            std::string flag = argv[i];
+            if (i + 1 >= argc){
+                PrintUsage(argv[0]);
+                return 1;
+            }
+            std::string value = argv[++i];
+            if (flag == "--kind") options.kind = value;
+            else if (flag == "--nodes") options.nodesCount = std::stoul(value);
+            else if (flag == "--queries") queriesCount = std::stoul(value);
+            else if (flag == "--seed") options.seed = static_cast<unsigned>(std::stoul(value));
+            else{
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        }
+    } catch (const std::exception& e){
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    Polyline3D poly;
+    try{
+        poly = GenerateDataset(options);
+    } catch (const std::invalid_argument& e){
+        std::cerr << "Invalid argument: " << e.what() << "\n";
+        return 3;
+    }
+    auto points = GenerateQueries(poly, queriesCount, options.seed + 1);
+    SegmentIndex index(poly);
+
+    /// The threshold is the median distance, so that half of the checks succeed
+    std::vector<double> expected;
+    for (const auto& point : points){
+        auto nearest = FindNearestPointsToPolyline(poly, point);
+        expected.push_back(nearest.empty() ? 0.0 : DistanceBetweenPoints(point, nearest[0].second));
+    }
+    auto sorted = expected;
+    std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+    auto threshold = sorted.empty() ? 0.0 : sorted[sorted.size() / 2];
+
+    auto viaNearest = [](const std::vector<std::pair<size_t, Point3D>>& nearest, const Point3D& point){
+        return nearest.empty() ? 0.0 : DistanceBetweenPoints(point, nearest[0].second);
+    };
+    std::vector<Variant> variants{
+        {"nearest_points", "", [&](const Point3D& point){
+            return viaNearest(FindNearestPointsToPolyline(poly, point), point);
+        }},
+        {"distance_only", "nearest_points", [&](const Point3D& point){
+            return DistanceToPolyline(poly, point);
+        }},
+        {"nearest_within", "", [&](const Point3D& point){
+            return viaNearest(FindNearestPointsToPolyline(poly, point), point) <= threshold ? 1.0 : 0.0;
+        }},
+        {"is_within", "nearest_within", [&](const Point3D& point){
+            return IsWithinDistance(poly, point, threshold) ? 1.0 : 0.0;
+        }},
+        {"indexed_nearest", "", [&](const Point3D& point){
+            return viaNearest(FindNearestPointsToIndexedPolyline(poly, index, point), point);
+        }},
+        {"indexed_distance", "indexed_nearest", [&](const Point3D& point){
+            return DistanceToIndexedPolyline(poly, index, point);
+        }},
+        {"indexed_within", "indexed_nearest", [&](const Point3D& point){
+            return IsWithinDistance(poly, index, point, threshold) ? 1.0 : 0.0;
+        }},
+    };
+
+    std::cout << options.kind << ", " << poly.GetNodesCount() << " nodes, " << points.size() << " queries, threshold "
+              << threshold << "\n";
+    std::cout << std::left << std::setw(18) << "variant" << std::right << std::setw(14) << "ns/query"
+              << std::setw(10) << "speedup" << "\n";
+
+    std::vector<std::pair<std::string, double>> timings;
+    size_t mismatches = 0;
+    for (const auto& variant : variants){
+        std::vector<double> results(points.size());
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < points.size(); ++i) results[i] = variant.query(points[i]);
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+        auto perQuery = points.empty() ? 0.0 : elapsed.count() / static_cast<double>(points.size());
+        timings.emplace_back(variant.name, perQuery);
+
+        /// Threshold checks are compared with the exact distances, allowing for their rounding
+        bool isCheck = variant.name.find("within") != std::string::npos;
+        for (size_t i = 0; i < points.size(); ++i){
+            auto want = isCheck ? (expected[i] <= threshold ? 1.0 : 0.0) : expected[i];
+            if (isCheck && std::abs(expected[i] - threshold) < eps) continue;
+            if (std::abs(results[i] - want) > eps) ++mismatches;
+        }
+
+        std::cout << std::left << std::setw(18) << variant.name << std::right << std::fixed
+                  << std::setw(14) << std::setprecision(1) << perQuery;
+        auto reference = std::find_if(timings.begin(), timings.end(), [&](const auto& timing){
+            return timing.first == variant.reference;
+        });
+        if (reference != timings.end() && perQuery > 0.0)
+            std::cout << std::setw(9) << std::setprecision(2) << reference->second / perQuery << "x";
+        std::cout << "\n";
+    }
+
+    if (mismatches != 0){
+        std::cerr << mismatches << " results differ from FindNearestPointsToPolyline\n";
+        return 5;
+    }
+    return 0;
+}
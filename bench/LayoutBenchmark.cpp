@@ -0,0 +1,198 @@
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "static/GeometryObjects.h"
+#include "static/SegmentIndex.h"
+#include "static/CompactSegmentIndex.h"
+#include "Datasets.h"
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/// Misses of the last level cache.
+constexpr uint32_t llcMissType = PERF_TYPE_HARDWARE;
+constexpr uint64_t llcMissConfig = PERF_COUNT_HW_CACHE_MISSES;
+/// Read misses of the L1 data cache.
+constexpr uint32_t l1MissType = PERF_TYPE_HW_CACHE;
+constexpr uint64_t l1MissConfig = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+#else
+constexpr uint32_t llcMissType = 0;
+constexpr uint64_t llcMissConfig = 0;
+constexpr uint32_t l1MissType = 0;
+constexpr uint64_t l1MissConfig = 0;
+#endif
+
+/**
+ * @class PerfCounter
+ * @brief Hardware event counter of the calling thread, read through perf_event_open.
+ *
+ * The counter is unavailable on other systems than Linux and where perf events are not permitted,
+ * e.g. with a high kernel.perf_event_paranoid setting or inside some containers.
+ */
+class PerfCounter{
+    int fd = -1;
+public:
+    PerfCounter(uint32_t type, uint64_t config){
+#ifdef __linux__
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+        (void)type;
+        (void)config;
+#endif
+    }
+
+    ~PerfCounter(){
+#ifdef __linux__
+        if (fd >= 0) close(fd);
+#endif
+    }
+
+    PerfCounter(const PerfCounter&) = delete;
+    PerfCounter& operator=(const PerfCounter&) = delete;
+
+    bool IsAvailable() const {return fd >= 0;}
+
+    void Start(){
+#ifdef __linux__
+        if (fd < 0) return;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    uint64_t Stop(){
+        uint64_t value = 0;
+#ifdef __linux__
+        if (fd < 0) return 0;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, &value, sizeof(value)) != static_cast<ssize_t>(sizeof(value))) value = 0;
+#endif
+        return value;
+    }
+};
+
+/**
+ * @struct Layout
+ * @brief A named index layout answering nearest point queries.
+ */
+struct Layout{
+    std::string name;                 ///< Name used in the report.
+    size_t bytes;                     ///< Memory usage of the index.
+    std::function<size_t(const Point3D&)> query; ///< Answers a query, returns the number of results.
+};
+
+/**
+ * @brief Prints the usage of the program.
+ * @param program Name of the executable.
+ */
+static void PrintUsage(const char* program){
+    std::cerr << "Usage: " << program << " [--kind <kind>] [--nodes <count>] [--queries <count>] [--seed <seed>]\n";
+}
+
+int main(int argc, char* argv[])
+{
+    DatasetOptions options;
+    options.nodesCount = 1000000;
+    size_t queriesCount = 20000;
+
+    try{
+        for (int i = 1; i < argc; ++i){
+            std::string flag = argv[i];
+            if (i + 1 >= argc){
+                PrintUsage(argv[0]);
+                return 1;
+            }
+            std::string value = argv[++i];
+            if (flag == "--kind") options.kind = value;
+            else if (flag == "--nodes") options.nodesCount = std::stoul(value);
+            else if (flag == "--queries") queriesCount = std::stoul(value);
+            else if (flag == "--seed") options.seed = static_cast<unsigned>(std::stoul(value));
+            else{
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        }
+    } catch (const std::exception& e){
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    Polyline3D poly;
+    try{
+        poly = GenerateDataset(options);
+    } catch (const std::invalid_argument& e){
+        std::cerr << "Invalid argument: " << e.what() << "\n";
+        return 3;
+    }
+    auto points = GenerateQueries(poly, queriesCount, options.seed + 1);
+
+    SegmentIndex plain(poly);
+    CompactSegmentIndex breadthFirst(plain, CompactSegmentIndex::Layout::BreadthFirst);
+    CompactSegmentIndex vanEmdeBoas(plain, CompactSegmentIndex::Layout::VanEmdeBoas);
+    std::vector<Layout> layouts{
+        {"plain_dfs_64B", plain.GetMemoryUsage(), [&](const Point3D& point){
+            return FindNearestPointsToIndexedPolyline(poly, plain, point).size();
+        }},
+        {"compact_bfs_32B", breadthFirst.GetMemoryUsage(), [&](const Point3D& point){
+            return FindNearestPointsToIndexedPolyline(poly, breadthFirst, point).size();
+        }},
+        {"compact_veb_32B", vanEmdeBoas.GetMemoryUsage(), [&](const Point3D& point){
+            return FindNearestPointsToIndexedPolyline(poly, vanEmdeBoas, point).size();
+        }},
+    };
+
+    PerfCounter cacheMisses(llcMissType, llcMissConfig);
+    PerfCounter l1Misses(l1MissType, l1MissConfig);
+    if (!cacheMisses.IsAvailable())
+        std::cerr << "Hardware counters are unavailable, only timings are reported\n";
+
+    std::cout << options.kind << ", " << poly.GetNodesCount() << " nodes, " << points.size() << " queries\n";
+    std::cout << std::left << std::setw(18) << "layout" << std::right << std::setw(12) << "index_MB"
+              << std::setw(12) << "ns/query" << std::setw(16) << "LLC_miss/query" << std::setw(16) << "L1D_miss/query"
+              << "\n";
+
+    size_t checksum = 0;
+    for (const auto& layout : layouts){
+        /// Warm up once, so that every layout starts from the same cache state
+        for (const auto& point : points) checksum += layout.query(point);
+
+        cacheMisses.Start();
+        l1Misses.Start();
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& point : points) checksum += layout.query(point);
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+        auto llc = cacheMisses.Stop();
+        auto l1 = l1Misses.Stop();
+
+        auto perQuery = [&](uint64_t value){ return static_cast<double>(value) / static_cast<double>(points.size()); };
+        std::cout << std::left << std::setw(18) << layout.name << std::right << std::fixed
+                  << std::setw(12) << std::setprecision(2) << static_cast<double>(layout.bytes) / (1024.0 * 1024.0)
+                  << std::setw(12) << std::setprecision(1) << perQuery(static_cast<uint64_t>(elapsed.count()));
+        if (cacheMisses.IsAvailable())
+            std::cout << std::setw(16) << perQuery(llc) << std::setw(16) << perQuery(l1);
+        else
+            std::cout << std::setw(16) << "n/a" << std::setw(16) << "n/a";
+        std::cout << "\n";
+    }
+    /// Keeps the queries from being optimized away
+    std::cout << "results: " << checksum << "\n";
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include "static/GeometryObjects.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/NumaReplicas.h"
+#include "Datasets.h"
+#include <vector>
+
+/// Repetitions of every measurement, the fastest counts.
+static constexpr int repetitions = 3;
+
+/**
+ * @brief Prints the usage of the program.
+ * @param program Name of the executable.
+ */
+static void PrintUsage(const char* program){
+    std::cerr << "Usage: " << program << " [--kind <kind>] [--nodes <count>] [--queries <count>] [--seed <seed>]"
+              << " [--simulate <numa_nodes>]\n";
+}
+
+/**
+ * @brief Times batch queries and counts the results that differ from the expected ones.
+ * @param replicas The replicated polyline.
+ * @param points The query points.
+ * @param expected Results of FindNearestPointsToPolyline.
+ * @param mismatches Incremented for every differing result.
+ * @return Queries per second of the fastest run.
+ */
+static double MeasureQueries(const ReplicatedPolyline3D& replicas, const std::vector<Point3D>& points,
+                             const std::vector<std::vector<std::pair<size_t, Point3D>>>& expected, size_t& mismatches){
+    auto best = std::numeric_limits<double>::max();
+    for (int r = 0; r < repetitions; ++r){
+        auto start = std::chrono::steady_clock::now();
+        auto results = replicas.FindNearestPoints(points);
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+        best = std::min(best, elapsed.count());
+        if (r == 0){
+            for (size_t i = 0; i < points.size(); ++i){
+                if (results[i] != expected[i]) ++mismatches;
+            }
+        }
+    }
+    return best > 0.0 ? static_cast<double>(points.size()) / best : 0.0;
+}
+
+int main(int argc, char* argv[])
+{
+    DatasetOptions options;
+    options.nodesCount = 200000;
+    size_t queriesCount = 2000;
+    size_t simulated = 0;
+
+    try{
+        for (int i = 1; i < argc; ++i){
+            std::string flag = argv[i];
+            if (i + 1 >= argc){
+                PrintUsage(argv[0]);
+                return 1;
+            }
+            std::string value = argv[++i];
+            if (flag == "--kind") options.kind = value;
+            else if (flag == "--nodes") options.nodesCount = std::stoul(value);
+            else if (flag == "--queries") queriesCount = std::stoul(value);
+            else if (flag == "--seed") options.seed = static_cast<unsigned>(std::stoul(value));
+            else if (flag == "--simulate") simulated = std::stoul(value);
+            else{
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        }
+    } catch (const std::exception& e){
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    Polyline3D poly;
+    NumaTopology topology;
+    try{
+        poly = GenerateDataset(options);
+        topology = simulated == 0 ? NumaTopology::Detect() : NumaTopology::Simulate(simulated);
+    } catch (const std::invalid_argument& e){
+        std::cerr << "Invalid argument: " << e.what() << "\n";
+        return 3;
+    }
+    auto points = GenerateQueries(poly, queriesCount, options.seed + 1);
+    std::vector<std::vector<std::pair<size_t, Point3D>>> expected;
+    for (const auto& point : points) expected.push_back(FindNearestPointsToPolyline(poly, point));
+
+    std::cout << options.kind << ", " << poly.GetNodesCount() << " nodes, " << points.size() << " queries, "
+              << topology.nodes.size() << (simulated == 0 ? " NUMA nodes" : " simulated NUMA nodes") << "\n";
+    std::cout << std::setw(6) << "nodes" << std::setw(9) << "threads" << std::setw(15) << "shared q/s"
+              << std::setw(17) << "replicated q/s" << std::setw(10) << "scaling" << std::setw(8) << "ratio" << "\n";
+
+    /// Every row adds a node; the shared copy lives on the first node, as without replication
+    size_t mismatches = 0;
+    double single = 0.0;
+    for (size_t count = 1; count <= topology.nodes.size(); ++count){
+        auto nodes = topology.GetFirstNodes(count);
+        size_t threads = 0;
+        for (const auto& node : nodes.nodes) threads += node.cpus.size();
+
+        ReplicatedPolyline3D shared(poly, nodes, false);
+        ReplicatedPolyline3D replicated(poly, nodes);
+        auto sharedRate = MeasureQueries(shared, points, expected, mismatches);
+        auto replicatedRate = MeasureQueries(replicated, points, expected, mismatches);
+        if (count == 1) single = replicatedRate;
+
+        std::cout << std::setw(6) << count << std::setw(9) << threads << std::fixed << std::setprecision(0)
+                  << std::setw(15) << sharedRate << std::setw(17) << replicatedRate << std::setprecision(2)
+                  << std::setw(9) << (single > 0.0 ? replicatedRate / single : 0.0) << "x"
+                  << std::setw(7) << (sharedRate > 0.0 ? replicatedRate / sharedRate : 0.0) << "x\n";
+    }
+
+    if (mismatches != 0){
+        std::cerr << mismatches << " results differ from FindNearestPointsToPolyline\n";
+        return 5;
+    }
+    return 0;
+}
@@ -0,0 +1,364 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "static/GeometryObjects.h"
+#include "static/3DMathOperations.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/BatchQueries.h"
+#include "static/CompressedPolyline.h"
+#include "static/DistanceField.h"
+#include "static/PlanarPolyline.h"
+#include "static/SegmentIndex.h"
+#include "static/CompactSegmentIndex.h"
+#include "Datasets.h"
+#include <vector>
+
+using Results = std::vector<std::vector<std::pair<size_t, Point3D>>>;
+
+/// Timings in nanoseconds per query, by dataset and engine.
+using Timings = std::map<std::string, std::map<std::string, double>>;
+
+/**
+ * @struct PreparedEngine
+ * @brief A query engine prepared for a polyline.
+ */
+struct PreparedEngine{
+    std::function<Results(const std::vector<Point3D>&)> query; ///< Answers all queries.
+    double tolerance = -1.0; ///< Allowed excess of the nearest distance, negative for exact engines.
+};
+
+/**
+ * @struct Engine
+ * @brief A named way to answer nearest point queries.
+ */
+struct Engine{
+    std::string name;                                          ///< Name used in reports and baselines.
+    std::function<PreparedEngine(const Polyline3D&)> prepare;  ///< Builds the engine for a polyline.
+};
+
+/**
+ * @brief Get the engines checked by the runner.
+ * @return Vector of engines; brute_force must come first, it is the reference.
+ */
+static std::vector<Engine> Engines(){
+    std::vector<Engine> engines;
+    engines.push_back({"brute_force", [](const Polyline3D& poly){
+        return PreparedEngine{[&poly](const std::vector<Point3D>& points){
+            Results results;
+            results.reserve(points.size());
+            for (const auto& point : points) results.push_back(FindNearestPointsToPolyline(poly, point));
+            return results;
+        }};
+    }});
+    engines.push_back({"batch", [](const Polyline3D& poly){
+        return PreparedEngine{[&poly](const std::vector<Point3D>& points){
+            return FindNearestPointsToPolylineBatch(poly, points);
+        }};
+    }});
+    engines.push_back({"compressed", [](const Polyline3D& poly){
+        auto compressed = std::make_shared<CompressedPolyline3D>(poly, 1e-4);
+        return PreparedEngine{[compressed](const std::vector<Point3D>& points){
+            Results results;
+            results.reserve(points.size());
+            for (const auto& point : points)
+                results.push_back(FindNearestPointsToCompressedPolyline(*compressed, point));
+            return results;
+        }, compressed->GetMaxError()};
+    }});
+    engines.push_back({"distance_field", [](const Polyline3D& poly){
+        /// The band reaches every point of the query box of GenerateQueries, so that the grid answers all queries
+        Box3D bounds;
+        for (const auto& node : poly.GetNodes()) bounds.Extend(node);
+        auto bandWidth = std::max(0.5 * DistanceBetweenPoints(bounds.GetMin(), bounds.GetMax()), 1.0);
+        auto field = std::make_shared<DistanceFieldEngine>(poly, bandWidth / 16.0, bandWidth);
+        return PreparedEngine{[field](const std::vector<Point3D>& points){
+            Results results;
+            results.reserve(points.size());
+            for (const auto& point : points) results.push_back(field->FindNearestPoints(point));
+            return results;
+        }, field->GetMaxError()};
+    }});
+    engines.push_back({"planar", [](const Polyline3D& poly){
+        auto planar = std::make_shared<PlanarPolyline3D>(poly);
+        return PreparedEngine{[planar](const std::vector<Point3D>& points){
+            Results results;
+            results.reserve(points.size());
+            for (const auto& point : points) results.push_back(planar->FindNearestPoints(point));
+            return results;
+        }};
+    }});
+    engines.push_back({"segment_index", [](const Polyline3D& poly){
+        auto index = std::make_shared<SegmentIndex>(poly);
+        return PreparedEngine{[&poly, index](const std::vector<Point3D>& points){
+            Results results;
+            results.reserve(points.size());
+            for (const auto& point : points) results.push_back(FindNearestPointsToIndexedPolyline(poly, *index, point));
+            return results;
+        }};
+    }});
+    engines.push_back({"compact_index", [](const Polyline3D& poly){
+        auto index = std::make_shared<CompactSegmentIndex>(SegmentIndex(poly));
+        return PreparedEngine{[&poly, index](const std::vector<Point3D>& points){
+            Results results;
+            results.reserve(points.size());
+            for (const auto& point : points) results.push_back(FindNearestPointsToIndexedPolyline(poly, *index, point));
+            return results;
+        }};
+    }});
+    return engines;
+}
+
+/**
+ * @brief Checks results of an engine against the brute force results.
+ * @param results Results of the engine.
+ * @param expected Results of FindNearestPointsToPolyline.
+ * @param points The query points.
+ * @param tolerance Allowed excess of the nearest distance, negative to require identical results.
+ * @return Number of queries with wrong results.
+ */
+static size_t CountMismatches(const Results& results, const Results& expected,
+                              const std::vector<Point3D>& points, double tolerance){
+    size_t mismatches = 0;
+    for (size_t i = 0; i < points.size(); ++i){
+        if (tolerance < 0.0){
+            auto same = results[i].size() == expected[i].size();
+            for (size_t j = 0; same && j < results[i].size(); ++j){
+                same = results[i][j].first == expected[i][j].first && results[i][j].second == expected[i][j].second;
+            }
+            if (!same) ++mismatches;
+            continue;
+        }
+        if (results[i].empty() != expected[i].empty()){
+            ++mismatches;
+            continue;
+        }
+        if (!expected[i].empty() &&
+            DistanceBetweenPoints(results[i][0].second, points[i]) >
+            DistanceBetweenPoints(expected[i][0].second, points[i]) + tolerance + eps){
+            ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+/**
+ * @brief Reads timings written by WriteTimings.
+ *
+ * Accepts a JSON object of objects of numbers, e.g. {"helix": {"batch": 12.5}}.
+ * @param filename Name of the baseline file.
+ * @return The timings.
+ * @throw std::invalid_argument If the file is malformed.
+ */
+static Timings ReadTimings(const std::string& filename){
+    std::ifstream file(filename);
+    if (!file.is_open())
+        throw std::runtime_error("Error opening file: " + filename);
+    std::stringstream content;
+    content << file.rdbuf();
+    auto text = content.str();
+    size_t pos = 0;
+
+    auto skip = [&]{ while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) ++pos; };
+    auto expect = [&](char c){
+        skip();
+        if (pos >= text.size() || text[pos] != c)
+            throw std::invalid_argument(std::string("Malformed baseline, expected '") + c + "'");
+        ++pos;
+    };
+    auto peek = [&]{ skip(); return pos < text.size() ? text[pos] : '\0'; };
+    auto readString = [&]{
+        expect('"');
+        auto end = text.find('"', pos);
+        if (end == std::string::npos) throw std::invalid_argument("Malformed baseline, unterminated string");
+        auto value = text.substr(pos, end - pos);
+        pos = end + 1;
+        return value;
+    };
+
+    Timings timings;
+    expect('{');
+    while (peek() != '}'){
+        auto dataset = readString();
+        expect(':');
+        expect('{');
+        while (peek() != '}'){
+            auto engine = readString();
+            expect(':');
+            skip();
+            size_t used = 0;
+            timings[dataset][engine] = std::stod(text.substr(pos), &used);
+            pos += used;
+            if (peek() == ',') ++pos;
+        }
+        expect('}');
+        if (peek() == ',') ++pos;
+    }
+    expect('}');
+    return timings;
+}
+
+/**
+ * @brief Writes timings as a JSON object of objects.
+ * @param timings The timings.
+ * @param filename Output file name.
+ * @return True on success.
+ */
+static bool WriteTimings(const Timings& timings, const std::string& filename){
+    std::ofstream file(filename);
+    if (!file.is_open()) return false;
+
+    file << std::fixed << std::setprecision(1) << "{\n";
+    for (auto dataset = timings.begin(); dataset != timings.end(); ++dataset){
+        file << "  \"" << dataset->first << "\": {";
+        for (auto engine = dataset->second.begin(); engine != dataset->second.end(); ++engine){
+            file << (engine == dataset->second.begin() ? "\n" : ",\n")
+                 << "    \"" << engine->first << "\": " << engine->second;
+        }
+        file << "\n  }" << (std::next(dataset) == timings.end() ? "\n" : ",\n");
+    }
+    file << "}\n";
+    return static_cast<bool>(file);
+}
+
+/**
+ * @brief Prints the usage of the program.
+ * @param program Name of the executable.
+ */
+static void PrintUsage(const char* program){
+    std::cerr << "Usage: " << program << " [--baseline <file>] [--output <file>] [--threshold <fraction>]\n"
+              << "       [--nodes <count>] [--queries <count>] [--repetitions <count>] [--update-baseline] [--check-only]\n";
+}
+
+int main(int argc, char* argv[])
+{
+    std::string baselineName;
+    std::string outputName;
+    auto threshold = 0.25;
+    size_t nodesCount = 10000;
+    size_t queriesCount = 200;
+    size_t repetitions = 3;
+    auto updateBaseline = false;
+    auto checkOnly = false;
+
+    try{
+        for (int i = 1; i < argc; ++i){
+            std::string flag = argv[i];
+            auto value = [&]{
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + flag);
+                return std::string(argv[++i]);
+            };
+            if (flag == "--baseline") baselineName = value();
+            else if (flag == "--output") outputName = value();
+            else if (flag == "--threshold") threshold = std::stod(value());
+            else if (flag == "--nodes") nodesCount = std::stoul(value());
+            else if (flag == "--queries") queriesCount = std::stoul(value());
+            else if (flag == "--repetitions") repetitions = std::max<size_t>(1, std::stoul(value()));
+            else if (flag == "--update-baseline") updateBaseline = true;
+            else if (flag == "--check-only") checkOnly = true;
+            else{
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        }
+    } catch (const std::exception& e){
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    std::vector<std::pair<std::string, DatasetOptions>> datasets;
+    for (const auto& kind : DatasetKinds()){
+        DatasetOptions options;
+        options.kind = kind;
+        options.nodesCount = nodesCount;
+        datasets.push_back({kind, options});
+    }
+    DatasetOptions degenerate;
+    degenerate.nodesCount = nodesCount;
+    degenerate.repeatFraction = 0.3;
+    datasets.push_back({"degenerate", degenerate});
+
+    Timings timings;
+    size_t failures = 0;
+    auto engines = Engines();
+
+    std::cout << std::left << std::setw(14) << "dataset" << std::setw(16) << "engine"
+              << std::right << std::setw(14) << "ns/query" << std::setw(12) << "mismatches" << "\n";
+    for (const auto& [datasetName, options] : datasets){
+        auto poly = GenerateDataset(options);
+        auto points = GenerateQueries(poly, queriesCount, options.seed + 1);
+        Results expected;
+
+        for (const auto& engine : engines){
+            auto prepared = engine.prepare(poly);
+            Results results;
+            auto best = std::numeric_limits<double>::max();
+            for (size_t r = 0; r < repetitions; ++r){
+                auto start = std::chrono::steady_clock::now();
+                results = prepared.query(points);
+                auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+                best = std::min(best, elapsed.count() / static_cast<double>(points.size()));
+            }
+            if (expected.empty()) expected = results;
+
+            auto mismatches = CountMismatches(results, expected, points, prepared.tolerance);
+            failures += mismatches;
+            timings[datasetName][engine.name] = best;
+            std::cout << std::left << std::setw(14) << datasetName << std::setw(16) << engine.name
+                      << std::right << std::setw(14) << std::fixed << std::setprecision(1) << best
+                      << std::setw(12) << mismatches << "\n";
+        }
+    }
+
+    if (!outputName.empty() && !WriteTimings(timings, outputName)){
+        std::cerr << "Error opening file: " << outputName;
+        return 2;
+    }
+    if (updateBaseline){
+        if (baselineName.empty() || !WriteTimings(timings, baselineName)){
+            std::cerr << "Error opening file: " << baselineName;
+            return 2;
+        }
+    }
+    else if (!checkOnly && !baselineName.empty()){
+        Timings baseline;
+        try{
+            baseline = ReadTimings(baselineName);
+        } catch (const std::exception& e){
+            std::cerr << e.what() << "\n";
+            return 2;
+        }
+        for (const auto& [datasetName, engineTimings] : timings){
+            for (const auto& [engineName, nanoseconds] : engineTimings){
+                auto dataset = baseline.find(datasetName);
+                if (dataset == baseline.end() || dataset->second.count(engineName) == 0){
+                    std::cout << "No baseline for " << datasetName << "/" << engineName << "\n";
+                    continue;
+                }
+                auto reference = dataset->second.at(engineName);
+                if (nanoseconds > reference * (1.0 + threshold)){
+                    std::cout << "Slowdown in " << datasetName << "/" << engineName << ": " << nanoseconds
+                              << " ns/query, baseline " << reference << " ns/query\n";
+                    ++failures;
+                }
+            }
+        }
+    }
+
+    if (failures != 0){
+        std::cout << "FAILED: " << failures << " mismatches or slowdowns\n";
+        return 5;
+    }
+    std::cout << "OK\n";
+    return 0;
+}
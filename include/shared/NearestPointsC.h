@@ -0,0 +1,151 @@
+#pragma once
+
+/**
+ * @file NearestPointsC.h
+ * @brief C interface of the shared NearestPoints library.
+ *
+ * A polyline is prepared once from a coordinate array: its nodes are copied and a segment index
+ * is built. Queries then read query points straight from the caller's arrays and write into
+ * caller-owned buffers, so no objects are marshalled per call. No function throws; failures are
+ * reported by the returned status and leave the outputs unspecified.
+ *
+ * Coordinate arrays hold x, y, z as consecutive doubles per point. The stride is the distance in
+ * bytes between two points, 0 for tightly packed points, and must be a multiple of sizeof(double),
+ * so that points can be taken from arrays of larger records. A prepared polyline is immutable and
+ * may be queried from several threads at once.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#  ifdef NEARESTPOINTS_C_BUILD
+#    define NP_API __declspec(dllexport)
+#  else
+#    define NP_API __declspec(dllimport)
+#  endif
+#else
+#  define NP_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Version of the interface, increased on every incompatible change.
+#define NP_ABI_VERSION 1
+
+/// Result of every function.
+typedef enum np_status{
+    NP_OK = 0,                        ///< Success.
+    NP_ERROR_INVALID_ARGUMENT = 1,    ///< A null pointer, a bad stride or a negative distance.
+    NP_ERROR_BUFFER_TOO_SMALL = 2,    ///< The output buffer cannot hold all results.
+    NP_ERROR_OUT_OF_MEMORY = 3,       ///< An allocation failed.
+    NP_ERROR_INTERNAL = 4             ///< Any other failure.
+} np_status;
+
+/// A prepared polyline.
+typedef struct np_polyline np_polyline;
+
+/**
+ * @brief Get the version of the interface implemented by the library.
+ * @return NP_ABI_VERSION of the library build.
+ */
+NP_API int np_abi_version(void);
+
+/**
+ * @brief Get a description of a status.
+ * @param status The status.
+ * @return Static string.
+ */
+NP_API const char* np_status_message(np_status status);
+
+/**
+ * @brief Prepares a polyline for queries.
+ * @param coords Coordinates of the nodes, may be null if count is 0.
+ * @param count Number of nodes.
+ * @param stride Bytes between nodes, 0 for packed nodes.
+ * @param polyline Output: the prepared polyline, to be released with np_polyline_destroy.
+ * @return Status.
+ */
+NP_API np_status np_polyline_create(const double* coords, size_t count, size_t stride, np_polyline** polyline);
+
+/**
+ * @brief Releases a prepared polyline.
+ * @param polyline The polyline, may be null.
+ */
+NP_API void np_polyline_destroy(np_polyline* polyline);
+
+/**
+ * @brief Get the number of nodes of a prepared polyline.
+ * @param polyline The polyline.
+ * @param count Output: number of nodes.
+ * @return Status.
+ */
+NP_API np_status np_polyline_nodes_count(const np_polyline* polyline, size_t* count);
+
+/**
+ * @brief Finds the nearest point of a polyline for every query point.
+ *
+ * When several points are equally near, the one on the lowest segment is written, as the first
+ * element of the result of FindNearestPointsToPolyline. Any output pointer may be null if that
+ * output is not needed. A polyline without segments gives segment SIZE_MAX, NaN coordinates and
+ * an infinite distance.
+ *
+ * @param polyline The polyline.
+ * @param points Coordinates of the query points.
+ * @param count Number of query points.
+ * @param stride Bytes between query points, 0 for packed points.
+ * @param threads Number of threads, 0 for the hardware concurrency.
+ * @param segments Output: count segment indices.
+ * @param nearest Output: 3 * count packed coordinates of the nearest points.
+ * @param distances Output: count distances.
+ * @return Status.
+ */
+NP_API np_status np_nearest_points(const np_polyline* polyline, const double* points, size_t count, size_t stride,
+                                   size_t threads, size_t* segments, double* nearest, double* distances);
+
+/**
+ * @brief Finds all nearest points of a polyline for one query point.
+ *
+ * @param polyline The polyline.
+ * @param point Coordinates of the query point.
+ * @param capacity Number of results the buffers can hold.
+ * @param segments Output: segment indices in ascending order, may be null.
+ * @param nearest Output: 3 * capacity packed coordinates of the nearest points, may be null.
+ * @param found Output: number of nearest points, set also when the buffers are too small.
+ * @return Status, NP_ERROR_BUFFER_TOO_SMALL if found exceeds capacity.
+ */
+NP_API np_status np_nearest_points_all(const np_polyline* polyline, const double* point, size_t capacity,
+                                       size_t* segments, double* nearest, size_t* found);
+
+/**
+ * @brief Finds the distance from every query point to a polyline without computing the nearest points.
+ * @param polyline The polyline.
+ * @param points Coordinates of the query points.
+ * @param count Number of query points.
+ * @param stride Bytes between query points, 0 for packed points.
+ * @param threads Number of threads, 0 for the hardware concurrency.
+ * @param distances Output: count distances, infinite for a polyline without segments.
+ * @return Status.
+ */
+NP_API np_status np_distances(const np_polyline* polyline, const double* points, size_t count, size_t stride,
+                              size_t threads, double* distances);
+
+/**
+ * @brief Checks for every query point whether the polyline passes within a distance of it.
+ * @param polyline The polyline.
+ * @param points Coordinates of the query points.
+ * @param count Number of query points.
+ * @param stride Bytes between query points, 0 for packed points.
+ * @param maxDistance The distance, inclusive, must not be negative.
+ * @param threads Number of threads, 0 for the hardware concurrency.
+ * @param within Output: count flags, 1 if within the distance, 0 otherwise.
+ * @return Status.
+ */
+NP_API np_status np_within_distance(const np_polyline* polyline, const double* points, size_t count, size_t stride,
+                                    double maxDistance, size_t threads, uint8_t* within);
+
+#ifdef __cplusplus
+}
+#endif
@@ -56,3 +56,22 @@ Vector3D VectorMultipliedByScalar(const Vector3D& vec, double a);
  * @note The projection is on an infinite line through the segment. It may not be on the segment.
  */
 Point3D PointProjectionOnLineThroughSegment(const Point3D& point, const Segment3D& seg);
+
+/**
+ * @brief Calculates the distance from a point to an axis-aligned box.
+ * 
+ * @param point The point.
+ * @param box The box.
+ * @return Distance to the nearest point of the box, 0 if the point is inside.
+ * @note Used as a lower bound of the distance to anything contained in the box.
+ */
+double DistanceFromPointToBox(const Point3D& point, const Box3D& box);
+
+/**
+ * @brief Calculates the vector product of two vectors in 3D space.
+ * 
+ * @param vector1 First vector.
+ * @param vector2 Second vector.
+ * @return The vector product of two vectors.
+ */
+Vector3D VectorProduct(const Vector3D& vector1, const Vector3D& vector2);
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "GeometryObjects.h"
+#include "PlanarPolyline.h"
+#include "SegmentIndex.h"
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+/// Exact query engines the adaptive front end chooses from.
+enum class NearestPointsEngine{
+    BruteForce,                       ///< FindNearestPointsToPolyline for every point.
+    Batch,                            ///< FindNearestPointsToPolylineBatch, packets of nearby points.
+    Planar,                           ///< PlanarPolyline3D, a 2D grid for polylines in an axis plane.
+    SegmentIndex                      ///< FindNearestPointsToIndexedPolyline with a SegmentIndex.
+};
+
+/**
+ * @brief Get the name of an engine.
+ * @param engine The engine.
+ * @return Static string, e.g. "segment_index".
+ */
+const char* EngineName(NearestPointsEngine engine);
+
+/**
+ * @struct EngineCalibration
+ * @brief Measured costs of the engines on this machine, from which the crossovers are derived.
+ *
+ * Costs are in nanoseconds. Index queries are assumed to grow with log2 of the number of
+ * segments and planar queries to be independent of it.
+ */
+struct EngineCalibration{
+    /// Version of the cache file format; files of other versions are measured again.
+    static constexpr int version = 1;
+
+    double bruteForceSegment = 4.0;   ///< Brute force, per segment and query.
+    double batchSegment = 1.5;        ///< Batch engine, per segment and query.
+    double indexBuildSegment = 6.0;   ///< SegmentIndex construction, per segment and log2 of the segments.
+    double indexQueryLevel = 80.0;    ///< SegmentIndex query, per log2 of the number of segments.
+    double planarBuildSegment = 40.0; ///< PlanarPolyline3D construction, per segment.
+    double planarQuery = 400.0;       ///< PlanarPolyline3D query.
+    double threadStart = 30000.0;     ///< Starting and joining one worker thread.
+    size_t threads = 1;               ///< Hardware concurrency the costs were measured with.
+
+    /**
+     * @brief Measures the costs with short runs on synthetic polylines, in the order of 0.1 s.
+     * @return The measured calibration.
+     */
+    static EngineCalibration Measure();
+
+    /**
+     * @brief Reads a calibration from a cache file.
+     * @param filename The file.
+     * @return The calibration, or nothing if the file is missing, invalid, of another version
+     *         or measured with another hardware concurrency.
+     */
+    static std::optional<EngineCalibration> Load(const std::string& filename);
+
+    /**
+     * @brief Writes the calibration to a cache file, creating its directory.
+     * @param filename The file.
+     * @return True on success.
+     */
+    bool Save(const std::string& filename) const;
+
+    /**
+     * @brief Get the default cache file.
+     *
+     * NEARESTPOINTS_CALIBRATION if set, otherwise nearest_points/calibration.txt in
+     * XDG_CACHE_HOME or in ~/.cache.
+     *
+     * @return File name, empty if no location is known.
+     */
+    static std::string DefaultCacheFile();
+
+    /**
+     * @brief Get the calibration of this machine, loaded from the default cache file or measured
+     *        and stored there on first use. Thread-safe; measured at most once per process.
+     * @return The calibration.
+     */
+    static const EngineCalibration& Get();
+};
+
+/**
+ * @struct EngineChoice
+ * @brief An engine with the number of threads to run it on.
+ */
+struct EngineChoice{
+    NearestPointsEngine engine = NearestPointsEngine::BruteForce;
+    size_t threads = 1;               ///< Threads the query points are split between.
+    double estimatedNanoseconds = 0.0; ///< Predicted time including the preparation.
+};
+
+/**
+ * @struct EngineWorkload
+ * @brief What the choice of an engine depends on.
+ */
+struct EngineWorkload{
+    size_t segments = 0;              ///< Number of segments of the polyline.
+    bool axisPlanar = false;          ///< True if the bounding box is flat along an axis.
+    size_t queries = 0;               ///< Number of query points.
+    bool indexBuilt = false;          ///< The SegmentIndex exists already.
+    bool planarBuilt = false;         ///< The PlanarPolyline3D exists already.
+};
+
+/**
+ * @brief Chooses the fastest engine for a workload according to a calibration.
+ * @param calibration Costs of the engines.
+ * @param workload The workload.
+ * @return The engine with the lowest predicted time.
+ */
+EngineChoice SelectEngine(const EngineCalibration& calibration, const EngineWorkload& workload);
+
+/**
+ * @class AdaptiveNearestPoints
+ * @brief Front end of FindNearestPointsToPolyline that picks the engine per polyline and per batch.
+ *
+ * The choice depends on the number of segments, on whether the bounding box is flat and on
+ * the number of query points. Indexes are built when a batch is large enough to pay for them
+ * and are reused by later batches. All engines return the results of FindNearestPointsToPolyline.
+ */
+class AdaptiveNearestPoints{
+    Polyline3D poly;                  ///< Copy of the polyline.
+    EngineCalibration calibration;    ///< Costs used for the choices.
+    bool axisPlanar = false;          ///< True if the bounding box is flat along an axis.
+    std::unique_ptr<SegmentIndex> index; ///< Built on first use.
+    std::unique_ptr<PlanarPolyline3D> planar; ///< Built on first use.
+    EngineChoice lastChoice;          ///< Choice of the last query.
+
+    /// Builds the engine of a choice if needed.
+    void Prepare(NearestPointsEngine engine);
+
+    /// Answers points [first, last) with a prepared engine.
+    void Query(NearestPointsEngine engine, const std::vector<Point3D>& points, size_t first, size_t last,
+               std::vector<std::vector<std::pair<size_t, Point3D>>>& results) const;
+
+public:
+    /**
+     * @brief Prepares a polyline for adaptive queries.
+     * @param _poly The 3D polyline.
+     * @param _calibration Costs of the engines, by default those of this machine.
+     */
+    explicit AdaptiveNearestPoints(Polyline3D _poly, const EngineCalibration& _calibration = EngineCalibration::Get());
+
+    /**
+     * @brief Finds the points on the polyline closest to a given point.
+     * @param point The query point.
+     * @return The result of FindNearestPointsToPolyline.
+     */
+    std::vector<std::pair<size_t, Point3D>> FindNearestPoints(const Point3D& point);
+
+    /**
+     * @brief Finds the points on the polyline closest to every point of a batch.
+     * @param points The query points.
+     * @return The result of FindNearestPointsToPolyline for every point, in the input order.
+     */
+    std::vector<std::vector<std::pair<size_t, Point3D>>> FindNearestPoints(const std::vector<Point3D>& points);
+
+    /**
+     * @brief Get the engine used by the last query, for diagnostics.
+     * @return The choice.
+     */
+    const EngineChoice& GetLastChoice() const {return lastChoice;}
+
+    /**
+     * @brief Get the number of bytes used by the copy of the polyline and the engines built so far.
+     * @return Memory usage in bytes.
+     */
+    size_t GetMemoryUsage() const;
+};
@@ -0,0 +1,222 @@
+#pragma once
+
+#include "GeometryObjects.h"
+#include "SegmentIndex.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L && __has_include(<coroutine>)
+#include <coroutine>
+#define NEARESTPOINTS_HAS_COROUTINES 1
+#endif
+
+/// Outcome of an asynchronous query.
+enum class AsyncQueryStatus{
+    Completed,                        ///< The nearest points were found.
+    Cancelled,                        ///< Cancel was called, or the executor was destroyed, before the query started.
+    DeadlineExceeded,                 ///< The deadline passed before the query started.
+    Failed                            ///< The query threw, e.g. std::bad_alloc; the exception is in error.
+};
+
+/**
+ * @struct AsyncQueryResult
+ * @brief Result of an asynchronous query.
+ */
+struct AsyncQueryResult{
+    AsyncQueryStatus status = AsyncQueryStatus::Cancelled;
+    std::vector<std::pair<size_t, Point3D>> points; ///< Result of FindNearestPointsToPolyline, empty unless completed.
+    std::exception_ptr error;         ///< Exception thrown by a failed query.
+};
+
+/**
+ * @struct AsyncQueryOptions
+ * @brief Settings of the executor of AsyncNearestPoints.
+ */
+struct AsyncQueryOptions{
+    size_t threads = 1;               ///< Worker threads, 0 for the hardware concurrency.
+    size_t maxBatch = 64;             ///< Most queries a worker takes from the queue at once.
+    std::chrono::microseconds batchDelay{50}; ///< How long a worker waits for a batch to fill up.
+};
+
+/**
+ * @class AsyncQuery
+ * @brief Handle of a submitted query: a future, a completion callback and, in C++20, an awaitable.
+ *
+ * Copies refer to the same query. In C++20 `co_await query` suspends the coroutine until the
+ * result is there; the coroutine is resumed on the worker thread that answered the query, so an
+ * event loop should post its continuation back to its own thread.
+ */
+class AsyncQuery{
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    /// Shared between the handle and the executor.
+    struct State{
+        Point3D point;
+        Clock::time_point deadline;
+        std::atomic<bool> claimed{false};   ///< Set by whoever answers the query first, a worker or Cancel.
+        std::promise<AsyncQueryResult> promise;
+        std::shared_future<AsyncQueryResult> future;
+        std::mutex mutex;
+        bool done = false;
+        std::vector<std::function<void()>> continuations; ///< Callbacks and awaiting coroutines, called once the result is set.
+
+        State(const Point3D& _point, Clock::time_point _deadline);
+
+        /// Sets the result and runs the continuations in registration order; only the claimer may call it.
+        void Complete(AsyncQueryResult result);
+    };
+
+    std::shared_ptr<State> state;
+
+    friend class AsyncNearestPoints;
+    explicit AsyncQuery(std::shared_ptr<State> _state) : state(std::move(_state)) {}
+
+public:
+    /**
+     * @brief Cancels the query unless it has started. The result is then Cancelled at once.
+     * @return True if the query was cancelled, false if it had started or finished.
+     */
+    bool Cancel();
+
+    /**
+     * @brief Checks whether the result is available, without blocking.
+     * @return True if the query has finished.
+     */
+    bool IsReady() const;
+
+    /**
+     * @brief Get the future of the result, for C++17 callers.
+     * @return Shared future, valid as long as needed.
+     */
+    const std::shared_future<AsyncQueryResult>& GetFuture() const {return state->future;}
+
+    /**
+     * @brief Waits for the result.
+     * @return The result.
+     */
+    const AsyncQueryResult& Get() const {return state->future.get();}
+
+    /**
+     * @brief Registers a function called once the result is available.
+     *
+     * Every registered function is called, in registration order, together with coroutines
+     * awaiting the query. The function runs on the worker thread that answers the query, or at
+     * once on the calling thread if the result is already there. It must not throw.
+     *
+     * @param callback Function receiving the result.
+     */
+    void OnComplete(std::function<void(const AsyncQueryResult&)> callback);
+
+#ifdef NEARESTPOINTS_HAS_COROUTINES
+    bool await_ready() const {return IsReady();}
+
+    bool await_suspend(std::coroutine_handle<> handle){
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->done)
+            return false;
+        state->continuations.push_back([handle]{ handle.resume(); });
+        return true;
+    }
+
+    AsyncQueryResult await_resume() const {return Get();}
+#endif
+};
+
+/**
+ * @class AsyncNearestPoints
+ * @brief Answers nearest point queries on an executor so that callers, e.g. an event loop, do not block.
+ *
+ * Submit returns immediately with a handle. Worker threads take queries from a queue in batches:
+ * a worker woken by a submission waits up to batchDelay for further ones, then answers up to
+ * maxBatch queries under a single lock, so bursts of submissions share the wakeups.
+ * Queries are answered with a SegmentIndex built when the executor is created, in O(log n)
+ * each. A query whose deadline has passed or that was cancelled when a worker takes it is
+ * abandoned without being answered. Deadlines are only checked when a worker takes the query:
+ * while every worker is busy, a query past its deadline stays pending until one is free, so a
+ * caller that needs the result in time should also wait on the future with a timeout.
+ */
+class AsyncNearestPoints{
+public:
+    using Clock = AsyncQuery::Clock;
+
+private:
+    Polyline3D poly;                  ///< Copy of the polyline.
+    SegmentIndex index;               ///< Index of poly.
+    AsyncQueryOptions options;
+    mutable std::mutex mutex;         ///< Guards queue and stopping.
+    std::condition_variable wakeup;   ///< Signals submissions and stopping.
+    std::deque<std::shared_ptr<AsyncQuery::State>> queue; ///< Submitted queries, oldest first.
+    bool stopping = false;
+    std::atomic<size_t> batches{0};   ///< Number of batches taken from the queue.
+    std::vector<std::thread> workers;
+
+    /// Takes batches from the queue until the executor stops.
+    void Work();
+
+    /// Answers a query unless it is cancelled or late; an exception fails the query instead of the worker.
+    void Run(AsyncQuery::State& state) const;
+
+public:
+    /**
+     * @brief Indexes a polyline and starts the workers.
+     * @param _poly The 3D polyline.
+     * @param _options Settings of the executor.
+     * @throw std::invalid_argument If maxBatch is 0.
+     */
+    explicit AsyncNearestPoints(Polyline3D _poly, const AsyncQueryOptions& _options = AsyncQueryOptions());
+
+    AsyncNearestPoints(const AsyncNearestPoints&) = delete;
+    AsyncNearestPoints& operator=(const AsyncNearestPoints&) = delete;
+
+    /// Destructor. Queries not started yet are completed as Cancelled.
+    ~AsyncNearestPoints();
+
+    /**
+     * @brief Submits a query.
+     * @param point The query point.
+     * @param deadline The query is abandoned if it has not started by then, which is noticed
+     *                 when a worker takes it from the queue.
+     * @return Handle of the query.
+     */
+    AsyncQuery Submit(const Point3D& point, Clock::time_point deadline = Clock::time_point::max());
+
+    /**
+     * @brief Submits a query with a time budget.
+     * @param point The query point.
+     * @param budget Time from now after which the query is abandoned if it has not started.
+     * @return Handle of the query.
+     */
+    AsyncQuery Submit(const Point3D& point, Clock::duration budget);
+
+    /**
+     * @brief Submits several queries with a single lock and wakeup.
+     * @param points The query points.
+     * @param deadline Deadline of every query.
+     * @return Handles in the order of the points.
+     */
+    std::vector<AsyncQuery> SubmitBatch(const std::vector<Point3D>& points,
+                                        Clock::time_point deadline = Clock::time_point::max());
+
+    /**
+     * @brief Get the number of batches the workers took from the queue, for diagnostics.
+     * @return Number of batches.
+     */
+    size_t GetBatchesCount() const {return batches.load();}
+
+    /**
+     * @brief Get the number of bytes used by the polyline, the index and the waiting queries.
+     * @return Memory usage in bytes.
+     */
+    size_t GetMemoryUsage() const;
+};
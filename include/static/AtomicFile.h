@@ -0,0 +1,24 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+/**
+ * @brief Get the name of a temporary file next to a file, unique to the calling process and thread.
+ * @param filename The file the temporary one will replace.
+ * @return Name of the temporary file.
+ */
+std::string TemporaryFileName(const std::string& filename);
+
+/**
+ * @brief Replaces a file atomically: the content is written to a temporary file next to it, which
+ * is then renamed over it, so that other processes never read a partial file.
+ *
+ * Processes and threads replacing the same file at once each write their own temporary file;
+ * the last rename wins.
+ *
+ * @param filename The file to replace.
+ * @param write Writes the content to the file named by its argument and returns false on failure.
+ * @return True if the file was replaced. Otherwise the temporary file is removed and the file is unchanged.
+ */
+bool ReplaceFileAtomically(const std::string& filename, const std::function<bool(const std::string&)>& write);
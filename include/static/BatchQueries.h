@@ -0,0 +1,37 @@
+#pragma once
+
+#include "GeometryObjects.h"
+#include <cstdint>
+#include <vector>
+
+/// Number of query points processed together against each loaded segment.
+constexpr size_t batchPacketSize = 8;
+
+/// Number of consecutive segments sharing a bounding box in batch queries.
+constexpr size_t batchChunkSize = 32;
+
+/**
+ * @brief Interleaves the bits of three coordinates into a Z-order (Morton) code.
+ *
+ * @param x Quantized X coordinate, only the lower 21 bits are used.
+ * @param y Quantized Y coordinate, only the lower 21 bits are used.
+ * @param z Quantized Z coordinate, only the lower 21 bits are used.
+ * @return The 63-bit Morton code.
+ */
+uint64_t MortonCode(uint32_t x, uint32_t y, uint32_t z);
+
+/**
+ * @brief Finds the nearest points on a polyline for many query points at once.
+ *
+ * The query points are sorted along a Z-order curve and processed in packets of batchPacketSize
+ * spatially close points. The segments are grouped into chunks of batchChunkSize with a bounding
+ * box; a chunk is skipped if it is farther than the nearest distance found so far for every point
+ * of the packet, otherwise each of its segments is loaded once and tested against all points of
+ * the packet that still need it. The results are scattered back to the order of the input.
+ *
+ * @param poly The 3D polyline.
+ * @param points The query points.
+ * @return For every query point, the same vector as FindNearestPointsToPolyline(poly, point) returns.
+ */
+std::vector<std::vector<std::pair<size_t, Point3D>>> FindNearestPointsToPolylineBatch(const Polyline3D& poly,
+                                                                                     const std::vector<Point3D>& points);
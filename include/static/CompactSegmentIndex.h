@@ -0,0 +1,150 @@
+#pragma once
+
+#include "GeometryObjects.h"
+#include "SegmentIndex.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @struct CompactSegmentIndexNode
+ * @brief Inner node of a CompactSegmentIndex with the bounds of both children quantized to 16 bits.
+ *
+ * Child bounds are stored relative to the bounds of the node itself, which are decoded from its
+ * parent while descending. Minima are rounded down and maxima up, so the decoded bounds always
+ * contain the segments.
+ */
+struct CompactSegmentIndexNode{
+    uint16_t childMin[2][3];          ///< Quantized minimum corners of the children.
+    uint16_t childMax[2][3];          ///< Quantized maximum corners of the children.
+    uint32_t child[2];                ///< Node index of each child, or leafFlag | leaf index for a leaf.
+};
+
+static_assert(sizeof(CompactSegmentIndexNode) == 32, "CompactSegmentIndexNode must fill half a cache line");
+
+/**
+ * @class CompactSegmentIndex
+ * @brief The hierarchy of a SegmentIndex in 32-byte nodes laid out for few cache misses.
+ *
+ * Only inner nodes are stored; a leaf is a range of segments given by its first segment, since the
+ * leaves cover consecutive ranges. In van Emde Boas order the tree is split at half its height,
+ * the top half is stored first and every bottom subtree after it, recursively, so any path from
+ * the root touches O(log_B n) cache lines for every cache line size B. Breadth-first order is
+ * provided for comparison.
+ */
+class CompactSegmentIndex{
+public:
+    /// Marks references to leaves in CompactSegmentIndexNode::child.
+    static constexpr uint32_t leafFlag = 0x80000000u;
+
+    /// Order of the nodes in memory.
+    enum class Layout{
+        BreadthFirst,                 ///< Level after level.
+        VanEmdeBoas                   ///< Recursive split at half the height.
+    };
+
+private:
+    std::vector<CompactSegmentIndexNode> nodes; ///< Inner nodes, the root first.
+    std::vector<uint32_t> leafFirst;  ///< First segment of every leaf, followed by the number of segments.
+    uint32_t root = 0;                ///< Reference to the root, a leaf for small polylines.
+    std::array<double, 3> rootMin{};  ///< Minimum corner of the root bounds.
+    std::array<double, 3> rootMax{};  ///< Maximum corner of the root bounds.
+    size_t polylineNodes = 0;         ///< Number of nodes of the indexed polyline.
+    Layout layout = Layout::VanEmdeBoas; ///< Order of the nodes.
+
+public:
+    /// Default constructor. Initializes an index of an empty polyline.
+    CompactSegmentIndex();
+
+    /**
+     * @brief Converts a segment index into the compact format.
+     * @param index The index to convert.
+     * @param _layout Order of the nodes in memory.
+     */
+    explicit CompactSegmentIndex(const SegmentIndex& index, Layout _layout = Layout::VanEmdeBoas);
+
+    /**
+     * @brief Decodes the bounds of a child from the bounds of its parent.
+     * @param node The parent.
+     * @param side 0 for the left child, 1 for the right child.
+     * @param parentMin Minimum corner of the parent bounds.
+     * @param parentMax Maximum corner of the parent bounds.
+     * @param childMin Output: minimum corner of the child bounds.
+     * @param childMax Output: maximum corner of the child bounds.
+     */
+    static void DecodeChild(const CompactSegmentIndexNode& node, int side, const std::array<double, 3>& parentMin,
+                            const std::array<double, 3>& parentMax, std::array<double, 3>& childMin,
+                            std::array<double, 3>& childMax);
+
+    /**
+     * @brief Get the inner nodes.
+     * @return Vector of nodes, the root first.
+     */
+    const std::vector<CompactSegmentIndexNode>& GetNodes() const {return nodes;}
+
+    /**
+     * @brief Get the range of segments of a leaf.
+     * @param leaf Index of the leaf.
+     * @return Pair of the first segment and the number of segments.
+     */
+    std::pair<size_t, size_t> GetLeafRange(uint32_t leaf) const {
+        return {leafFirst[leaf], leafFirst[leaf + 1] - leafFirst[leaf]};
+    }
+
+    /**
+     * @brief Get the reference to the root.
+     * @return Index of the root node, or leafFlag | 0 if the whole polyline is one leaf.
+     */
+    uint32_t GetRoot() const {return root;}
+
+    /**
+     * @brief Get the minimum corner of the bounds of all segments.
+     * @return The corner.
+     */
+    const std::array<double, 3>& GetRootMin() const {return rootMin;}
+
+    /**
+     * @brief Get the maximum corner of the bounds of all segments.
+     * @return The corner.
+     */
+    const std::array<double, 3>& GetRootMax() const {return rootMax;}
+
+    /**
+     * @brief Get the number of leaves.
+     * @return Number of leaves, 0 for a polyline without segments.
+     */
+    size_t GetLeavesCount() const {return leafFirst.empty() ? 0 : leafFirst.size() - 1;}
+
+    /**
+     * @brief Get the number of nodes of the indexed polyline.
+     * @return Number of polyline nodes.
+     */
+    size_t GetPolylineNodesCount() const {return polylineNodes;}
+
+    /**
+     * @brief Get the order of the nodes.
+     * @return The layout.
+     */
+    Layout GetLayout() const {return layout;}
+
+    /**
+     * @brief Get the number of bytes used by the index.
+     * @return Memory usage in bytes.
+     */
+    size_t GetMemoryUsage() const;
+};
+
+/**
+ * @brief Finds the points on a 3D polyline closest to a given point using its compact index.
+ *
+ * The result is the same as returned by FindNearestPointsToPolyline.
+ *
+ * @param poly The 3D polyline.
+ * @param index The compact index built for poly.
+ * @param point The point for which the nearest points on the polyline are being found.
+ * @return A vector of pairs of segment index and nearest point, sorted by segment index.
+ * @throw std::invalid_argument If the index belongs to a polyline with another number of nodes.
+ */
+std::vector<std::pair<size_t, Point3D>> FindNearestPointsToIndexedPolyline(const Polyline3D& poly,
+                                                                           const CompactSegmentIndex& index,
+                                                                           const Point3D& point);
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "GeometryObjects.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class CompressedPolyline3D
+ * @brief Compact read-only representation of a polyline.
+ *
+ * The coordinates are quantized to a grid with a given resolution whose origin is the minimum
+ * corner of the polyline bounding box. The quantized nodes are split into blocks of segments.
+ * Each block stores its first node and its bounding box uncompressed, followed by zigzag varint
+ * deltas of the remaining nodes, so every block can be decoded independently and skipped
+ * by queries without decoding.
+ * @note The last node of a block is repeated as the first node of the next block.
+ */
+class CompressedPolyline3D{
+public:
+    /// Default number of segments in a block.
+    static constexpr size_t defaultBlockSize = 64;
+
+private:
+    /**
+     * @struct Block
+     * @brief Header of an independently decodable block of nodes.
+     */
+    struct Block{
+        size_t firstNode;          ///< Index of the first node of the block.
+        size_t byteOffset;         ///< Offset of the encoded deltas in the byte stream.
+        uint32_t nodesCount;       ///< Number of nodes in the block, including the first one.
+        int32_t first[3];          ///< Quantized coordinates of the first node.
+        int32_t boxMin[3];         ///< Quantized minimum corner of the block bounding box.
+        int32_t boxMax[3];         ///< Quantized maximum corner of the block bounding box.
+    };
+
+    Point3D origin;                ///< World position of the quantized coordinate (0, 0, 0).
+    double resolution = 0.0;       ///< Size of a grid cell.
+    size_t nodesCount = 0;         ///< Number of nodes of the source polyline.
+    size_t blockSize = defaultBlockSize; ///< Number of segments in a block.
+    std::vector<Block> blocks;     ///< Block headers.
+    std::vector<uint8_t> bytes;    ///< Encoded deltas of all blocks.
+
+    /// Converts quantized coordinates to a point.
+    Point3D Dequantize(const int32_t* coords) const;
+
+public:
+    /// Default constructor. Initializes an empty polyline.
+    CompressedPolyline3D();
+
+    /**
+     * @brief Compresses a polyline.
+     * @param poly Source polyline.
+     * @param resolution Size of the quantization grid cell, must be positive.
+     * @param blockSize Number of segments in a block, must be positive.
+     * @throw std::invalid_argument If the parameters are invalid or the polyline is too large for the resolution.
+     */
+    CompressedPolyline3D(const Polyline3D& poly, double resolution, size_t blockSize = defaultBlockSize);
+
+    /**
+     * @brief Get the number of nodes in the polyline.
+     * @return Number of nodes.
+     */
+    size_t GetNodesCount() const {return nodesCount;}
+
+    /**
+     * @brief Get the number of blocks.
+     * @return Number of blocks.
+     */
+    size_t GetBlocksCount() const {return blocks.size();}
+
+    /**
+     * @brief Get the quantization resolution.
+     * @return Size of a grid cell.
+     */
+    double GetResolution() const {return resolution;}
+
+    /**
+     * @brief Get the maximum distance between a source node and its decoded position.
+     *
+     * Distances from any point to the decoded polyline differ from the distances to the source
+     * polyline by no more than this value.
+     * @return The error bound.
+     */
+    double GetMaxError() const;
+
+    /**
+     * @brief Get the index of the first node of a block.
+     * @param block Index of the block.
+     * @return Index of the first node; the first segment of the block has the same index.
+     */
+    size_t GetBlockFirstNode(size_t block) const {return blocks[block].firstNode;}
+
+    /**
+     * @brief Get the bounding box of the decoded nodes of a block.
+     * @param block Index of the block.
+     * @return Bounding box of the block.
+     */
+    Box3D GetBlockBounds(size_t block) const;
+
+    /**
+     * @brief Decodes the nodes of a single block.
+     * @param block Index of the block.
+     * @param nodes Output vector, its content is replaced with the decoded nodes.
+     */
+    void DecodeBlock(size_t block, std::vector<Point3D>& nodes) const;
+
+    /**
+     * @brief Decodes the whole polyline.
+     * @return The polyline with decoded (quantized) nodes.
+     */
+    Polyline3D Decompress() const;
+
+    /**
+     * @brief Get the number of bytes used by the compressed representation.
+     * @return Memory usage in bytes.
+     */
+    size_t GetMemoryUsage() const;
+
+    /**
+     * @brief Get the number of bytes the nodes take in a Polyline3D.
+     * @return Uncompressed size in bytes.
+     */
+    size_t GetUncompressedSize() const {return nodesCount * sizeof(Point3D);}
+};
+
+/**
+ * @brief Finds the points on a compressed polyline that are closest to a given point.
+ *
+ * Blocks are visited in the order of the distance to their bounding boxes, and blocks that
+ * are farther than the nearest distance found so far are not decoded. The result is the same as
+ * FindNearestPointsToPolyline for the decompressed polyline, and distances differ from those to
+ * the source polyline by at most GetMaxError().
+ *
+ * @param poly The compressed polyline.
+ * @param point The point for which the nearest points on the polyline are being found.
+ * @return A vector of pairs of segment index and nearest point, sorted by segment index.
+ */
+std::vector<std::pair<size_t, Point3D>> FindNearestPointsToCompressedPolyline(const CompressedPolyline3D& poly,
+                                                                              const Point3D& point);
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "GeometryObjects.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/**
+ * @class ConcurrentPolyline3D
+ * @brief Holder of a polyline that is queried from many threads while it is being edited.
+ *
+ * Every edit creates a new immutable version of the polyline that is published atomically.
+ * Readers take a snapshot of the current version without locks and never wait for writers;
+ * the snapshot stays valid and unchanged until it is released, whatever is published meanwhile.
+ * Writers are serialized among themselves.
+ *
+ * Replaced versions are reclaimed with epochs: a reader announces the global epoch in a slot
+ * before it loads the version, and a writer advances the epoch after publishing. A replaced
+ * version is freed once every announced epoch is newer than the epoch it was replaced in.
+ * At most maxReaders snapshots are held at a time; further readers spin until a slot is free.
+ */
+class ConcurrentPolyline3D{
+public:
+    /// Number of snapshots that can be held at the same time.
+    static constexpr size_t maxReaders = 128;
+
+private:
+    /// Epoch announced by a reader, 0 if the slot is free; one cache line per slot.
+    struct alignas(64) ReaderSlot{
+        std::atomic<uint64_t> epoch{0};
+    };
+
+    /// Published version of the polyline.
+    struct Version{
+        Polyline3D poly;
+        uint64_t number;
+    };
+
+    std::atomic<const Version*> current;       ///< Version handed to new readers.
+    std::atomic<uint64_t> globalEpoch{1};      ///< Advanced after every publication.
+    ReaderSlot slots[maxReaders];              ///< Epochs of the active readers.
+    std::mutex writerMutex;                    ///< Serializes writers.
+    std::vector<std::pair<uint64_t, std::unique_ptr<const Version>>> retired; ///< Replaced versions and their epochs.
+    uint64_t versionsCount = 0;                ///< Number of published versions.
+
+    /// Frees the retired versions no reader can see anymore; the writer mutex must be held.
+    void ReclaimLocked();
+
+    /// Publishes a version; the writer mutex must be held.
+    void PublishLocked(Polyline3D&& poly);
+
+public:
+    /**
+     * @class Snapshot
+     * @brief A consistent read-only view of one version of the polyline.
+     *
+     * Holds a reader slot until it is destroyed, so it should not be kept longer than needed,
+     * otherwise the versions replaced meanwhile cannot be freed.
+     */
+    class Snapshot{
+        ConcurrentPolyline3D* owner = nullptr;
+        size_t slot = 0;
+        const Version* version = nullptr;
+
+        friend class ConcurrentPolyline3D;
+        Snapshot(ConcurrentPolyline3D* _owner, size_t _slot, const Version* _version);
+
+    public:
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+        Snapshot(Snapshot&& other) noexcept;
+        Snapshot& operator=(Snapshot&& other) noexcept;
+        ~Snapshot();
+
+        /**
+         * @brief Get the polyline of the snapshot.
+         * @return Reference valid while the snapshot exists.
+         */
+        const Polyline3D& Get() const {return version->poly;}
+        const Polyline3D& operator*() const {return version->poly;}
+        const Polyline3D* operator->() const {return &version->poly;}
+
+        /**
+         * @brief Get the number of the version, counted from 1 by publications.
+         * @return Version number.
+         */
+        uint64_t GetVersion() const {return version->number;}
+    };
+
+    /**
+     * @brief Constructs a holder of a polyline.
+     * @param poly The initial version.
+     */
+    explicit ConcurrentPolyline3D(Polyline3D poly = Polyline3D());
+
+    ConcurrentPolyline3D(const ConcurrentPolyline3D&) = delete;
+    ConcurrentPolyline3D& operator=(const ConcurrentPolyline3D&) = delete;
+
+    /// Destructor. No snapshots may be held anymore.
+    ~ConcurrentPolyline3D();
+
+    /**
+     * @brief Takes a snapshot of the current version without locking.
+     * @return The snapshot.
+     */
+    Snapshot Read();
+
+    /**
+     * @brief Replaces the polyline by a new version.
+     * @param poly The new version.
+     */
+    void Publish(Polyline3D poly);
+
+    /**
+     * @brief Edits a copy of the current version and publishes it.
+     *
+     * Concurrent updates are applied one after another, so none of them is lost.
+     *
+     * @param edit Function modifying the copy, e.g. calling AddPoint or SetNodes.
+     */
+    void Update(const std::function<void(Polyline3D&)>& edit);
+
+    /**
+     * @brief Frees the replaced versions that no snapshot refers to anymore.
+     *
+     * Writers do this on every publication, so it is needed only to free memory early.
+     */
+    void Reclaim();
+
+    /**
+     * @brief Get the number of replaced versions waiting to be freed.
+     * @return Number of retired versions.
+     */
+    size_t GetRetiredCount();
+
+    /**
+     * @brief Get the number of bytes used by the current and the retired versions.
+     * @return Memory usage in bytes.
+     */
+    size_t GetMemoryUsage();
+
+    /**
+     * @brief Finds the points on the current version closest to a given point.
+     * @param point The query point.
+     * @return The result of FindNearestPointsToPolyline for a snapshot of the polyline.
+     */
+    std::vector<std::pair<size_t, Point3D>> FindNearestPoints(const Point3D& point);
+};
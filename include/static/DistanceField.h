@@ -0,0 +1,108 @@
+#pragma once
+
+#include "GeometryObjects.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class DistanceFieldEngine
+ * @brief Precomputed narrow-band grid of nearest segments for O(1) approximate queries.
+ *
+ * The space around the polyline is divided into cubic cells grouped into sparse bricks of
+ * brickSize^3 cells; only bricks within the band around the polyline are allocated. Every cell
+ * stores the index of the segment nearest to its center. The cells crossed by segments are seeded
+ * first, then the indices are propagated with a parallel jump flooding distance transform.
+ *
+ * A query looks up the cells around the query point and refines exactly against their segments.
+ * The distance of the result exceeds the true nearest distance by at most GetMaxError(), provided
+ * the propagation found the segment nearest to the cell center, which jump flooding rarely misses.
+ * Points outside the band are answered with FindNearestPointsToPolyline.
+ */
+class DistanceFieldEngine{
+public:
+    /// Number of cells along each side of a brick.
+    static constexpr int brickSize = 8;
+
+private:
+    /// Value of a cell without a segment.
+    static constexpr uint32_t emptyCell = UINT32_MAX;
+
+    Polyline3D poly;                  ///< Copy of the source polyline used for refinement.
+    Point3D origin;                   ///< World position of the corner of cell (0, 0, 0).
+    double cellSize = 0.0;            ///< Side of a cell.
+    double bandWidth = 0.0;           ///< Maximum distance from the polyline covered by the grid.
+    std::unordered_map<uint64_t, uint32_t> brickIndex; ///< Brick position to brick number.
+    std::vector<uint32_t> cells;      ///< Segment indices of all bricks, brickSize^3 per brick.
+    double buildSeconds = 0.0;        ///< Duration of the construction.
+
+    /// Packs brick coordinates into a key of brickIndex.
+    static uint64_t BrickKey(int64_t bx, int64_t by, int64_t bz);
+
+    /// Returns the position of a cell in cells or -1 if its brick is not allocated.
+    int64_t CellOffset(int64_t cx, int64_t cy, int64_t cz) const;
+
+    /// Returns the world position of the center of a cell.
+    Point3D CellCenter(int64_t cx, int64_t cy, int64_t cz) const;
+
+public:
+    /**
+     * @brief Builds the distance field of a polyline.
+     * @param _poly The 3D polyline.
+     * @param _cellSize Side of a grid cell, must be positive.
+     * @param _bandWidth Distance from the polyline covered by the grid, must be positive.
+     * @param threads Number of threads used for the propagation, 0 for the hardware concurrency.
+     * @throw std::invalid_argument If the parameters are invalid or the grid would be too large.
+     */
+    DistanceFieldEngine(const Polyline3D& _poly, double _cellSize, double _bandWidth, size_t threads = 0);
+
+    /**
+     * @brief Finds the points on the polyline closest to a given point.
+     * @param point The query point.
+     * @return A vector of pairs of segment index and nearest point, sorted by segment index.
+     */
+    std::vector<std::pair<size_t, Point3D>> FindNearestPoints(const Point3D& point) const;
+
+    /**
+     * @brief Checks whether a point is answered from the grid.
+     * @param point The query point.
+     * @return True if the cell of the point lies within the band.
+     */
+    bool IsInBand(const Point3D& point) const;
+
+    /**
+     * @brief Get the maximum excess of the result distance over the true nearest distance.
+     * @return The error bound, equal to the cell diagonal.
+     */
+    double GetMaxError() const;
+
+    /**
+     * @brief Get the side of a grid cell.
+     * @return Cell size.
+     */
+    double GetCellSize() const {return cellSize;}
+
+    /**
+     * @brief Get the distance from the polyline covered by the grid.
+     * @return Band width.
+     */
+    double GetBandWidth() const {return bandWidth;}
+
+    /**
+     * @brief Get the number of allocated bricks.
+     * @return Number of bricks.
+     */
+    size_t GetBricksCount() const {return brickIndex.size();}
+
+    /**
+     * @brief Get the duration of the construction.
+     * @return Build time in seconds.
+     */
+    double GetBuildSeconds() const {return buildSeconds;}
+
+    /**
+     * @brief Get the number of bytes used by the grid.
+     * @return Memory usage in bytes, without the copy of the polyline.
+     */
+    size_t GetMemoryUsage() const;
+};
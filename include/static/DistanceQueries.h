@@ -0,0 +1,58 @@
+#pragma once
+
+#include "GeometryObjects.h"
+#include "SegmentIndex.h"
+
+/**
+ * @brief Finds the distance from a point to a 3D polyline.
+ *
+ * Equals the distance to the points returned by FindNearestPointsToPolyline, but no points are
+ * constructed: squared distances are compared and the root is taken once at the end.
+ * Degenerate segments count as their node.
+ *
+ * @param poly The 3D polyline.
+ * @param point The query point.
+ * @return The distance, infinity for a polyline without segments.
+ */
+double DistanceToPolyline(const Polyline3D& poly, const Point3D& point);
+
+/**
+ * @brief Checks whether a 3D polyline passes within a given distance of a point.
+ *
+ * Stops at the first segment close enough.
+ *
+ * @param poly The 3D polyline.
+ * @param point The query point.
+ * @param maxDistance The distance, inclusive.
+ * @return True if some point of the polyline is at most maxDistance from point.
+ * @throw std::invalid_argument If maxDistance is negative or NaN.
+ */
+bool IsWithinDistance(const Polyline3D& poly, const Point3D& point, double maxDistance);
+
+/**
+ * @brief Finds the distance from a point to a 3D polyline using its segment index.
+ *
+ * Subtrees whose bounds are farther than the nearest segment found so far are skipped.
+ *
+ * @param poly The 3D polyline.
+ * @param index The segment index built for poly.
+ * @param point The query point.
+ * @return The same distance as DistanceToPolyline.
+ * @throw std::invalid_argument If the index belongs to a polyline with another number of nodes.
+ */
+double DistanceToIndexedPolyline(const Polyline3D& poly, const SegmentIndex& index, const Point3D& point);
+
+/**
+ * @brief Checks whether a 3D polyline passes within a given distance of a point using its segment index.
+ *
+ * Only subtrees whose bounds are within the distance are visited, the nearer child first,
+ * and the traversal stops at the first segment close enough.
+ *
+ * @param poly The 3D polyline.
+ * @param index The segment index built for poly.
+ * @param point The query point.
+ * @param maxDistance The distance, inclusive.
+ * @return The same answer as IsWithinDistance without the index.
+ * @throw std::invalid_argument If maxDistance is negative or NaN, or the index belongs to another polyline.
+ */
+bool IsWithinDistance(const Polyline3D& poly, const SegmentIndex& index, const Point3D& point, double maxDistance);
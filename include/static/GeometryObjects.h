@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <iostream>
 #include <vector>
 
@@ -174,6 +175,56 @@ public:
     void SetEnd(const Point3D& point);
 };
 
+/**
+ * @class Box3D
+ * @brief Represents an axis-aligned bounding box in 3D space.
+ */
+class Box3D{
+private:
+    Point3D minCorner; ///< Corner with the minimum coordinates.
+    Point3D maxCorner; ///< Corner with the maximum coordinates.
+public:
+    /// Default constructor. Initializes an empty box that contains no points.
+    Box3D();
+
+    /**
+     * @brief Constructs a box from its two corners.
+     * @param minPoint Corner with the minimum coordinates.
+     * @param maxPoint Corner with the maximum coordinates.
+     */
+    Box3D(const Point3D& minPoint, const Point3D& maxPoint);
+
+    /**
+     * @brief Get the corner with the minimum coordinates.
+     * @return Minimum corner.
+     */
+    Point3D GetMin() const;
+
+    /**
+     * @brief Get the corner with the maximum coordinates.
+     * @return Maximum corner.
+     */
+    Point3D GetMax() const;
+
+    /**
+     * @brief Checks whether the box contains no points.
+     * @return True if the box is empty.
+     */
+    bool IsEmpty() const;
+
+    /**
+     * @brief Extends the box to contain a point.
+     * @param point Point to include.
+     */
+    void Extend(const Point3D& point);
+
+    /**
+     * @brief Extends the box to contain another box.
+     * @param box Box to include.
+     */
+    void Extend(const Box3D& box);
+};
+
 /**
  * @class Polyline3D
  * @brief Represents a polyline in 3D space, consisting of a sequence of points.
@@ -181,6 +232,7 @@ public:
 class Polyline3D{
 private:
     std::vector<Point3D> nodes; ///< Nodes of the polyline.
+    uint64_t revision;          ///< Stamp of the current content, see GetRevision.
 public:
     /// Default constructor. Initializes an empty polyline.
     Polyline3D();
@@ -197,6 +249,28 @@ public:
      */
     Polyline3D(std::vector<Point3D>&& points) noexcept;
 
+    /// Copy constructor. The copy shares the revision, since it has the same nodes.
+    Polyline3D(const Polyline3D& other) = default;
+
+    /// Move constructor. The moved-from polyline gets a new revision.
+    Polyline3D(Polyline3D&& other) noexcept;
+
+    /// Copy assignment. The polyline takes over the revision of the other one.
+    Polyline3D& operator=(const Polyline3D& other) = default;
+
+    /// Move assignment. The moved-from polyline gets a new revision.
+    Polyline3D& operator=(Polyline3D&& other) noexcept;
+
+    /**
+     * @brief Get the revision of the polyline content.
+     *
+     * Every construction and every change through SetNodes or AddPoint assigns a new revision,
+     * unique within the process. Polylines with equal revisions have equal nodes, so structures
+     * derived from a polyline can detect that it has changed.
+     * @return The revision.
+     */
+    uint64_t GetRevision() const {return revision;}
+
     /**
      * @brief Get the number of nodes in the polyline.
      * @return Number of nodes.
@@ -209,16 +283,31 @@ public:
      */
     void SetNodes(const std::vector<Point3D>& points);
 
+    /**
+     * @brief Move one node of the polyline.
+     * @param index Index of the node.
+     * @param point New position of the node.
+     * @throw std::out_of_range If there is no node with the index.
+     */
+    void SetNode(size_t index, const Point3D& point);
+
     /**
      * @brief Get the nodes of the polyline.
-     * @return Vector of points representing the nodes.
+     * @return Constant reference to the vector of points representing the nodes.
+     * @note The reference is invalidated by SetNodes and AddPoint.
      */
-    std::vector<Point3D> GetNodes() const;
+    const std::vector<Point3D>& GetNodes() const;
 
     /**
      * @brief Add a point to the polyline.
      * @param point Point to add.
      */
     void AddPoint(const Point3D& point);
+
+    /**
+     * @brief Get the number of bytes used by the polyline.
+     * @return Memory usage in bytes, including unused capacity of the nodes.
+     */
+    size_t GetMemoryUsage() const;
 };
 
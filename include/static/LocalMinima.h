@@ -0,0 +1,39 @@
+#pragma once
+
+#include "GeometryObjects.h"
+#include "SegmentIndex.h"
+#include <vector>
+
+/**
+ * @struct LocalMinimum
+ * @brief Local minimum of the distance from a point to the polyline, taken along the polyline.
+ */
+struct LocalMinimum{
+    size_t segment;                   ///< Index of the segment, the lower one for a minimum at a shared node.
+    Point3D point;                    ///< Point of the polyline where the distance is minimal.
+    double distance;                  ///< Distance from the query point.
+};
+
+/**
+ * @brief Finds the k closest local minima of the distance from a point to a polyline.
+ *
+ * Walking along the polyline, the distance to the point has a local minimum inside a segment
+ * whenever the nearest point of the segment lies strictly inside it, and at a node whenever the
+ * nearest points of both segments meeting there are that node; such a node is reported once, with
+ * the lower segment index, as FindNearestPointsToPolyline does. The end nodes of the polyline are
+ * minima if the adjacent segment is nearest to them. Degenerate segments are skipped, so the
+ * segments around them count as adjacent. For a polyline passing the point several times, every
+ * pass yields its own minimum.
+ *
+ * The hierarchy of the index is searched nearest-first and nodes farther than the k-th minimum
+ * found so far are skipped, so small k costs about as much as one nearest point query.
+ *
+ * @param poly The 3D polyline.
+ * @param index The index built or mapped for poly.
+ * @param point The query point.
+ * @param k Maximum number of minima.
+ * @return Up to k minima ordered by distance, equal distances by segment index.
+ * @throw std::invalid_argument If the index belongs to a polyline with another number of nodes.
+ */
+std::vector<LocalMinimum> FindNearestLocalMinima(const Polyline3D& poly, const SegmentIndex& index,
+                                                 const Point3D& point, size_t k);
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "GeometryObjects.h"
+#include "SegmentIndex.h"
+#include "CompactSegmentIndex.h"
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @struct MemoryReportEntry
+ * @brief Memory used by one structure, as returned by its GetMemoryUsage.
+ */
+struct MemoryReportEntry{
+    std::string name;                 ///< Name of the structure, e.g. "segment_index".
+    size_t bytes;                     ///< Memory usage in bytes.
+};
+
+/**
+ * @brief Writes a table of memory usage, one line per structure and the total.
+ * @param output Stream the table is written to.
+ * @param entries The structures.
+ */
+void WriteMemoryReport(std::ostream& output, const std::vector<MemoryReportEntry>& entries);
+
+/**
+ * @struct IndexBudgetReport
+ * @brief The index chosen for a memory budget and the query time it costs.
+ */
+struct IndexBudgetReport{
+    size_t memoryBudget = 0;          ///< The budget in bytes.
+    size_t leafSize = 0;              ///< Leaf size of the chosen index, 0 if no index fits.
+    bool compact = false;             ///< True if the index is stored as a CompactSegmentIndex.
+    size_t memoryUsage = 0;           ///< Bytes used by the chosen index.
+    size_t defaultMemoryUsage = 0;    ///< Bytes of a SegmentIndex with the default leaf size, estimated.
+    double querySlowdown = 1.0;       ///< Query time relative to that SegmentIndex, estimated.
+};
+
+/**
+ * @class BudgetedSegmentIndex
+ * @brief The fastest exact index of a polyline that fits into a memory budget.
+ *
+ * Coarser leaves mean fewer nodes and longer scans of segments per leaf, and compact nodes take
+ * half the size of SegmentIndex nodes at the price of decoding. Leaf sizes from the default one
+ * upwards are built in both formats on a prefix of at most sampleNodes nodes and timed, until
+ * both formats are expected to fit; sizes are extrapolated to the whole polyline. The fastest
+ * candidate expected to fit is built, and if it turns out larger than the budget the next one is
+ * tried. If no index fits or beats brute force, queries scan every segment.
+ * Results are those of FindNearestPointsToPolyline in all cases.
+ * @note The budget covers the index only, not the polyline. While a compact index is built, the
+ *       SegmentIndex it is converted from exists as well.
+ */
+class BudgetedSegmentIndex{
+public:
+    /// Number of nodes of the prefix on which the candidates are measured.
+    static constexpr size_t sampleNodes = 8193;
+
+    /// Largest leaf size tried.
+    static constexpr size_t maxLeafSize = 1024;
+
+private:
+    std::unique_ptr<SegmentIndex> index;          ///< The chosen index if it has full nodes.
+    std::unique_ptr<CompactSegmentIndex> compact; ///< The chosen index if it has compact nodes.
+    IndexBudgetReport report;
+    size_t polylineNodes = 0;                     ///< Number of nodes of the indexed polyline.
+
+public:
+    /**
+     * @brief Chooses and builds the index of a polyline.
+     * @param poly The 3D polyline.
+     * @param memoryBudget Maximum number of bytes of the index.
+     */
+    BudgetedSegmentIndex(const Polyline3D& poly, size_t memoryBudget);
+
+    /**
+     * @brief Get the choice and its trade-off.
+     * @return The report.
+     */
+    const IndexBudgetReport& GetReport() const {return report;}
+
+    /**
+     * @brief Get the number of bytes used by the index.
+     * @return Memory usage in bytes, at most the budget.
+     */
+    size_t GetMemoryUsage() const {return report.memoryUsage;}
+
+    /**
+     * @brief Finds the points on the polyline closest to a given point.
+     * @param poly The polyline the index was built for.
+     * @param point The query point.
+     * @return The result of FindNearestPointsToPolyline.
+     * @throw std::invalid_argument If the index belongs to another polyline.
+     */
+    std::vector<std::pair<size_t, Point3D>> FindNearestPoints(const Polyline3D& poly, const Point3D& point) const;
+};
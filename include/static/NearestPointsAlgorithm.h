@@ -16,6 +16,44 @@
  */
 bool IsProjectionInSegment(const Point3D& point, const Segment3D& seg);
 
+/**
+ * @brief Finds the point of a 3D segment closest to a given point.
+ *
+ * If the projection of the point on the line through the segment lies within the segment,
+ * the projection is returned. Otherwise the nearest of the two segment ends is taken.
+ *
+ * @param point The point for which the nearest point on the segment is being found.
+ * @param seg The 3D segment.
+ * @return A pair of the nearest point on the segment and the distance to it.
+ */
+std::pair<Point3D, double> NearestPointOnSegment(const Point3D& point, const Segment3D& seg);
+
+/// Margin by which a segment may be farther than the current nearest distance and still affect the result.
+constexpr auto nearestCandidateMargin = 4 * eps;
+
+/**
+ * @struct SegmentCandidate
+ * @brief The nearest point of a single polyline segment to a query point.
+ */
+struct SegmentCandidate{
+    size_t segment;  ///< Index of the polyline segment.
+    Point3D point;   ///< The nearest point on that segment.
+    double distance; ///< Distance from the query point to the nearest point.
+};
+
+/**
+ * @brief Selects the nearest points among per-segment candidates.
+ *
+ * Applies the same rules as FindNearestPointsToPolyline: coinciding points are reported once
+ * with the minimum segment index, and all points within eps of the minimum distance are returned.
+ * Accelerated queries may leave out segments that are farther than the minimum distance
+ * by more than nearestCandidateMargin without changing the result.
+ *
+ * @param candidates Candidates sorted by segment index.
+ * @return A vector of pairs of segment index and nearest point, sorted by segment index.
+ */
+std::vector<std::pair<size_t, Point3D>> SelectNearestCandidates(const std::vector<SegmentCandidate>& candidates);
+
 
 /**
  * @brief Finds the points on a 3D polyline that are closest to a given point.
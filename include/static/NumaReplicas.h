@@ -0,0 +1,127 @@
+#pragma once
+
+#include "GeometryObjects.h"
+#include "SegmentIndex.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @struct NumaNode
+ * @brief A memory node of the machine with the CPUs attached to it.
+ */
+struct NumaNode{
+    size_t id;                        ///< Number of the node.
+    std::vector<size_t> cpus;         ///< CPUs of the node that this process may run on.
+};
+
+/**
+ * @struct NumaTopology
+ * @brief The memory nodes threads are pinned to and replicas are placed on.
+ */
+struct NumaTopology{
+    std::vector<NumaNode> nodes;      ///< Nodes with at least one usable CPU.
+
+    /**
+     * @brief Reads the topology of this machine from /sys/devices/system/node.
+     * @return The nodes, or a single node with all usable CPUs where the topology is unknown.
+     */
+    static NumaTopology Detect();
+
+    /**
+     * @brief Splits the usable CPUs into a number of nodes, to exercise replication on one node.
+     *
+     * The CPUs are dealt out in contiguous groups; with fewer CPUs than nodes they are shared.
+     * Memory of a simulated node is of course not local to it.
+     *
+     * @param nodesCount Number of nodes, at least 1.
+     * @return The simulated topology.
+     * @throw std::invalid_argument If nodesCount is 0.
+     */
+    static NumaTopology Simulate(size_t nodesCount);
+
+    /**
+     * @brief Get the topology of the first nodes.
+     * @param nodesCount Number of nodes to keep.
+     * @return The topology with at most nodesCount nodes.
+     */
+    NumaTopology GetFirstNodes(size_t nodesCount) const;
+};
+
+/**
+ * @brief Pins the calling thread to a set of CPUs.
+ * @param cpus The CPUs.
+ * @return True on success, false if pinning is not supported or not permitted.
+ */
+bool PinThreadToCpus(const std::vector<size_t>& cpus);
+
+/**
+ * @class ReplicatedPolyline3D
+ * @brief Copies of a polyline and its segment index on every NUMA node, for batch queries.
+ *
+ * Every replica is created by a thread pinned to its node, so that the operating system places
+ * its pages on that node when they are first written. Queries are split between worker threads
+ * pinned to the nodes, and every worker reads only the replica of its own node instead of
+ * fetching nodes across the interconnect. A topology with a single node keeps a single copy
+ * and does not pin threads.
+ */
+class ReplicatedPolyline3D{
+    /// The data of one node.
+    struct Replica{
+        Polyline3D poly;
+        std::unique_ptr<SegmentIndex> index;
+    };
+
+    NumaTopology topology;
+    std::vector<std::unique_ptr<Replica>> replicas; ///< One per node of the topology.
+    bool replicated = true;           ///< False if every node shares the first replica.
+
+public:
+    /**
+     * @brief Places a copy of a polyline and its index on every node.
+     * @param poly The 3D polyline.
+     * @param _topology The nodes, by default those of this machine.
+     * @param _replicated False to keep one copy on the first node for all, as a baseline.
+     * @param leafSize Maximum number of segments in a leaf of the indexes.
+     */
+    explicit ReplicatedPolyline3D(const Polyline3D& poly, NumaTopology _topology = NumaTopology::Detect(),
+                                  bool _replicated = true, size_t leafSize = SegmentIndex::defaultLeafSize);
+
+    /**
+     * @brief Get the topology the replicas are placed on.
+     * @return The topology.
+     */
+    const NumaTopology& GetTopology() const {return topology;}
+
+    /**
+     * @brief Get the number of copies of the polyline.
+     * @return 1 on a single node or without replication, the number of nodes otherwise.
+     */
+    size_t GetReplicasCount() const {return replicas.size();}
+
+    /**
+     * @brief Get the polyline read by the workers of a node.
+     * @param node Position of the node in the topology.
+     * @return The polyline of the replica.
+     */
+    const Polyline3D& GetPolyline(size_t node) const;
+
+    /**
+     * @brief Get the number of bytes used by all copies.
+     * @return Memory usage in bytes.
+     */
+    size_t GetMemoryUsage() const;
+
+    /**
+     * @brief Finds the points on the polyline closest to every point of a batch.
+     *
+     * The points are split into contiguous ranges, one per worker; every node runs
+     * threadsPerNode workers pinned to its CPUs.
+     *
+     * @param points The query points.
+     * @param threadsPerNode Workers per node, 0 for the number of CPUs of the node.
+     * @return The result of FindNearestPointsToPolyline for every point, in the input order.
+     */
+    std::vector<std::vector<std::pair<size_t, Point3D>>> FindNearestPoints(const std::vector<Point3D>& points,
+                                                                           size_t threadsPerNode = 0) const;
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Runs body(first, last) over [0, count) split into ranges, one per thread.
+ * @param count Number of items.
+ * @param threads Number of threads, 0 for the hardware concurrency.
+ * @param body Callable invoked with the bounds of every range.
+ *
+ * If a thread cannot be started, the ranges left over run on the calling thread once the
+ * started threads have finished.
+ */
+template <typename Body>
+void ParallelFor(size_t count, size_t threads, const Body& body){
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max<size_t>(1, std::min(threads, count));
+    if (threads == 1){
+        body(size_t{0}, count);
+        return;
+    }
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    size_t started = 0;
+    try{
+        for (; started < threads; ++started){
+            workers.emplace_back([&body, t = started, threads, count]{ body(count * t / threads, count * (t + 1) / threads); });
+        }
+    } catch (...){
+        /// Out of threads: the ranges not started yet run on the calling thread
+    }
+    for (auto& worker : workers) worker.join();
+    for (auto t = started; t < threads; ++t) body(count * t / threads, count * (t + 1) / threads);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "GeometryObjects.h"
+#include "NearestPointsAlgorithm.h"
+#include "SegmentKernel.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class PlanarPolyline3D
+ * @brief Polyline prepared for nearest point queries, with a 2D fast path for polylines lying in a plane.
+ *
+ * On construction the polyline is tested for coplanarity. A planar polyline is stored as 2D
+ * coordinates in an orthonormal frame of its plane and indexed by a uniform 2D grid of segments.
+ * A query point is split into its in-plane coordinates and its signed distance w from the plane,
+ * the 2D kernel finds the nearest in-plane points and the 3D distance is sqrt(d^2 + w^2), so the
+ * results are those of FindNearestPointsToPolyline. Axis-aligned planes get the world axes as the
+ * frame, which keeps the coordinates exact.
+ *
+ * Polylines that are not planar are answered with FindNearestPointsToPolyline.
+ */
+class PlanarPolyline3D{
+    using Kernel = SegmentKernel<2>;
+    using Coords = Kernel::Coords;
+
+    Polyline3D poly;                  ///< Copy of the source polyline, kept only if it is not planar.
+    bool planar = false;              ///< True if all nodes lie within the tolerance of one plane.
+    Point3D origin;                   ///< Point of the plane mapped to the 2D origin.
+    Vector3D axisU;                   ///< First in-plane axis.
+    Vector3D axisV;                   ///< Second in-plane axis.
+    Vector3D normal;                  ///< Unit normal of the plane.
+
+    std::vector<Coords> nodes;        ///< In-plane coordinates of the nodes.
+    Coords gridMin{};                 ///< Corner of cell (0, 0).
+    double cellSize = 0.0;            ///< Side of a grid cell.
+    size_t columns = 0;               ///< Number of cells along axisU.
+    size_t rows = 0;                  ///< Number of cells along axisV.
+    std::vector<uint32_t> cellStart;  ///< Offsets of the segment lists of the cells in cellSegments.
+    std::vector<uint32_t> cellSegments; ///< Segment indices of all cells, cell after cell.
+
+    /**
+     * @brief Finds the plane of the nodes and sets up the frame.
+     * @param points Nodes of the polyline, at least two.
+     * @param tolerance Maximum distance of a node from the plane.
+     * @return True if the nodes are coplanar.
+     */
+    bool DetectPlane(const std::vector<Point3D>& points, double tolerance);
+
+    /// Distributes the segments over the grid cells they cross.
+    void BuildGrid(const std::vector<Point3D>& points);
+
+    /// Returns the world position of in-plane coordinates.
+    Point3D ToWorld(double u, double v) const;
+
+public:
+    /**
+     * @brief Prepares a polyline for queries.
+     * @param _poly The 3D polyline.
+     * @param tolerance Maximum distance of a node from the plane for the polyline to count as planar.
+     */
+    explicit PlanarPolyline3D(const Polyline3D& _poly, double tolerance = eps);
+
+    /**
+     * @brief Finds the points on the polyline closest to a given point.
+     * @param point The query point.
+     * @return A vector of pairs of segment index and nearest point, sorted by segment index.
+     */
+    std::vector<std::pair<size_t, Point3D>> FindNearestPoints(const Point3D& point) const;
+
+    /**
+     * @brief Check whether the 2D fast path is used.
+     * @return True if the polyline is planar.
+     */
+    bool IsPlanar() const {return planar;}
+
+    /**
+     * @brief Get the unit normal of the plane of the polyline.
+     * @return The normal, meaningless if the polyline is not planar.
+     */
+    Vector3D GetNormal() const {return normal;}
+
+    /**
+     * @brief Get the number of bytes used by the prepared polyline.
+     * @return Memory usage in bytes.
+     */
+    size_t GetMemoryUsage() const;
+};
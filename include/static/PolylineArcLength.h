@@ -0,0 +1,97 @@
+#pragma once
+
+#include "GeometryObjects.h"
+#include <vector>
+
+/**
+ * @class ArcLengthTable
+ * @brief Prefix sums of the segment lengths of a polyline.
+ *
+ * The table is computed once per polyline and allows to convert positions on the polyline
+ * to the distance along it (arc length) and back without summing segment lengths per query.
+ * @note The table must be rebuilt after the nodes of the polyline have been changed.
+ */
+class ArcLengthTable{
+private:
+    std::vector<double> cumulativeLengths; ///< Distance from the first node to each node.
+public:
+    /// Default constructor. Initializes an empty table.
+    ArcLengthTable();
+
+    /**
+     * @brief Computes the table for a given polyline.
+     * @param poly The polyline whose segment lengths are accumulated.
+     */
+    explicit ArcLengthTable(const Polyline3D& poly);
+
+    /**
+     * @brief Get the number of nodes the table was built for.
+     * @return Number of nodes.
+     */
+    size_t GetNodesCount() const {return cumulativeLengths.size();}
+
+    /**
+     * @brief Get the total length of the polyline.
+     * @return Sum of all segment lengths, 0 for polylines with less than two nodes.
+     */
+    double GetTotalLength() const;
+
+    /**
+     * @brief Get the distance along the polyline from the first node to the given node.
+     * @param node Index of the node.
+     * @return Cumulative length up to the node.
+     */
+    double GetCumulativeLength(size_t node) const {return cumulativeLengths[node];}
+
+    /**
+     * @brief Finds the segment containing the position at a given distance along the polyline.
+     * @param distance Distance from the first node, clamped to [0, total length].
+     * @return Index of the segment.
+     * @note Runs a binary search, O(log n). The table must contain at least two nodes.
+     */
+    size_t FindSegmentAtDistance(double distance) const;
+
+    /**
+     * @brief Get the number of bytes used by the table.
+     * @return Memory usage in bytes.
+     */
+    size_t GetMemoryUsage() const;
+};
+
+/**
+ * @struct RoutePosition
+ * @brief A point on a polyline together with its position along the polyline.
+ */
+struct RoutePosition{
+    size_t segment;        ///< Index of the polyline segment.
+    Point3D point;         ///< The point on the segment.
+    double parameter;      ///< Segment parameter t in [0, 1], point = start + t * (end - start).
+    double distanceAlong;  ///< Distance along the polyline from the first node (arc length).
+};
+
+/**
+ * @brief Finds the points on a 3D polyline closest to a given point and their arc-length positions.
+ *
+ * The points are the same as returned by FindNearestPointsToPolyline, extended with the
+ * segment parameter and the distance from the first node along the polyline.
+ *
+ * @param poly The 3D polyline.
+ * @param table The arc length table built for poly.
+ * @param point The point for which the nearest points on the polyline are being found.
+ * @return Vector of route positions sorted by segment index.
+ * @throw std::invalid_argument If the table was built for a polyline with another number of nodes.
+ */
+std::vector<RoutePosition> FindNearestRoutePositions(const Polyline3D& poly, const ArcLengthTable& table,
+                                                     const Point3D& point);
+
+/**
+ * @brief Finds the point located at a given distance along the polyline.
+ *
+ * @param poly The 3D polyline with at least two nodes.
+ * @param table The arc length table built for poly.
+ * @param distance Distance from the first node. Values outside [0, total length] are clamped.
+ * @return The route position at the given distance.
+ * @throw std::invalid_argument If the polyline has less than two nodes.
+ * @note Runs in O(log n).
+ */
+RoutePosition PointAtDistance(const Polyline3D& poly, const ArcLengthTable& table, double distance);
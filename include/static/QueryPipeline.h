@@ -0,0 +1,71 @@
+#pragma once
+
+#include "GeometryObjects.h"
+#include "AdaptiveEngine.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+/// Number of query points parsed, queried and written as one unit of the pipeline.
+constexpr size_t pipelineChunkSize = 4096;
+
+/// Magic bytes at the start of the binary result stream.
+constexpr char binaryResultsMagic[4] = {'N', 'P', 'R', '1'};
+
+/**
+ * @brief Output formats of the batch query pipeline.
+ *
+ * Text: one line per query, "<query> <count>" followed by " <segment> <x> <y> <z>" for every
+ * solution, numbers are formatted with std::to_chars.
+ * Binary: binaryResultsMagic, then per query a packed little-endian record on every host: uint64 query,
+ * uint32 count, and count times (uint64 segment, double x, double y, double z).
+ * Query and segment numbers start from 1 in both formats, as in the single point output.
+ */
+enum class BatchOutputFormat{
+    Text,
+    Binary
+};
+
+/**
+ * @brief Parses query points from text.
+ *
+ * Every non-empty line must contain exactly three numbers separated by whitespace.
+ *
+ * @param text The text to parse.
+ * @param firstLine Number of the first line of the text, used in error messages.
+ * @param points Vector the parsed points are appended to.
+ * @throw std::invalid_argument If a line is malformed.
+ * @throw std::out_of_range If a number does not fit into double.
+ */
+void ParseQueryPoints(const std::string& text, size_t firstLine, std::vector<Point3D>& points);
+
+/**
+ * @brief Formats the results of a batch of queries.
+ *
+ * @param results Results of the queries, in the order of the queries.
+ * @param firstQuery Number of the first query of the batch, starting from 0.
+ * @param format Output format.
+ * @param buffer String the formatted results are appended to.
+ */
+void FormatQueryResults(const std::vector<std::vector<std::pair<size_t, Point3D>>>& results,
+                        size_t firstQuery, BatchOutputFormat format, std::string& buffer);
+
+/**
+ * @brief Answers nearest point queries read from a stream.
+ *
+ * Parsing, querying and output run in separate threads connected by bounded queues,
+ * so that they overlap. Chunks of pipelineChunkSize points are answered with
+ * FindNearestPointsToPolylineBatch, or with AdaptiveNearestPoints if a calibration is given,
+ * and written in the order of the input.
+ *
+ * @param poly The 3D polyline.
+ * @param input Stream of query points, see ParseQueryPoints.
+ * @param output Stream the results are written to.
+ * @param format Output format.
+ * @param calibration Costs for choosing the engine per chunk, null to always use the batch engine.
+ * @return Number of processed queries.
+ * @throw std::invalid_argument If the input is malformed.
+ * @throw std::out_of_range If a coordinate does not fit into double.
+ */
+size_t RunQueryPipeline(const Polyline3D& poly, std::istream& input, std::ostream& output, BatchOutputFormat format,
+                        const EngineCalibration* calibration = nullptr);
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "GeometryObjects.h"
+#include "NearestPointsAlgorithm.h"
+#include "SegmentIndex.h"
+#include <vector>
+
+/*
+ * Queries restricted to the segments [first, last) of a polyline, e.g. a window around the last
+ * known position when matching a track to a road. Every node of a SegmentIndex covers a
+ * contiguous range of segments, so only the O(log n) nodes crossing the ends of the window are
+ * split, nodes outside it are skipped and nodes inside it are searched as usual.
+ * Results are those of the same query on the polyline of segments first to last - 1, with the
+ * original segment indices.
+ */
+
+/**
+ * @brief Finds the points of a range of segments closest to a given point.
+ *
+ * Ties are resolved as in FindNearestPointsToPolyline: points within eps of the minimum distance
+ * are returned, and a point shared by several segments is reported with the lowest of them.
+ *
+ * @param poly The 3D polyline.
+ * @param index The segment index built for poly.
+ * @param point The query point.
+ * @param first Index of the first segment of the range.
+ * @param last Index past the last segment of the range, at most the number of segments.
+ * @return A vector of pairs of segment index and nearest point, sorted by segment index.
+ * @throw std::invalid_argument If first > last, last exceeds the number of segments or the index
+ *        belongs to another polyline.
+ */
+std::vector<std::pair<size_t, Point3D>> FindNearestPointsInRange(const Polyline3D& poly, const SegmentIndex& index,
+                                                                 const Point3D& point, size_t first, size_t last);
+
+/**
+ * @brief Finds the segments of a range passing within a radius of a given point.
+ *
+ * Degenerate segments are skipped, as in FindNearestPointsToPolyline.
+ *
+ * @param poly The 3D polyline.
+ * @param index The segment index built for poly.
+ * @param point The query point.
+ * @param radius The radius, inclusive.
+ * @param first Index of the first segment of the range.
+ * @param last Index past the last segment of the range, at most the number of segments.
+ * @return The nearest point of every such segment with its distance, sorted by segment index.
+ * @throw std::invalid_argument If the radius is negative or NaN, or for the reasons of FindNearestPointsInRange.
+ */
+std::vector<SegmentCandidate> FindSegmentsWithinRadius(const Polyline3D& poly, const SegmentIndex& index,
+                                                       const Point3D& point, double radius, size_t first, size_t last);
+
+/**
+ * @brief Finds the distance from a point to a range of segments without computing the nearest points.
+ *
+ * Degenerate segments count as their node, as in DistanceToPolyline.
+ *
+ * @param poly The 3D polyline.
+ * @param index The segment index built for poly.
+ * @param point The query point.
+ * @param first Index of the first segment of the range.
+ * @param last Index past the last segment of the range, at most the number of segments.
+ * @return The distance, infinity for an empty range.
+ * @throw std::invalid_argument For the reasons of FindNearestPointsInRange.
+ */
+double DistanceToPolylineRange(const Polyline3D& poly, const SegmentIndex& index, const Point3D& point,
+                               size_t first, size_t last);
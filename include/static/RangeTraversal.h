@@ -0,0 +1,114 @@
+#pragma once
+
+#include "GeometryObjects.h"
+#include "NearestPointsAlgorithm.h"
+#include "SegmentIndex.h"
+#include "SegmentKernel.h"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+/// Traversals of a segment index restricted to a range of segments, shared by range and time window queries.
+namespace range_detail{
+
+/// Nearest point of a segment and its distance, or nothing for a skipped segment.
+using MeasuredSegment = std::optional<std::pair<Point3D, double>>;
+
+/**
+ * @brief Visits the segments of [first, last) nearest subtree first.
+ *
+ * @param index The index of the polyline.
+ * @param point The query point.
+ * @param first First segment of the range.
+ * @param last Segment after the range.
+ * @param bound Returns the largest squared box distance still worth visiting.
+ * @param visit Called with every segment of a visited leaf within the range.
+ */
+template <typename Bound, typename Visit>
+void TraverseRange(const SegmentIndex& index, const Point3D& point, size_t first, size_t last, const Bound& bound,
+                   const Visit& visit){
+    if (first >= last || index.GetNodesCount() == 0)
+        return;
+
+    using Kernel = SegmentKernel<3>;
+    const auto* tree = index.GetNodes();
+    const Kernel::Coords query{point.GetX(), point.GetY(), point.GetZ()};
+    auto overlaps = [&](uint32_t node){
+        return tree[node].first < last && first < static_cast<size_t>(tree[node].first) + tree[node].count;
+    };
+    auto boxDistance = [&](uint32_t node){
+        return Kernel::SquaredDistanceToBox(query, tree[node].boxMin, tree[node].boxMax);
+    };
+
+    std::vector<std::pair<uint32_t, double>> stack;
+    stack.reserve(64);
+    stack.push_back({0, boxDistance(0)});
+    while (!stack.empty()){
+        auto [current, squared] = stack.back();
+        stack.pop_back();
+        if (squared > bound())
+            continue;
+
+        const auto& node = tree[current];
+        if (node.right == 0){
+            auto begin = std::max<size_t>(node.first, first);
+            auto end = std::min<size_t>(static_cast<size_t>(node.first) + node.count, last);
+            for (auto i = begin; i < end; ++i) visit(i);
+            continue;
+        }
+
+        /// Descend into the nearer child first, skipping children outside the range
+        std::pair<uint32_t, double> children[2]{{current + 1, 0.0}, {node.right, 0.0}};
+        for (auto& child : children){
+            child.second = overlaps(child.first) ? boxDistance(child.first) : std::numeric_limits<double>::infinity();
+        }
+        if (children[0].second < children[1].second) std::swap(children[0], children[1]);
+        for (const auto& child : children){
+            if (child.second <= bound()) stack.push_back(child);
+        }
+    }
+}
+
+/**
+ * @brief Collects the segments of [first, last) that may hold a nearest point of the range.
+ *
+ * @param index The index of the polyline.
+ * @param point The query point.
+ * @param first First segment of the range.
+ * @param last Segment after the range.
+ * @param measure Returns the MeasuredSegment of a segment index.
+ * @return Candidates within nearestCandidateMargin of the minimum, sorted by segment index for
+ *         SelectNearestCandidates.
+ */
+template <typename Measure>
+std::vector<SegmentCandidate> CollectNearestCandidates(const SegmentIndex& index, const Point3D& point, size_t first,
+                                                       size_t last, const Measure& measure){
+    /// Squared bound of boxes that may hold candidates, kept in sync with min_distance
+    double min_distance = std::numeric_limits<double>::max();
+    double limit = std::numeric_limits<double>::infinity();
+    std::vector<SegmentCandidate> candidates;
+    TraverseRange(index, point, first, last, [&]{ return limit; }, [&](size_t i){
+        MeasuredSegment nearest = measure(i);
+        if (!nearest || nearest->second > min_distance + nearestCandidateMargin)
+            return;
+        candidates.push_back(SegmentCandidate{i, nearest->first, nearest->second});
+        if (nearest->second < min_distance){
+            min_distance = nearest->second;
+            limit = (min_distance + nearestCandidateMargin) * (min_distance + nearestCandidateMargin);
+        }
+    });
+
+    /// Candidates collected before the minimum was known may be too far, and leaves came out of order
+    candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [min_distance](const auto& candidate){
+        return candidate.distance > min_distance + nearestCandidateMargin;
+    }), candidates.end());
+    std::sort(candidates.begin(), candidates.end(), [](const auto& elem1, const auto& elem2){
+        return elem1.segment < elem2.segment;
+    });
+    return candidates;
+}
+
+}
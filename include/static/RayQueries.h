@@ -0,0 +1,95 @@
+#pragma once
+
+#include "GeometryObjects.h"
+#include "SegmentIndex.h"
+#include <limits>
+#include <optional>
+#include <vector>
+
+/**
+ * @struct Ray3D
+ * @brief Half-line starting at an origin, e.g. the picking ray through a mouse cursor.
+ */
+struct Ray3D{
+    Point3D origin;                   ///< Start of the ray.
+    Vector3D direction;               ///< Direction of the ray, not necessarily normalized.
+};
+
+/**
+ * @struct LineSegmentClosestPoints
+ * @brief Closest points of a line or ray and a segment.
+ */
+struct LineSegmentClosestPoints{
+    double lineParameter;             ///< Position on the line, linePoint = origin + lineParameter * direction.
+    double segmentParameter;          ///< Position on the segment in [0, 1], from its start to its end.
+    Point3D linePoint;                ///< Closest point of the line.
+    Point3D segmentPoint;             ///< Closest point of the segment.
+    double distance;                  ///< Distance between the closest points.
+};
+
+/**
+ * @struct RayHit
+ * @brief Point of a polyline closest to a ray.
+ */
+struct RayHit{
+    size_t segment;                   ///< Index of the segment.
+    Point3D point;                    ///< Closest point on the polyline.
+    double rayParameter;              ///< Position of the closest point of the ray, origin + rayParameter * direction.
+    double distance;                  ///< Distance between the ray and the polyline.
+};
+
+/**
+ * @brief Finds the closest points of an infinite line and a segment.
+ *
+ * If the line is parallel to the segment, the closest points at an end of the segment are returned.
+ *
+ * @param origin A point of the line.
+ * @param direction Direction of the line.
+ * @param seg The segment.
+ * @return The closest points and their parameters.
+ * @throw std::invalid_argument If the direction is zero.
+ */
+LineSegmentClosestPoints ClosestPointsOfLineAndSegment(const Point3D& origin, const Vector3D& direction,
+                                                       const Segment3D& seg);
+
+/**
+ * @brief Finds the closest points of a ray and a segment.
+ * @param ray The ray.
+ * @param seg The segment.
+ * @return The closest points and their parameters, the line parameter is never negative.
+ * @throw std::invalid_argument If the direction of the ray is zero.
+ */
+LineSegmentClosestPoints ClosestPointsOfRayAndSegment(const Ray3D& ray, const Segment3D& seg);
+
+/**
+ * @brief Finds the point of a polyline closest to a ray.
+ *
+ * The hierarchy of the index is traversed with slab tests of the ray against the node bounds
+ * inflated by the best distance found so far, so the search stops early once a close segment is
+ * known. Of the points within eps of the minimum distance, the one nearest to the ray origin is
+ * returned, and of those the one on the segment with the lowest index.
+ *
+ * @param poly The 3D polyline.
+ * @param index The index built or mapped for poly.
+ * @param ray The ray.
+ * @param maxDistance Largest accepted distance between the ray and the polyline, e.g. a picking radius.
+ * @return The closest point, or nothing if the polyline has no segments or is farther than maxDistance.
+ * @throw std::invalid_argument If the direction of the ray is zero or the index belongs to another polyline.
+ */
+std::optional<RayHit> FindNearestPointToRay(const Polyline3D& poly, const SegmentIndex& index, const Ray3D& ray,
+                                            double maxDistance = std::numeric_limits<double>::infinity());
+
+/**
+ * @brief Finds the points of a polyline closest to many rays.
+ * @param poly The 3D polyline.
+ * @param index The index built or mapped for poly.
+ * @param rays The rays.
+ * @param maxDistance Largest accepted distance between a ray and the polyline.
+ * @param threads Number of threads, 0 for the hardware concurrency.
+ * @return The result of FindNearestPointToRay for every ray, in the order of the rays.
+ * @throw std::invalid_argument If a direction is zero or the index belongs to another polyline.
+ */
+std::vector<std::optional<RayHit>> FindNearestPointsToRays(const Polyline3D& poly, const SegmentIndex& index,
+                                                           const std::vector<Ray3D>& rays,
+                                                           double maxDistance = std::numeric_limits<double>::infinity(),
+                                                           size_t threads = 0);
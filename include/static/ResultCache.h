@@ -0,0 +1,110 @@
+#pragma once
+
+#include "GeometryObjects.h"
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class NearestPointsCache
+ * @brief Thread-safe LRU cache of nearest point results for repeated query points.
+ *
+ * Query points are quantized to a grid with the given tolerance, and all points falling into
+ * the same cell share the result computed for the first of them. With zero tolerance only
+ * bitwise equal points share a result, as do coordinates too large for a cell number and
+ * non-finite ones. The cache is bound to the revision of the polyline
+ * and is cleared as soon as a query comes for another revision, e.g. after SetNodes or AddPoint.
+ * Entries are evicted in least recently used order to keep the memory usage within the budget.
+ */
+class NearestPointsCache{
+private:
+    /// Quantized query point.
+    struct Key{
+        int64_t x, y, z;
+        uint8_t exact = 0;            ///< Bit i is set if coordinate i holds the bits of the value, not a cell.
+        bool operator==(const Key& other) const {
+            return x == other.x && y == other.y && z == other.z && exact == other.exact;
+        }
+    };
+
+    /// Hash of a quantized query point.
+    struct KeyHash{
+        size_t operator()(const Key& key) const;
+    };
+
+    /// Cached result together with its key, stored in the LRU list.
+    struct Entry{
+        Key key;
+        std::vector<std::pair<size_t, Point3D>> result;
+    };
+
+    double tolerance;                 ///< Size of the quantization cell, 0 for exact keys.
+    size_t memoryBudget;              ///< Maximum number of bytes taken by entries.
+    size_t memoryUsage = 0;           ///< Current number of bytes taken by entries.
+    uint64_t revision = 0;            ///< Revision of the polyline the entries belong to.
+    std::list<Entry> entries;         ///< Entries from the most to the least recently used.
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index; ///< Entries by key.
+    mutable std::mutex mutex;         ///< Guards the entries.
+    std::atomic<uint64_t> hits{0};    ///< Number of queries answered from the cache.
+    std::atomic<uint64_t> misses{0};  ///< Number of queries that had to be computed.
+
+    /// Quantizes a query point.
+    Key MakeKey(const Point3D& point) const;
+
+    /// Estimated number of bytes taken by an entry.
+    static size_t EntrySize(const Entry& entry);
+
+    /// Removes all entries; the mutex must be held.
+    void ClearLocked();
+
+public:
+    /// Default memory budget of a cache.
+    static constexpr size_t defaultMemoryBudget = 16 << 20;
+
+    /**
+     * @brief Constructs an empty cache.
+     * @param _tolerance Size of the quantization cell, 0 to cache only exactly repeated points.
+     * @param _memoryBudget Maximum number of bytes taken by cached entries.
+     * @throw std::invalid_argument If the tolerance is negative.
+     */
+    explicit NearestPointsCache(double _tolerance = 0.0, size_t _memoryBudget = defaultMemoryBudget);
+
+    /**
+     * @brief Finds the nearest points, using a cached result if available.
+     *
+     * @param poly The 3D polyline.
+     * @param point The point for which the nearest points on the polyline are being found.
+     * @return The result of FindNearestPointsToPolyline for the first point of the same cell.
+     */
+    std::vector<std::pair<size_t, Point3D>> FindNearestPoints(const Polyline3D& poly, const Point3D& point);
+
+    /// Removes all entries. The counters are kept.
+    void Clear();
+
+    /**
+     * @brief Get the number of queries answered from the cache.
+     * @return Number of hits.
+     */
+    uint64_t GetHits() const {return hits.load(std::memory_order_relaxed);}
+
+    /**
+     * @brief Get the number of queries that had to be computed.
+     * @return Number of misses.
+     */
+    uint64_t GetMisses() const {return misses.load(std::memory_order_relaxed);}
+
+    /**
+     * @brief Get the number of cached results.
+     * @return Number of entries.
+     */
+    size_t GetEntriesCount() const;
+
+    /**
+     * @brief Get the estimated number of bytes taken by cached entries.
+     * @return Memory usage in bytes, never above the budget.
+     */
+    size_t GetMemoryUsage() const;
+};
@@ -0,0 +1,213 @@
+#pragma once
+
+#include "GeometryObjects.h"
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * @struct SegmentIndexNode
+ * @brief Node of a bounding volume hierarchy over a contiguous range of segments.
+ *
+ * Nodes are stored in depth-first order: the left child of a node follows it directly, the right
+ * child is found by index. The layout has no pointers, so it can be written to a file and used
+ * in place from a memory mapping.
+ */
+struct SegmentIndexNode{
+    std::array<double, 3> boxMin;     ///< Minimum corner of the bounds of the segments.
+    std::array<double, 3> boxMax;     ///< Maximum corner of the bounds of the segments.
+    uint32_t first;                   ///< Index of the first segment of the range.
+    uint32_t count;                   ///< Number of segments in the range.
+    uint32_t right;                   ///< Index of the right child, 0 for a leaf.
+    uint32_t reserved;                ///< Padding, always 0.
+};
+
+static_assert(sizeof(SegmentIndexNode) == 64, "SegmentIndexNode is part of the index file format");
+
+/**
+ * @class SegmentIndex
+ * @brief Bounding volume hierarchy over the segments of a polyline, storable in a file.
+ *
+ * Every node covers a contiguous range of segment indices, split where the surface area
+ * heuristic is lowest. The index is either built in memory or memory-mapped read-only from a
+ * file written by Save, so that processes using the same file share the page cache and start
+ * without rebuilding. The file records a format version, a checksum of the nodes and a
+ * fingerprint of the polyline; a file that does not match is not used.
+ */
+class SegmentIndex{
+public:
+    /// Version of the file format, incremented whenever the layout or the fingerprint changes.
+    static constexpr uint32_t version = 2;
+
+    /// Default maximum number of segments in a leaf.
+    static constexpr size_t defaultLeafSize = 8;
+
+    /// Default growth of the hierarchy cost after which Refit rebuilds the index.
+    static constexpr double defaultMaxDegradation = 1.5;
+
+    /// Outcome of Refit.
+    enum class RefitResult{
+        Refitted,                     ///< The bounds were updated in place.
+        Rebuilt                       ///< The refitted hierarchy had degraded and was built anew.
+    };
+
+private:
+    std::vector<SegmentIndexNode> owned; ///< Nodes of an index built in memory.
+    void* mapping = nullptr;          ///< Address of the mapped file, if mapped.
+    size_t mappingSize = 0;           ///< Size of the mapped file.
+    const SegmentIndexNode* nodes = nullptr; ///< Nodes, in owned or in the mapping.
+    size_t nodesCount = 0;            ///< Number of nodes.
+    uint64_t polylineNodes = 0;       ///< Number of nodes of the indexed polyline.
+    uint64_t polylineHash = 0;        ///< Fingerprint of the indexed polyline.
+    size_t leafSize = defaultLeafSize; ///< Maximum number of segments in a leaf, used for rebuilds.
+    double builtCost = -1.0;          ///< Hierarchy cost after the last build, negative if unknown.
+    double currentCost = -1.0;        ///< Hierarchy cost of the current bounds, negative if unknown.
+    double currentArea = -1.0;        ///< Area term of currentCost before normalization, negative if unknown.
+    double currentPerimeter = -1.0;   ///< Perimeter term of currentCost before normalization, negative if unknown.
+
+    /// Unmaps the file or frees the nodes.
+    void Release();
+
+    /// Copies the nodes of a mapped index into memory, so that they can be changed.
+    void CopyMapping();
+
+public:
+    /// Default constructor. Initializes an index of an empty polyline.
+    SegmentIndex();
+
+    /**
+     * @brief Builds the index of a polyline.
+     * @param poly The 3D polyline.
+     * @param leafSize Maximum number of segments in a leaf, must be positive.
+     * @throw std::invalid_argument If the leaf size is 0 or the polyline has 2^32 segments or more.
+     */
+    explicit SegmentIndex(const Polyline3D& poly, size_t leafSize = defaultLeafSize);
+
+    SegmentIndex(const SegmentIndex&) = delete;
+    SegmentIndex& operator=(const SegmentIndex&) = delete;
+    SegmentIndex(SegmentIndex&& other) noexcept;
+    SegmentIndex& operator=(SegmentIndex&& other) noexcept;
+    ~SegmentIndex();
+
+    /**
+     * @brief Maps an index file written by Save.
+     * @param filename Name of the index file.
+     * @param poly The polyline the index must belong to.
+     * @return The mapped index, or nothing if the file is missing, has another version, a wrong
+     *         checksum or belongs to another polyline.
+     */
+    static std::optional<SegmentIndex> Map(const std::string& filename, const Polyline3D& poly);
+
+    /**
+     * @brief Maps an index file, or builds the index and rewrites the file if it cannot be used.
+     * @param filename Name of the index file.
+     * @param poly The 3D polyline.
+     * @param leafSize Maximum number of segments in a leaf used if the index is rebuilt.
+     * @return The index of poly.
+     */
+    static SegmentIndex Open(const std::string& filename, const Polyline3D& poly, size_t leafSize = defaultLeafSize);
+
+    /**
+     * @brief Updates the bounds after the nodes of the polyline have moved, e.g. through SetNodes.
+     *
+     * The ranges of segments stay the same and only the boxes are recomputed, bottom-up, with
+     * independent subtrees on several threads. Moving nodes make boxes overlap more, so the
+     * surface area cost of the hierarchy, relative to the area of the root, is compared with its
+     * cost after the last build; if it grew by more than maxDegradation, the index is rebuilt.
+     * A mapped index is copied into memory first.
+     *
+     * @param poly The polyline with the moved nodes, with as many nodes as the indexed one.
+     * @param maxDegradation Allowed growth of the cost, at least 1.
+     * @param threads Number of threads, 0 for the hardware concurrency.
+     * @return Whether the index was refitted or rebuilt.
+     * @throw std::invalid_argument If the number of nodes differs or maxDegradation is below 1.
+     */
+    RefitResult Refit(const Polyline3D& poly, double maxDegradation = defaultMaxDegradation, size_t threads = 0);
+
+    /**
+     * @brief Moves nodes of the polyline and updates the bounds of the leaves containing them.
+     *
+     * Only the leaves of the segments next to a moved node and their ancestors are refitted, and
+     * the hierarchy cost and the fingerprint are updated incrementally, so the work grows with the
+     * number of moves times the depth instead of with the polyline. The cost is checked as in Refit.
+     * When most nodes move, SetNodes followed by Refit is faster. A mapped index is copied into
+     * memory first.
+     *
+     * @param poly The indexed polyline, its nodes are moved.
+     * @param moves Pairs of node index and new position, applied in order.
+     * @param maxDegradation Allowed growth of the cost, at least 1.
+     * @return Whether the index was refitted or rebuilt.
+     * @throw std::invalid_argument If the number of nodes differs, a node index is out of range or
+     *        maxDegradation is below 1; neither the polyline nor the index is changed then.
+     */
+    RefitResult UpdateNodes(Polyline3D& poly, const std::vector<std::pair<size_t, Point3D>>& moves,
+                            double maxDegradation = defaultMaxDegradation);
+
+    /**
+     * @brief Get the growth of the hierarchy cost since the last build.
+     * @return Current cost divided by the cost after the build, 1 if no refit happened.
+     */
+    double GetDegradation() const;
+
+    /**
+     * @brief Writes the index to a file.
+     * @param filename Name of the index file.
+     * @return True on success.
+     */
+    bool Save(const std::string& filename) const;
+
+    /**
+     * @brief Computes the fingerprint of a polyline stored in index files.
+     * @param poly The 3D polyline.
+     * @return Hash of the number of nodes plus the hashes of every node with its position, a sum
+     *         that UpdateNodes can update for single nodes.
+     */
+    static uint64_t Fingerprint(const Polyline3D& poly);
+
+    /**
+     * @brief Check whether the index is used from a mapped file.
+     * @return True if mapped.
+     */
+    bool IsMapped() const {return mapping != nullptr;}
+
+    /**
+     * @brief Get the nodes of the hierarchy, the root first.
+     * @return Pointer to the nodes.
+     */
+    const SegmentIndexNode* GetNodes() const {return nodes;}
+
+    /**
+     * @brief Get the number of nodes of the hierarchy.
+     * @return Number of nodes, 0 for a polyline without segments.
+     */
+    size_t GetNodesCount() const {return nodesCount;}
+
+    /**
+     * @brief Get the number of nodes of the indexed polyline.
+     * @return Number of polyline nodes.
+     */
+    size_t GetPolylineNodesCount() const {return polylineNodes;}
+
+    /**
+     * @brief Get the number of bytes used by the index.
+     * @return Memory usage in bytes, including the mapped file.
+     */
+    size_t GetMemoryUsage() const;
+};
+
+/**
+ * @brief Finds the points on a 3D polyline closest to a given point using its index.
+ *
+ * The result is the same as returned by FindNearestPointsToPolyline.
+ *
+ * @param poly The 3D polyline.
+ * @param index The index built or mapped for poly.
+ * @param point The point for which the nearest points on the polyline are being found.
+ * @return A vector of pairs of segment index and nearest point, sorted by segment index.
+ * @throw std::invalid_argument If the index belongs to a polyline with another number of nodes.
+ */
+std::vector<std::pair<size_t, Point3D>> FindNearestPointsToIndexedPolyline(const Polyline3D& poly,
+                                                                           const SegmentIndex& index,
+                                                                           const Point3D& point);
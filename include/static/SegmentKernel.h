@@ -0,0 +1,122 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+/**
+ * @struct SegmentKernel
+ * @brief Point to segment computations on plain coordinate arrays, specialized at compile time.
+ *
+ * @tparam Dim Number of coordinates, e.g. 2 for polylines in a plane.
+ */
+template <size_t Dim>
+struct SegmentKernel{
+    /// Coordinates of a point.
+    using Coords = std::array<double, Dim>;
+
+    /**
+     * @brief Finds the point of a segment closest to a given point.
+     *
+     * @param point The point.
+     * @param start Start of the segment.
+     * @param end End of the segment.
+     * @param t Output: parameter of the nearest point, nearest = start + t * (end - start).
+     * @return Squared distance to the nearest point.
+     */
+    static double SquaredDistance(const Coords& point, const Coords& start, const Coords& end, double& t){
+        double dot = 0.0;
+        double squared_length = 0.0;
+        for (size_t i = 0; i < Dim; ++i){
+            dot += (point[i] - start[i]) * (end[i] - start[i]);
+            squared_length += (end[i] - start[i]) * (end[i] - start[i]);
+        }
+        t = squared_length > 0.0 ? std::clamp(dot / squared_length, 0.0, 1.0) : 0.0;
+
+        double result = 0.0;
+        for (size_t i = 0; i < Dim; ++i){
+            auto diff = point[i] - (start[i] + t * (end[i] - start[i]));
+            result += diff * diff;
+        }
+        return result;
+    }
+
+    /**
+     * @brief Finds the closest points of a part of a line and a segment.
+     *
+     * Minimizes |origin + s * direction - (start + t * (end - start))| over s in [sMin, sMax] and
+     * t in [0, 1]. The minimum is either the stationary point of the distance or lies on a border
+     * of the parameter domain, where it is found by clamping the minimum along the border.
+     *
+     * @param origin A point of the line.
+     * @param direction Direction of the line, must not be zero.
+     * @param sMin Lowest line parameter, may be minus infinity.
+     * @param sMax Highest line parameter, may be infinity.
+     * @param start Start of the segment.
+     * @param end End of the segment.
+     * @param s Output: line parameter of the closest point of the line.
+     * @param t Output: segment parameter of the closest point of the segment.
+     * @return Squared distance between the closest points.
+     */
+    static double SquaredDistanceLineToSegment(const Coords& origin, const Coords& direction, double sMin, double sMax,
+                                               const Coords& start, const Coords& end, double& s, double& t){
+        double a = 0.0, b = 0.0, c = 0.0, e = 0.0, f = 0.0;
+        for (size_t i = 0; i < Dim; ++i){
+            auto edge = end[i] - start[i];
+            auto offset = origin[i] - start[i];
+            a += direction[i] * direction[i];
+            b += direction[i] * edge;
+            c += direction[i] * offset;
+            e += edge * edge;
+            f += edge * offset;
+        }
+
+        auto best = std::numeric_limits<double>::infinity();
+        auto consider = [&](double candidateS, double candidateT){
+            double squared = 0.0;
+            for (size_t i = 0; i < Dim; ++i){
+                auto diff = origin[i] - start[i] + candidateS * direction[i] - candidateT * (end[i] - start[i]);
+                squared += diff * diff;
+            }
+            if (squared < best){
+                best = squared;
+                s = candidateS;
+                t = candidateT;
+            }
+        };
+
+        auto denominator = a * e - b * b;
+        if (denominator > 1e-12 * a * e){
+            auto interiorT = (a * f - b * c) / denominator;
+            auto interiorS = (interiorT * b - c) / a;
+            if (interiorT >= 0.0 && interiorT <= 1.0 && interiorS >= sMin && interiorS <= sMax)
+                consider(interiorS, interiorT);
+        }
+        consider(std::clamp(-c / a, sMin, sMax), 0.0);
+        if (e > 0.0){
+            consider(std::clamp((b - c) / a, sMin, sMax), 1.0);
+            if (std::isfinite(sMin)) consider(sMin, std::clamp((f + sMin * b) / e, 0.0, 1.0));
+            if (std::isfinite(sMax)) consider(sMax, std::clamp((f + sMax * b) / e, 0.0, 1.0));
+        }
+        return best;
+    }
+
+    /**
+     * @brief Calculates the squared distance from a point to an axis-aligned box.
+     *
+     * @param point The point.
+     * @param min Corner of the box with the minimum coordinates.
+     * @param max Corner of the box with the maximum coordinates.
+     * @return Squared distance, 0 if the point is inside.
+     */
+    static double SquaredDistanceToBox(const Coords& point, const Coords& min, const Coords& max){
+        double result = 0.0;
+        for (size_t i = 0; i < Dim; ++i){
+            auto diff = std::max({min[i] - point[i], 0.0, point[i] - max[i]});
+            result += diff * diff;
+        }
+        return result;
+    }
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "GeometryObjects.h"
+#include "SegmentIndex.h"
+#include <vector>
+
+/**
+ * @struct SegmentProximity
+ * @brief Pair of segments of a polyline that come close to each other.
+ */
+struct SegmentProximity{
+    size_t first;                     ///< Index of the lower segment.
+    size_t second;                    ///< Index of the higher segment.
+    Point3D firstPoint;               ///< Point of the first segment closest to the second one.
+    Point3D secondPoint;              ///< Point of the second segment closest to the first one.
+    double distance;                  ///< Distance between the witness points.
+};
+
+/**
+ * @brief Finds all pairs of non-adjacent segments of a polyline within a distance of each other.
+ *
+ * Two segments are adjacent if they share a node, also through degenerate segments between them,
+ * which are skipped. A polyline whose last node equals its first one is a closed loop, its first
+ * and last segments are adjacent as well. Intersections are pairs at distance 0. The hierarchy of the index is joined
+ * with itself, skipping pairs of nodes whose bounds are farther apart than the threshold; the
+ * remaining pairs of subtrees are distributed over the threads.
+ *
+ * @param poly The 3D polyline.
+ * @param index The index built or mapped for poly.
+ * @param threshold Largest reported distance, pairs up to threshold + eps are reported.
+ * @param threads Number of threads, 0 for the hardware concurrency.
+ * @return The pairs sorted by first and then second segment index.
+ * @throw std::invalid_argument If the threshold is negative or the index belongs to another polyline.
+ */
+std::vector<SegmentProximity> FindSelfProximities(const Polyline3D& poly, const SegmentIndex& index, double threshold,
+                                                  size_t threads = 0);
+
+/**
+ * @brief Finds all pairs of non-adjacent segments of a polyline within a distance of each other.
+ *
+ * Builds a SegmentIndex of the polyline and calls FindSelfProximities with it.
+ *
+ * @param poly The 3D polyline.
+ * @param threshold Largest reported distance, pairs up to threshold + eps are reported.
+ * @param threads Number of threads, 0 for the hardware concurrency.
+ * @return The pairs sorted by first and then second segment index.
+ * @throw std::invalid_argument If the threshold is negative.
+ */
+std::vector<SegmentProximity> FindSelfProximities(const Polyline3D& poly, double threshold, size_t threads = 0);
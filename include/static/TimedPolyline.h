@@ -0,0 +1,91 @@
+#pragma once
+
+#include "GeometryObjects.h"
+#include "SegmentIndex.h"
+#include <utility>
+#include <vector>
+
+/**
+ * @struct TimedNearestPoint
+ * @brief A nearest point on a timestamped polyline with the time the track passed it.
+ */
+struct TimedNearestPoint{
+    size_t segment;  ///< Index of the polyline segment.
+    Point3D point;   ///< The nearest point on the part of the segment within the time window.
+    double distance; ///< Distance from the query point to the nearest point.
+    double time;     ///< Timestamp at the point, interpolated linearly along the segment.
+};
+
+/**
+ * @class TimedPolyline3D
+ * @brief A polyline with a timestamp per node, e.g. a recorded track, indexed for time-window queries.
+ *
+ * Timestamps are nondecreasing, so a time window covers a contiguous range of segments, found
+ * by binary search. The segment index prunes on that range and on the distance together:
+ * subtrees outside the window are skipped without visiting their segments, and the segments at
+ * the ends of the window are clipped to the part the track covered within it.
+ * Between two nodes the time is interpolated linearly with the distance along the segment.
+ */
+class TimedPolyline3D{
+private:
+    Polyline3D poly;                  ///< The positions of the track.
+    std::vector<double> timestamps;   ///< Timestamp of every node.
+    SegmentIndex index;               ///< Index of the segments of poly.
+
+public:
+    /// Default constructor. Initializes an empty track.
+    TimedPolyline3D();
+
+    /**
+     * @brief Builds the index of a timestamped polyline.
+     * @param _poly The positions of the track.
+     * @param _timestamps Timestamp of every node, nondecreasing.
+     * @param leafSize Maximum number of segments in a leaf of the index.
+     * @throw std::invalid_argument If the numbers of nodes and timestamps differ, a timestamp is
+     *        NaN or decreases, or for the reasons of SegmentIndex.
+     */
+    TimedPolyline3D(Polyline3D _poly, std::vector<double> _timestamps, size_t leafSize = SegmentIndex::defaultLeafSize);
+
+    /**
+     * @brief Get the positions of the track.
+     * @return The polyline.
+     */
+    const Polyline3D& GetPolyline() const {return poly;}
+
+    /**
+     * @brief Get the timestamps of the nodes.
+     * @return Vector of timestamps, one per node.
+     */
+    const std::vector<double>& GetTimestamps() const {return timestamps;}
+
+    /**
+     * @brief Get the number of bytes used by the track.
+     * @return Memory usage in bytes, including the polyline and the index.
+     */
+    size_t GetMemoryUsage() const;
+
+    /**
+     * @brief Finds the segments the track passed through within a time window.
+     * @param startTime Start of the window, inclusive.
+     * @param endTime End of the window, inclusive.
+     * @return The range [first, last) of segments whose time span overlaps the window, empty if none does.
+     * @throw std::invalid_argument If a bound is NaN or startTime > endTime.
+     */
+    std::pair<size_t, size_t> FindSegmentsInWindow(double startTime, double endTime) const;
+
+    /**
+     * @brief Finds the points of the track closest to a given point within a time window.
+     *
+     * Only the parts of the segments covered between startTime and endTime are considered.
+     * Ties are resolved as in FindNearestPointsToPolyline: points within eps of the minimum
+     * distance are returned, and a point shared by several segments is reported with the lowest
+     * of them. Repeated nodes, where the track stood still, count as their position.
+     *
+     * @param point The query point.
+     * @param startTime Start of the window, inclusive.
+     * @param endTime End of the window, inclusive.
+     * @return The nearest points sorted by segment index, empty if the track has no segment in the window.
+     * @throw std::invalid_argument If a bound is NaN or startTime > endTime.
+     */
+    std::vector<TimedNearestPoint> FindNearestPoints(const Point3D& point, double startTime, double endTime) const;
+};
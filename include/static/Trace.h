@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @struct TraceEvent
+ * @brief A completed phase of work recorded by a TraceScope.
+ */
+struct TraceEvent{
+    const char* name;                 ///< Name of the phase, a string literal.
+    const char* category;             ///< Category of the phase, a string literal.
+    uint64_t start;                   ///< Start in nanoseconds since the first use of tracing.
+    uint64_t duration;                ///< Duration in nanoseconds.
+    uint32_t thread;                  ///< Number of the recording thread, counted from 1.
+};
+
+namespace trace_detail{
+/// Whether events are recorded; checked inline, so that disabled scopes cost one load.
+extern std::atomic<bool> enabled;
+
+/// Nanoseconds since the first use of tracing.
+uint64_t Now();
+
+/// Appends an event to the buffer of the calling thread.
+void Record(const char* name, const char* category, uint64_t start, uint64_t end);
+}
+
+/**
+ * @brief Starts recording trace events.
+ */
+void StartTracing();
+
+/**
+ * @brief Stops recording trace events. Recorded events are kept.
+ */
+void StopTracing();
+
+/**
+ * @brief Checks whether trace events are recorded.
+ * @return True between StartTracing and StopTracing.
+ */
+inline bool IsTracing(){
+    return trace_detail::enabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Names the calling thread in the trace.
+ * @param name Name shown for the thread.
+ */
+void SetTraceThreadName(const std::string& name);
+
+/**
+ * @brief Collects the events recorded by all threads, including finished ones.
+ * @return Events sorted by start time.
+ */
+std::vector<TraceEvent> CollectTraceEvents();
+
+/**
+ * @brief Discards all recorded events.
+ */
+void ClearTraceEvents();
+
+/**
+ * @brief Writes the recorded events in the Chrome trace event format.
+ *
+ * The file can be opened in chrome://tracing or in the Perfetto UI.
+ *
+ * @param filename Output file name.
+ * @return True on success.
+ */
+bool WriteTrace(const std::string& filename);
+
+/**
+ * @class TraceScope
+ * @brief Records the lifetime of the object as a trace event.
+ *
+ * Every thread records into its own buffer, so scopes on different threads do not contend.
+ * While tracing is off, constructing and destroying a scope costs a relaxed atomic load.
+ */
+class TraceScope{
+    const char* name;
+    const char* category;
+    bool active;
+    uint64_t start = 0;
+
+public:
+    /**
+     * @brief Starts an event.
+     * @param _name Name of the phase; must outlive the trace, e.g. a string literal.
+     * @param _category Category of the phase; must outlive the trace.
+     */
+    explicit TraceScope(const char* _name, const char* _category = "nearest_points") :
+                        name(_name), category(_category), active(IsTracing()){
+        if (active) start = trace_detail::Now();
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+    /// Ends the event.
+    ~TraceScope(){
+        if (active) trace_detail::Record(name, category, start, trace_detail::Now());
+    }
+};
+
+/**
+ * @class TraceSession
+ * @brief Records trace events during its lifetime and writes them to a file at the end.
+ */
+class TraceSession{
+    std::string filename;
+
+public:
+    /**
+     * @brief Starts tracing.
+     * @param _filename Output file name; if empty, nothing is recorded.
+     */
+    explicit TraceSession(std::string _filename);
+
+    TraceSession(const TraceSession&) = delete;
+    TraceSession& operator=(const TraceSession&) = delete;
+
+    /**
+     * @brief Stops tracing and writes the trace, once.
+     * @return True if the trace was written or nothing was recorded, false if the file could not be written.
+     */
+    bool Finish();
+
+    /// Finishes the session if Finish has not been called, ignoring errors.
+    ~TraceSession();
+};
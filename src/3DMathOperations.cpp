@@ -1,6 +1,7 @@
 #include "static/GeometryObjects.h"
 #include "static/3DMathOperations.h"
 #include <cmath>
+#include <algorithm>
 
 
 double ScalarProduct(const Vector3D& vec1, const Vector3D& vec2){
@@ -44,4 +45,17 @@ Point3D PointProjectionOnLineThroughSegment(const Point3D& point, const Segment3
     return Point3D {seg.GetStart().GetX() + StartToProj.GetX(),
                     seg.GetStart().GetY() + StartToProj.GetY(),
                     seg.GetStart().GetZ() + StartToProj.GetZ()};
-}
\ No newline at end of file
+}
+
+double DistanceFromPointToBox(const Point3D& point, const Box3D& box){
+    auto dx = std::max({box.GetMin().GetX() - point.GetX(), 0.0, point.GetX() - box.GetMax().GetX()});
+    auto dy = std::max({box.GetMin().GetY() - point.GetY(), 0.0, point.GetY() - box.GetMax().GetY()});
+    auto dz = std::max({box.GetMin().GetZ() - point.GetZ(), 0.0, point.GetZ() - box.GetMax().GetZ()});
+    return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+Vector3D VectorProduct(const Vector3D& vec1, const Vector3D& vec2){
+    return Vector3D{vec1.GetY() * vec2.GetZ() - vec1.GetZ() * vec2.GetY(),
+                    vec1.GetZ() * vec2.GetX() - vec1.GetX() * vec2.GetZ(),
+                    vec1.GetX() * vec2.GetY() - vec1.GetY() * vec2.GetX()};
+}
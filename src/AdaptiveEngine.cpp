@@ -0,0 +1,320 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <thread>
+#include "static/AtomicFile.h"
+#include "static/GeometryObjects.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/BatchQueries.h"
+#include "static/ParallelFor.h"
+#include "static/Trace.h"
+#include "static/AdaptiveEngine.h"
+#include <vector>
+
+namespace{
+
+/// Nodes of the polylines used for the calibration.
+constexpr size_t calibrationNodes = 2048;
+/// Repetitions of every measurement, the fastest counts.
+constexpr int calibrationRepetitions = 3;
+
+/// Keeps the results of the measured calls from being optimized away.
+std::atomic<size_t> calibrationSink{0};
+
+size_t HardwareThreads(){
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/// Fastest of several runs of a function, in nanoseconds.
+template <typename Function>
+double FastestRun(const Function& function){
+    auto best = std::numeric_limits<double>::max();
+    for (int r = 0; r < calibrationRepetitions; ++r){
+        auto start = std::chrono::steady_clock::now();
+        calibrationSink += function();
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+        best = std::min(best, elapsed.count());
+    }
+    return std::max(best, 1.0);
+}
+
+/// A random walk, flat if planar is set.
+Polyline3D CalibrationPolyline(bool planar, std::mt19937& gen){
+    std::uniform_real_distribution<double> step(-1.0, 1.0);
+    std::vector<Point3D> nodes{Point3D()};
+    while (nodes.size() < calibrationNodes){
+        const auto& last = nodes.back();
+        nodes.push_back(Point3D(last.GetX() + step(gen), last.GetY() + step(gen),
+                                planar ? 0.0 : last.GetZ() + step(gen)));
+    }
+    return Polyline3D(std::move(nodes));
+}
+
+/// Points uniformly distributed in the bounding box of the nodes.
+std::vector<Point3D> CalibrationQueries(const Polyline3D& poly, size_t count, std::mt19937& gen){
+    Box3D box;
+    for (const auto& node : poly.GetNodes()) box.Extend(node);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::vector<Point3D> points;
+    for (size_t i = 0; i < count; ++i){
+        points.push_back(Point3D(box.GetMin().GetX() + unit(gen) * (box.GetMax().GetX() - box.GetMin().GetX()),
+                                 box.GetMin().GetY() + unit(gen) * (box.GetMax().GetY() - box.GetMin().GetY()),
+                                 box.GetMin().GetZ() + unit(gen) * (box.GetMax().GetZ() - box.GetMin().GetZ())));
+    }
+    return points;
+}
+
+double Log2Segments(size_t segments){
+    return std::log2(static_cast<double>(std::max<size_t>(segments, 2)));
+}
+
+/// Checks whether the bounding box of a polyline is flat along one of the axes.
+bool IsAxisPlanar(const Polyline3D& poly){
+    if (poly.GetNodesCount() < 2)
+        return false;
+    Box3D box;
+    for (const auto& node : poly.GetNodes()) box.Extend(node);
+    auto size = Vector3D(box.GetMin(), box.GetMax());
+    return std::min({size.GetX(), size.GetY(), size.GetZ()}) <= eps;
+}
+
+}
+
+const char* EngineName(NearestPointsEngine engine){
+    switch (engine){
+        case NearestPointsEngine::BruteForce: return "brute_force";
+        case NearestPointsEngine::Batch: return "batch";
+        case NearestPointsEngine::Planar: return "planar";
+        case NearestPointsEngine::SegmentIndex: return "segment_index";
+    }
+    return "unknown";
+}
+
+EngineCalibration EngineCalibration::Measure(){
+    TraceScope trace("calibrate_engines", "prepare");
+    EngineCalibration calibration;
+    calibration.threads = HardwareThreads();
+    std::mt19937 gen(7);
+
+    auto poly = CalibrationPolyline(false, gen);
+    auto segments = static_cast<double>(poly.GetNodesCount() - 1);
+    auto levels = Log2Segments(poly.GetNodesCount() - 1);
+    auto few = CalibrationQueries(poly, 16, gen);
+    auto many = CalibrationQueries(poly, 256, gen);
+
+    calibration.bruteForceSegment = FastestRun([&]{
+        size_t found = 0;
+        for (const auto& point : few) found += FindNearestPointsToPolyline(poly, point).size();
+        return found;
+    }) / (segments * static_cast<double>(few.size()));
+
+    calibration.batchSegment = FastestRun([&]{
+        return FindNearestPointsToPolylineBatch(poly, few).size();
+    }) / (segments * static_cast<double>(few.size()));
+
+    calibration.indexBuildSegment = FastestRun([&]{
+        return SegmentIndex(poly).GetNodesCount();
+    }) / (segments * levels);
+
+    SegmentIndex index(poly);
+    calibration.indexQueryLevel = FastestRun([&]{
+        size_t found = 0;
+        for (const auto& point : many) found += FindNearestPointsToIndexedPolyline(poly, index, point).size();
+        return found;
+    }) / (levels * static_cast<double>(many.size()));
+
+    auto flat = CalibrationPolyline(true, gen);
+    auto flatQueries = CalibrationQueries(flat, 256, gen);
+    calibration.planarBuildSegment = FastestRun([&]{
+        return PlanarPolyline3D(flat).IsPlanar() ? size_t{1} : size_t{0};
+    }) / segments;
+
+    PlanarPolyline3D planar(flat);
+    calibration.planarQuery = FastestRun([&]{
+        size_t found = 0;
+        for (const auto& point : flatQueries) found += planar.FindNearestPoints(point).size();
+        return found;
+    }) / static_cast<double>(flatQueries.size());
+
+    if (calibration.threads > 1){
+        calibration.threadStart = FastestRun([&]{
+            std::atomic<size_t> ranges{0};
+            ParallelFor(calibration.threads, calibration.threads, [&](size_t, size_t){ ++ranges; });
+            return ranges.load();
+        }) / static_cast<double>(calibration.threads);
+    }
+    return calibration;
+}
+
+std::optional<EngineCalibration> EngineCalibration::Load(const std::string& filename){
+    std::ifstream file(filename);
+    if (!file.is_open())
+        return std::nullopt;
+
+    EngineCalibration calibration;
+    int fileVersion = 0;
+    size_t fields = 0;
+    std::string key;
+    while (file >> key){
+        if (key == "version"){ file >> fileVersion; continue; }
+        if (key == "threads"){ file >> calibration.threads; ++fields; continue; }
+        double* value = nullptr;
+        if (key == "brute_force_segment") value = &calibration.bruteForceSegment;
+        else if (key == "batch_segment") value = &calibration.batchSegment;
+        else if (key == "index_build_segment") value = &calibration.indexBuildSegment;
+        else if (key == "index_query_level") value = &calibration.indexQueryLevel;
+        else if (key == "planar_build_segment") value = &calibration.planarBuildSegment;
+        else if (key == "planar_query") value = &calibration.planarQuery;
+        else if (key == "thread_start") value = &calibration.threadStart;
+        if (!value || !(file >> *value) || !(*value > 0.0))
+            return std::nullopt;
+        ++fields;
+    }
+    if (fileVersion != version || fields != 8 || calibration.threads != HardwareThreads())
+        return std::nullopt;
+    return calibration;
+}
+
+bool EngineCalibration::Save(const std::string& filename) const{
+    std::error_code error;
+    auto directory = std::filesystem::path(filename).parent_path();
+    if (!directory.empty()) std::filesystem::create_directories(directory, error);
+
+    /// Replaced atomically, so that concurrent processes never read a partial file
+    return ReplaceFileAtomically(filename, [this](const std::string& temporary){
+        std::ofstream file(temporary);
+        if (!file.is_open())
+            return false;
+        file.precision(17);
+        file << "version " << version << "\n"
+             << "threads " << threads << "\n"
+             << "brute_force_segment " << bruteForceSegment << "\n"
+             << "batch_segment " << batchSegment << "\n"
+             << "index_build_segment " << indexBuildSegment << "\n"
+             << "index_query_level " << indexQueryLevel << "\n"
+             << "planar_build_segment " << planarBuildSegment << "\n"
+             << "planar_query " << planarQuery << "\n"
+             << "thread_start " << threadStart << "\n";
+        /// The content fits into the stream buffer, so write errors only show when it is flushed
+        file.close();
+        return static_cast<bool>(file);
+    });
+}
+
+std::string EngineCalibration::DefaultCacheFile(){
+    if (const char* file = std::getenv("NEARESTPOINTS_CALIBRATION"))
+        return file;
+    std::filesystem::path directory;
+    if (const char* cache = std::getenv("XDG_CACHE_HOME"); cache && *cache)
+        directory = cache;
+    else if (const char* home = std::getenv("HOME"); home && *home)
+        directory = std::filesystem::path(home) / ".cache";
+    else
+        return "";
+    return (directory / "nearest_points" / "calibration.txt").string();
+}
+
+const EngineCalibration& EngineCalibration::Get(){
+    static const EngineCalibration calibration = []{
+        auto file = DefaultCacheFile();
+        if (!file.empty()){
+            if (auto loaded = Load(file)) return *loaded;
+        }
+        auto measured = Measure();
+        if (!file.empty()) measured.Save(file);
+        return measured;
+    }();
+    return calibration;
+}
+
+EngineChoice SelectEngine(const EngineCalibration& calibration, const EngineWorkload& workload){
+    EngineChoice best;
+    if (workload.segments == 0 || workload.queries == 0)
+        return best;
+
+    auto segments = static_cast<double>(workload.segments);
+    auto queries = static_cast<double>(workload.queries);
+    auto levels = Log2Segments(workload.segments);
+    best.estimatedNanoseconds = std::numeric_limits<double>::max();
+
+    auto consider = [&](NearestPointsEngine engine, double preparation, double perQuery){
+        for (auto threads : {size_t{1}, std::min(calibration.threads, workload.queries)}){
+            auto time = preparation + queries * perQuery / static_cast<double>(threads);
+            if (threads > 1) time += static_cast<double>(threads) * calibration.threadStart;
+            if (time < best.estimatedNanoseconds) best = EngineChoice{engine, threads, time};
+        }
+    };
+
+    consider(NearestPointsEngine::BruteForce, 0.0, calibration.bruteForceSegment * segments);
+    /// Packets need several points to pay off
+    if (workload.queries >= 2 * batchPacketSize)
+        consider(NearestPointsEngine::Batch, 0.0, calibration.batchSegment * segments);
+    if (workload.axisPlanar)
+        consider(NearestPointsEngine::Planar, workload.planarBuilt ? 0.0 : calibration.planarBuildSegment * segments,
+                 calibration.planarQuery);
+    consider(NearestPointsEngine::SegmentIndex,
+             workload.indexBuilt ? 0.0 : calibration.indexBuildSegment * segments * levels,
+             calibration.indexQueryLevel * levels);
+    return best;
+}
+
+AdaptiveNearestPoints::AdaptiveNearestPoints(Polyline3D _poly, const EngineCalibration& _calibration) :
+                                poly(std::move(_poly)), calibration(_calibration), axisPlanar(IsAxisPlanar(poly)){}
+
+void AdaptiveNearestPoints::Prepare(NearestPointsEngine engine){
+    if (engine == NearestPointsEngine::SegmentIndex && !index)
+        index = std::make_unique<SegmentIndex>(poly);
+    if (engine == NearestPointsEngine::Planar && !planar)
+        planar = std::make_unique<PlanarPolyline3D>(poly);
+}
+
+void AdaptiveNearestPoints::Query(NearestPointsEngine engine, const std::vector<Point3D>& points, size_t first,
+                                  size_t last, std::vector<std::vector<std::pair<size_t, Point3D>>>& results) const{
+    switch (engine){
+        case NearestPointsEngine::BruteForce:
+            for (auto i = first; i < last; ++i) results[i] = FindNearestPointsToPolyline(poly, points[i]);
+            break;
+        case NearestPointsEngine::Batch:{
+            std::vector<Point3D> range(points.begin() + first, points.begin() + last);
+            auto answers = FindNearestPointsToPolylineBatch(poly, range);
+            std::move(answers.begin(), answers.end(), results.begin() + first);
+            break;
+        }
+        case NearestPointsEngine::Planar:
+            for (auto i = first; i < last; ++i) results[i] = planar->FindNearestPoints(points[i]);
+            break;
+        case NearestPointsEngine::SegmentIndex:
+            for (auto i = first; i < last; ++i) results[i] = FindNearestPointsToIndexedPolyline(poly, *index, points[i]);
+            break;
+    }
+}
+
+size_t AdaptiveNearestPoints::GetMemoryUsage() const{
+    return sizeof(*this) - sizeof(poly) + poly.GetMemoryUsage() + (index ? index->GetMemoryUsage() : 0) +
+           (planar ? planar->GetMemoryUsage() : 0);
+}
+
+std::vector<std::pair<size_t, Point3D>> AdaptiveNearestPoints::FindNearestPoints(const Point3D& point){
+    return FindNearestPoints(std::vector<Point3D>{point})[0];
+}
+
+std::vector<std::vector<std::pair<size_t, Point3D>>> AdaptiveNearestPoints::FindNearestPoints(
+                                                                        const std::vector<Point3D>& points){
+    auto segments = poly.GetNodesCount() < 2 ? 0 : poly.GetNodesCount() - 1;
+    lastChoice = SelectEngine(calibration, EngineWorkload{segments, axisPlanar, points.size(), index != nullptr,
+                                                          planar != nullptr});
+    TraceScope trace(EngineName(lastChoice.engine), "query");
+    Prepare(lastChoice.engine);
+
+    std::vector<std::vector<std::pair<size_t, Point3D>>> results(points.size());
+    ParallelFor(points.size(), lastChoice.threads, [&](size_t first, size_t last){
+        Query(lastChoice.engine, points, first, last, results);
+    });
+    return results;
+}
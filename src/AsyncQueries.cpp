@@ -0,0 +1,157 @@
+#include <algorithm>
+#include <stdexcept>
+#include "static/GeometryObjects.h"
+#include "static/SegmentIndex.h"
+#include "static/Trace.h"
+#include "static/AsyncQueries.h"
+#include <vector>
+
+AsyncQuery::State::State(const Point3D& _point, Clock::time_point _deadline)
+    : point(_point), deadline(_deadline), future(promise.get_future().share()) {}
+
+void AsyncQuery::State::Complete(AsyncQueryResult result){
+    promise.set_value(std::move(result));
+    std::vector<std::function<void()>> next;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+        next.swap(continuations);
+    }
+    for (const auto& continuation : next) continuation();
+}
+
+bool AsyncQuery::Cancel(){
+    if (state->claimed.exchange(true))
+        return false;
+    state->Complete(AsyncQueryResult{AsyncQueryStatus::Cancelled, {}});
+    return true;
+}
+
+bool AsyncQuery::IsReady() const{
+    return state->future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+void AsyncQuery::OnComplete(std::function<void(const AsyncQueryResult&)> callback){
+    /// The continuation belongs to the state, so it must not own the state
+    auto* target = state.get();
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (!state->done){
+            state->continuations.push_back([target, callback = std::move(callback)]{ callback(target->future.get()); });
+            return;
+        }
+    }
+    callback(state->future.get());
+}
+
+AsyncNearestPoints::AsyncNearestPoints(Polyline3D _poly, const AsyncQueryOptions& _options)
+    : poly(std::move(_poly)), options(_options){
+    if (options.maxBatch == 0)
+        throw std::invalid_argument("Batches must hold at least one query");
+    index = SegmentIndex(poly);
+
+    auto threads = options.threads;
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t t = 0; t < threads; ++t){
+        workers.emplace_back([this]{ Work(); });
+    }
+}
+
+AsyncNearestPoints::~AsyncNearestPoints(){
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    for (auto& worker : workers) worker.join();
+
+    for (auto& state : queue){
+        if (!state->claimed.exchange(true)) state->Complete(AsyncQueryResult{AsyncQueryStatus::Cancelled, {}});
+    }
+}
+
+void AsyncNearestPoints::Run(AsyncQuery::State& state) const{
+    if (state.claimed.exchange(true))
+        return;
+    if (Clock::now() > state.deadline){
+        state.Complete(AsyncQueryResult{AsyncQueryStatus::DeadlineExceeded, {}});
+        return;
+    }
+    AsyncQueryResult result;
+    try{
+        result = AsyncQueryResult{AsyncQueryStatus::Completed, FindNearestPointsToIndexedPolyline(poly, index, state.point)};
+    } catch (...){
+        result = AsyncQueryResult{AsyncQueryStatus::Failed, {}, std::current_exception()};
+    }
+    state.Complete(std::move(result));
+}
+
+void AsyncNearestPoints::Work(){
+    std::vector<std::shared_ptr<AsyncQuery::State>> batch;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true){
+        wakeup.wait(lock, [this]{ return stopping || !queue.empty(); });
+        if (stopping)
+            return;
+
+        /// Let submissions arriving close together join the batch
+        if (queue.size() < options.maxBatch && options.batchDelay.count() > 0){
+            wakeup.wait_for(lock, options.batchDelay, [this]{ return stopping || queue.size() >= options.maxBatch; });
+            if (stopping)
+                return;
+        }
+        if (queue.empty())
+            continue;
+
+        auto count = std::min(queue.size(), options.maxBatch);
+        batch.assign(queue.begin(), queue.begin() + count);
+        queue.erase(queue.begin(), queue.begin() + count);
+        if (!queue.empty()) wakeup.notify_one();
+        ++batches;
+        lock.unlock();
+        {
+            TraceScope trace("async_batch", "query");
+            for (const auto& state : batch) Run(*state);
+        }
+        batch.clear();
+        lock.lock();
+    }
+}
+
+AsyncQuery AsyncNearestPoints::Submit(const Point3D& point, Clock::time_point deadline){
+    auto state = std::make_shared<AsyncQuery::State>(point, deadline);
+    bool notify;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(state);
+        /// Waiting workers are woken by the first query of a batch and by a full batch only
+        notify = queue.size() == 1 || queue.size() >= options.maxBatch;
+    }
+    if (notify) wakeup.notify_one();
+    return AsyncQuery(std::move(state));
+}
+
+AsyncQuery AsyncNearestPoints::Submit(const Point3D& point, Clock::duration budget){
+    return Submit(point, Clock::now() + budget);
+}
+
+size_t AsyncNearestPoints::GetMemoryUsage() const{
+    std::lock_guard<std::mutex> lock(mutex);
+    return sizeof(*this) - sizeof(poly) - sizeof(index) + poly.GetMemoryUsage() + index.GetMemoryUsage() +
+           workers.capacity() * sizeof(std::thread) +
+           queue.size() * (sizeof(std::shared_ptr<AsyncQuery::State>) + sizeof(AsyncQuery::State));
+}
+
+std::vector<AsyncQuery> AsyncNearestPoints::SubmitBatch(const std::vector<Point3D>& points, Clock::time_point deadline){
+    std::vector<AsyncQuery> handles;
+    handles.reserve(points.size());
+    for (const auto& point : points){
+        handles.push_back(AsyncQuery(std::make_shared<AsyncQuery::State>(point, deadline)));
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& handle : handles) queue.push_back(handle.state);
+    }
+    wakeup.notify_all();
+    return handles;
+}
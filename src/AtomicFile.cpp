@@ -0,0 +1,46 @@
+#include <filesystem>
+#include <system_error>
+#include <thread>
+#include "static/AtomicFile.h"
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <process.h>
+#endif
+
+namespace{
+
+/// Identifier of this process, 0 where it is unknown.
+long ProcessId(){
+#if defined(__unix__) || defined(__APPLE__)
+    return static_cast<long>(getpid());
+#elif defined(_WIN32)
+    return static_cast<long>(_getpid());
+#else
+    return 0;
+#endif
+}
+
+}
+
+std::string TemporaryFileName(const std::string& filename){
+    return filename + ".tmp" + std::to_string(ProcessId()) + "." +
+           std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+}
+
+bool ReplaceFileAtomically(const std::string& filename, const std::function<bool(const std::string&)>& write){
+    auto temporary = TemporaryFileName(filename);
+    std::error_code error;
+    if (!write(temporary)){
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    std::filesystem::rename(temporary, filename, error);
+    if (error){
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include "static/GeometryObjects.h"
+#include "static/3DMathOperations.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/Trace.h"
+#include "static/BatchQueries.h"
+#include <vector>
+
+/// Spreads the lower 21 bits of a value so that there are two zero bits between neighbouring bits.
+static uint64_t SpreadBits(uint32_t value){
+    uint64_t x = value & 0x1FFFFF;
+    x = (x | x << 32) & 0x1F00000000FFFF;
+    x = (x | x << 16) & 0x1F0000FF0000FF;
+    x = (x | x << 8) & 0x100F00F00F00F00F;
+    x = (x | x << 4) & 0x10C30C30C30C30C3;
+    x = (x | x << 2) & 0x1249249249249249;
+    return x;
+}
+
+uint64_t MortonCode(uint32_t x, uint32_t y, uint32_t z){
+    return SpreadBits(x) | SpreadBits(y) << 1 | SpreadBits(z) << 2;
+}
+
+/// Lower bound of the distance between any two points of two boxes.
+static double DistanceBetweenBoxes(const Box3D& box1, const Box3D& box2){
+    auto gap = [](double min1, double max1, double min2, double max2){
+        return std::max({min1 - max2, 0.0, min2 - max1});
+    };
+    auto dx = gap(box1.GetMin().GetX(), box1.GetMax().GetX(), box2.GetMin().GetX(), box2.GetMax().GetX());
+    auto dy = gap(box1.GetMin().GetY(), box1.GetMax().GetY(), box2.GetMin().GetY(), box2.GetMax().GetY());
+    auto dz = gap(box1.GetMin().GetZ(), box1.GetMax().GetZ(), box2.GetMin().GetZ(), box2.GetMax().GetZ());
+    return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+/// Returns the indices of the points sorted along the Z-order curve over their bounding box.
+static std::vector<size_t> MortonOrder(const std::vector<Point3D>& points){
+    Box3D bounds;
+    for (const auto& point : points) bounds.Extend(point);
+
+    constexpr double cells = (1 << 21) - 1;
+    auto quantize = [](double value, double min, double max){
+        if (!(max > min)) return 0u;
+        return static_cast<uint32_t>((value - min) / (max - min) * cells);
+    };
+
+    std::vector<std::pair<uint64_t, size_t>> codes;
+    codes.reserve(points.size());
+    for (size_t i = 0; i < points.size(); ++i){
+        codes.push_back({MortonCode(quantize(points[i].GetX(), bounds.GetMin().GetX(), bounds.GetMax().GetX()),
+                                    quantize(points[i].GetY(), bounds.GetMin().GetY(), bounds.GetMax().GetY()),
+                                    quantize(points[i].GetZ(), bounds.GetMin().GetZ(), bounds.GetMax().GetZ())), i});
+    }
+    std::sort(codes.begin(), codes.end());
+
+    std::vector<size_t> order;
+    order.reserve(points.size());
+    for (const auto& code : codes) order.push_back(code.second);
+    return order;
+}
+
+std::vector<std::vector<std::pair<size_t, Point3D>>> FindNearestPointsToPolylineBatch(const Polyline3D& poly,
+                                                                                     const std::vector<Point3D>& points){
+    TraceScope trace("batch_queries", "query");
+    std::vector<std::vector<std::pair<size_t, Point3D>>> answer(points.size());
+    auto n = poly.GetNodesCount();
+    if (n < 2 || points.empty())
+        return answer;
+
+    const auto& nodes = poly.GetNodes();
+
+    /// Bounding boxes of chunks of consecutive segments
+    std::vector<Box3D> chunks;
+    for (size_t first = 0; first + 1 < n; first += batchChunkSize){
+        Box3D box;
+        for (auto i = first; i <= std::min(first + batchChunkSize, n - 1); ++i) box.Extend(nodes[i]);
+        chunks.push_back(box);
+    }
+
+    auto order = MortonOrder(points);
+
+    std::vector<std::pair<double, size_t>> chunkOrder(chunks.size());
+    std::array<std::vector<SegmentCandidate>, batchPacketSize> candidates;
+    std::array<double, batchPacketSize> min_distance;
+
+    for (size_t packetStart = 0; packetStart < order.size(); packetStart += batchPacketSize){
+        auto packetSize = std::min(batchPacketSize, order.size() - packetStart);
+        const auto* packet = order.data() + packetStart;
+
+        Box3D packetBox;
+        for (size_t q = 0; q < packetSize; ++q){
+            packetBox.Extend(points[packet[q]]);
+            candidates[q].clear();
+            min_distance[q] = std::numeric_limits<double>::max();
+        }
+
+        /// Visit chunks from the nearest to the packet, so that the bounds shrink quickly
+        for (size_t c = 0; c < chunks.size(); ++c){
+            chunkOrder[c] = {DistanceBetweenBoxes(packetBox, chunks[c]), c};
+        }
+        std::sort(chunkOrder.begin(), chunkOrder.end());
+
+        for (const auto& [packetBound, c] : chunkOrder){
+            auto maxBound = 0.0;
+            for (size_t q = 0; q < packetSize; ++q) maxBound = std::max(maxBound, min_distance[q]);
+            if (packetBound > maxBound + nearestCandidateMargin)
+                break;
+
+            std::array<bool, batchPacketSize> active{};
+            auto anyActive = false;
+            for (size_t q = 0; q < packetSize; ++q){
+                active[q] = DistanceFromPointToBox(points[packet[q]], chunks[c]) <=
+                            min_distance[q] + nearestCandidateMargin;
+                anyActive = anyActive || active[q];
+            }
+            if (!anyActive)
+                continue;
+
+            auto first = c * batchChunkSize;
+            auto last = std::min(first + batchChunkSize, n - 1);
+            for (auto i = first; i < last; ++i){
+                if (nodes[i] == nodes[i + 1])
+                    continue;
+
+                Segment3D SegI (nodes[i], nodes[i + 1]);
+                for (size_t q = 0; q < packetSize; ++q){
+                    if (!active[q])
+                        continue;
+                    auto [nearest, dist] = NearestPointOnSegment(points[packet[q]], SegI);
+                    if (dist > min_distance[q] + nearestCandidateMargin)
+                        continue;
+                    candidates[q].push_back(SegmentCandidate{i, nearest, dist});
+                    if (dist < min_distance[q]) min_distance[q] = dist;
+                }
+            }
+        }
+
+        for (size_t q = 0; q < packetSize; ++q){
+            auto bound = min_distance[q] + nearestCandidateMargin;
+            auto& list = candidates[q];
+            list.erase(std::remove_if(list.begin(), list.end(), [bound](const auto& candidate){
+                return candidate.distance > bound;
+            }), list.end());
+            std::sort(list.begin(), list.end(), [](const auto& elem1, const auto& elem2){
+                return elem1.segment < elem2.segment;
+            });
+            answer[packet[q]] = SelectNearestCandidates(list);
+        }
+    }
+
+    return answer;
+}
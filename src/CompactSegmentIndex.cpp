@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include "static/GeometryObjects.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/SegmentKernel.h"
+#include "static/Trace.h"
+#include "static/CompactSegmentIndex.h"
+#include <vector>
+
+namespace{
+
+using Coords = std::array<double, 3>;
+
+/// Largest quantized coordinate.
+constexpr double quantizationSteps = 65535.0;
+
+/// Quantizes a child box relative to the box of its parent, rounding outwards.
+void QuantizeChild(const Coords& parentMin, const Coords& parentMax, const Coords& childMin, const Coords& childMax,
+                   uint16_t* quantizedMin, uint16_t* quantizedMax){
+    for (int axis = 0; axis < 3; ++axis){
+        auto extent = parentMax[axis] - parentMin[axis];
+        if (!(extent > 0.0)){
+            quantizedMin[axis] = 0;
+            quantizedMax[axis] = 0;
+            continue;
+        }
+        /// One extra step on each side absorbs the rounding of the decoding
+        auto low = std::floor((childMin[axis] - parentMin[axis]) / extent * quantizationSteps) - 1.0;
+        auto high = std::ceil((childMax[axis] - parentMin[axis]) / extent * quantizationSteps) + 1.0;
+        quantizedMin[axis] = static_cast<uint16_t>(std::clamp(low, 0.0, quantizationSteps));
+        quantizedMax[axis] = static_cast<uint16_t>(std::clamp(high, 0.0, quantizationSteps));
+    }
+}
+
+/**
+ * @class VanEmdeBoasOrder
+ * @brief Lists the inner nodes of a SegmentIndex in van Emde Boas order.
+ */
+class VanEmdeBoasOrder{
+    const SegmentIndexNode* tree;
+    std::vector<uint32_t> heights;    ///< Number of inner levels below and including every node.
+
+    /// Inner children of a node.
+    void Children(uint32_t node, std::vector<uint32_t>& output) const{
+        for (auto child : {node + 1, tree[node].right}){
+            if (tree[child].right != 0) output.push_back(child);
+        }
+    }
+
+    /// Lists the subtree of node cut at the given height and returns the roots below the cut.
+    std::vector<uint32_t> Emit(uint32_t node, uint32_t height, std::vector<uint32_t>& order) const{
+        std::vector<uint32_t> frontier;
+        if (height <= 1){
+            order.push_back(node);
+            Children(node, frontier);
+            return frontier;
+        }
+        auto top = height / 2;
+        for (auto bottomRoot : Emit(node, top, order)){
+            auto below = Emit(bottomRoot, height - top, order);
+            frontier.insert(frontier.end(), below.begin(), below.end());
+        }
+        return frontier;
+    }
+
+public:
+    VanEmdeBoasOrder(const SegmentIndexNode* _tree, size_t count) : tree(_tree), heights(count, 0){
+        /// Children follow their parents, so a reverse pass sees them first
+        for (auto i = count; i-- > 0;){
+            if (tree[i].right == 0) continue;
+            heights[i] = 1 + std::max(heights[i + 1], heights[tree[i].right]);
+        }
+    }
+
+    std::vector<uint32_t> Get() const{
+        std::vector<uint32_t> order;
+        Emit(0, heights[0], order);
+        return order;
+    }
+};
+
+}
+
+CompactSegmentIndex::CompactSegmentIndex() = default;
+
+CompactSegmentIndex::CompactSegmentIndex(const SegmentIndex& index, Layout _layout) :
+                                polylineNodes(index.GetPolylineNodesCount()), layout(_layout){
+    TraceScope trace("build_compact_index", "index");
+    auto count = index.GetNodesCount();
+    if (count == 0) return;
+    const auto* tree = index.GetNodes();
+    rootMin = tree[0].boxMin;
+    rootMax = tree[0].boxMax;
+
+    /// Leaves in depth-first order cover consecutive ranges of segments
+    std::vector<uint32_t> reference(count);
+    for (size_t i = 0; i < count; ++i){
+        if (tree[i].right != 0) continue;
+        if (leafFirst.size() >= leafFlag)
+            throw std::invalid_argument("Segment index has too many leaves for the compact format");
+        reference[i] = leafFlag | static_cast<uint32_t>(leafFirst.size());
+        leafFirst.push_back(tree[i].first);
+    }
+    leafFirst.push_back(tree[0].first + tree[0].count);
+    root = reference[0];
+    if (tree[0].right == 0) return;
+
+    std::vector<uint32_t> order;
+    if (layout == Layout::BreadthFirst){
+        order.push_back(0);
+        for (size_t i = 0; i < order.size(); ++i){
+            for (auto child : {order[i] + 1, tree[order[i]].right}){
+                if (tree[child].right != 0) order.push_back(child);
+            }
+        }
+    }
+    else{
+        order = VanEmdeBoasOrder(tree, count).Get();
+    }
+    for (size_t i = 0; i < order.size(); ++i) reference[order[i]] = static_cast<uint32_t>(i);
+
+    /// Quantize the children against the bounds decoded exactly as the queries decode them
+    nodes.resize(order.size());
+    struct Pending{
+        uint32_t node;
+        Coords boxMin;
+        Coords boxMax;
+    };
+    std::vector<Pending> stack{{0, rootMin, rootMax}};
+    while (!stack.empty()){
+        auto pending = stack.back();
+        stack.pop_back();
+        auto& compact = nodes[reference[pending.node]];
+        uint32_t children[2] = {pending.node + 1, tree[pending.node].right};
+        for (int side = 0; side < 2; ++side){
+            const auto& child = tree[children[side]];
+            QuantizeChild(pending.boxMin, pending.boxMax, child.boxMin, child.boxMax,
+                          compact.childMin[side], compact.childMax[side]);
+            compact.child[side] = reference[children[side]];
+            if (child.right != 0){
+                Pending next{children[side], {}, {}};
+                DecodeChild(compact, side, pending.boxMin, pending.boxMax, next.boxMin, next.boxMax);
+                stack.push_back(next);
+            }
+        }
+    }
+}
+
+void CompactSegmentIndex::DecodeChild(const CompactSegmentIndexNode& node, int side, const Coords& parentMin,
+                                      const Coords& parentMax, Coords& childMin, Coords& childMax){
+    for (int axis = 0; axis < 3; ++axis){
+        auto step = (parentMax[axis] - parentMin[axis]) / quantizationSteps;
+        childMin[axis] = parentMin[axis] + node.childMin[side][axis] * step;
+        childMax[axis] = parentMin[axis] + node.childMax[side][axis] * step;
+    }
+}
+
+size_t CompactSegmentIndex::GetMemoryUsage() const{
+    return sizeof(*this) + nodes.capacity() * sizeof(CompactSegmentIndexNode) + leafFirst.capacity() * sizeof(uint32_t);
+}
+
+std::vector<std::pair<size_t, Point3D>> FindNearestPointsToIndexedPolyline(const Polyline3D& poly,
+                                                                           const CompactSegmentIndex& index,
+                                                                           const Point3D& point){
+    if (index.GetPolylineNodesCount() != poly.GetNodesCount())
+        throw std::invalid_argument("Segment index belongs to another polyline");
+    if (index.GetLeavesCount() == 0)
+        return {};
+
+    const auto& nodes = poly.GetNodes();
+    const auto& tree = index.GetNodes();
+    const Coords query{point.GetX(), point.GetY(), point.GetZ()};
+
+    double min_distance = std::numeric_limits<double>::max();
+    std::vector<SegmentCandidate> candidates;
+
+    struct Entry{
+        uint32_t reference;
+        double bound;
+        Coords boxMin;
+        Coords boxMax;
+    };
+    std::vector<Entry> stack{{index.GetRoot(), 0.0, index.GetRootMin(), index.GetRootMax()}};
+
+    while (!stack.empty()){
+        auto entry = stack.back();
+        stack.pop_back();
+        if (entry.bound > min_distance + nearestCandidateMargin)
+            continue;
+
+        if (entry.reference & CompactSegmentIndex::leafFlag){
+            auto [first, count] = index.GetLeafRange(entry.reference & ~CompactSegmentIndex::leafFlag);
+            for (auto i = first; i < first + count; ++i){
+                if (nodes[i] == nodes[i + 1])
+                    continue;
+
+                auto [nearest, dist] = NearestPointOnSegment(point, Segment3D {nodes[i], nodes[i + 1]});
+                if (dist > min_distance + nearestCandidateMargin)
+                    continue;
+                candidates.push_back(SegmentCandidate{i, nearest, dist});
+                if (dist < min_distance) min_distance = dist;
+            }
+            continue;
+        }
+
+        /// Descend into the nearer child first
+        const auto& node = tree[entry.reference];
+        Entry children[2];
+        for (int side = 0; side < 2; ++side){
+            children[side].reference = node.child[side];
+            CompactSegmentIndex::DecodeChild(node, side, entry.boxMin, entry.boxMax,
+                                             children[side].boxMin, children[side].boxMax);
+            children[side].bound = std::sqrt(SegmentKernel<3>::SquaredDistanceToBox(query, children[side].boxMin,
+                                                                                     children[side].boxMax));
+        }
+        auto nearer = children[0].bound <= children[1].bound ? 0 : 1;
+        stack.push_back(children[1 - nearer]);
+        stack.push_back(children[nearer]);
+    }
+
+    /// Candidates collected before the minimum was known may be too far, and leaves came out of order
+    candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [min_distance](const auto& candidate){
+        return candidate.distance > min_distance + nearestCandidateMargin;
+    }), candidates.end());
+    std::sort(candidates.begin(), candidates.end(), [](const auto& elem1, const auto& elem2){
+        return elem1.segment < elem2.segment;
+    });
+
+    return SelectNearestCandidates(candidates);
+}
@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include "static/GeometryObjects.h"
+#include "static/3DMathOperations.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/Trace.h"
+#include "static/CompressedPolyline.h"
+#include <vector>
+
+/// Appends a signed value as a zigzag encoded varint.
+static void WriteVarint(std::vector<uint8_t>& bytes, int64_t value){
+    auto zigzag = (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    while (zigzag >= 0x80){
+        bytes.push_back(static_cast<uint8_t>(zigzag | 0x80));
+        zigzag >>= 7;
+    }
+    bytes.push_back(static_cast<uint8_t>(zigzag));
+}
+
+/// Reads a zigzag encoded varint and advances the position.
+static int64_t ReadVarint(const uint8_t*& data){
+    uint64_t zigzag = 0;
+    int shift = 0;
+    while (*data & 0x80){
+        zigzag |= static_cast<uint64_t>(*data++ & 0x7F) << shift;
+        shift += 7;
+    }
+    zigzag |= static_cast<uint64_t>(*data++) << shift;
+    return static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+}
+
+CompressedPolyline3D::CompressedPolyline3D() = default;
+
+CompressedPolyline3D::CompressedPolyline3D(const Polyline3D& poly, double _resolution, size_t _blockSize) :
+                                resolution(_resolution), nodesCount(poly.GetNodesCount()), blockSize(_blockSize){
+    TraceScope trace("compress_polyline", "prepare");
+    if (!(resolution > 0.0) || blockSize == 0 || blockSize >= std::numeric_limits<uint32_t>::max())
+        throw std::invalid_argument("Resolution and block size of a compressed polyline must be positive");
+
+    const auto& nodes = poly.GetNodes();
+    if (nodes.empty()) return;
+
+    Box3D bounds;
+    for (const auto& node : nodes) bounds.Extend(node);
+    origin = bounds.GetMin();
+
+    /// Quantize all coordinates first, so that overflow is detected before anything is encoded
+    std::vector<int32_t> quantized(nodes.size() * 3);
+    auto quantize = [this](double value, double base){
+        auto q = std::llround((value - base) / resolution);
+        if (q > std::numeric_limits<int32_t>::max())
+            throw std::invalid_argument("Polyline extent is too large for the compression resolution");
+        return static_cast<int32_t>(q);
+    };
+    for (size_t i = 0; i < nodes.size(); ++i){
+        quantized[3 * i] = quantize(nodes[i].GetX(), origin.GetX());
+        quantized[3 * i + 1] = quantize(nodes[i].GetY(), origin.GetY());
+        quantized[3 * i + 2] = quantize(nodes[i].GetZ(), origin.GetZ());
+    }
+
+    /// Every block holds blockSize segments, i.e. blockSize + 1 nodes
+    for (size_t first = 0; first == 0 || first + 1 < nodes.size(); first += blockSize){
+        auto last = std::min(first + blockSize, nodes.size() - 1);
+
+        Block block{};
+        block.firstNode = first;
+        block.byteOffset = bytes.size();
+        block.nodesCount = static_cast<uint32_t>(last - first + 1);
+        for (int axis = 0; axis < 3; ++axis){
+            block.first[axis] = quantized[3 * first + axis];
+            block.boxMin[axis] = block.first[axis];
+            block.boxMax[axis] = block.first[axis];
+        }
+        for (auto i = first + 1; i <= last; ++i){
+            for (int axis = 0; axis < 3; ++axis){
+                auto value = quantized[3 * i + axis];
+                WriteVarint(bytes, static_cast<int64_t>(value) - quantized[3 * (i - 1) + axis]);
+                block.boxMin[axis] = std::min(block.boxMin[axis], value);
+                block.boxMax[axis] = std::max(block.boxMax[axis], value);
+            }
+        }
+        blocks.push_back(block);
+    }
+    blocks.shrink_to_fit();
+    bytes.shrink_to_fit();
+}
+
+Point3D CompressedPolyline3D::Dequantize(const int32_t* coords) const{
+    return Point3D{origin.GetX() + coords[0] * resolution,
+                   origin.GetY() + coords[1] * resolution,
+                   origin.GetZ() + coords[2] * resolution};
+}
+
+double CompressedPolyline3D::GetMaxError() const{
+    return resolution * std::sqrt(3.0) / 2.0;
+}
+
+Box3D CompressedPolyline3D::GetBlockBounds(size_t block) const{
+    return Box3D{Dequantize(blocks[block].boxMin), Dequantize(blocks[block].boxMax)};
+}
+
+void CompressedPolyline3D::DecodeBlock(size_t block, std::vector<Point3D>& nodes) const{
+    const auto& header = blocks[block];
+    nodes.clear();
+    nodes.reserve(header.nodesCount);
+
+    int32_t coords[3] = {header.first[0], header.first[1], header.first[2]};
+    nodes.push_back(Dequantize(coords));
+
+    const auto* data = bytes.data() + header.byteOffset;
+    for (uint32_t i = 1; i < header.nodesCount; ++i){
+        for (auto& coord : coords) coord = static_cast<int32_t>(coord + ReadVarint(data));
+        nodes.push_back(Dequantize(coords));
+    }
+}
+
+Polyline3D CompressedPolyline3D::Decompress() const{
+    std::vector<Point3D> nodes;
+    nodes.reserve(nodesCount);
+
+    std::vector<Point3D> blockNodes;
+    for (size_t block = 0; block < blocks.size(); ++block){
+        DecodeBlock(block, blockNodes);
+        /// Skip the node shared with the previous block
+        nodes.insert(nodes.end(), blockNodes.begin() + (block == 0 ? 0 : 1), blockNodes.end());
+    }
+    return Polyline3D(std::move(nodes));
+}
+
+size_t CompressedPolyline3D::GetMemoryUsage() const{
+    return sizeof(*this) + blocks.capacity() * sizeof(Block) + bytes.capacity();
+}
+
+std::vector<std::pair<size_t, Point3D>> FindNearestPointsToCompressedPolyline(const CompressedPolyline3D& poly,
+                                                                              const Point3D& point){
+    if (poly.GetNodesCount() < 2)
+        return {};
+
+    /// Visit blocks from the nearest bounding box, so that far blocks can be skipped
+    std::vector<std::pair<double, size_t>> order;
+    order.reserve(poly.GetBlocksCount());
+    for (size_t block = 0; block < poly.GetBlocksCount(); ++block){
+        order.push_back({DistanceFromPointToBox(point, poly.GetBlockBounds(block)), block});
+    }
+    std::sort(order.begin(), order.end());
+
+    double min_distance = std::numeric_limits<double>::max();
+    std::vector<SegmentCandidate> candidates;
+    std::vector<Point3D> nodes;
+
+    for (const auto& [bound, block] : order){
+        if (bound > min_distance + nearestCandidateMargin)
+            break;
+
+        poly.DecodeBlock(block, nodes);
+        auto first = poly.GetBlockFirstNode(block);
+        for (size_t i = 0; i + 1 < nodes.size(); ++i){
+            if (nodes[i] == nodes[i + 1])
+                continue;
+
+            auto [nearest, dist] = NearestPointOnSegment(point, Segment3D {nodes[i], nodes[i + 1]});
+            if (dist > min_distance + nearestCandidateMargin)
+                continue;
+            candidates.push_back(SegmentCandidate{first + i, nearest, dist});
+            if (dist < min_distance) min_distance = dist;
+        }
+    }
+
+    /// Candidates collected before the minimum was known may be too far, and blocks came out of order
+    candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [min_distance](const auto& candidate){
+        return candidate.distance > min_distance + nearestCandidateMargin;
+    }), candidates.end());
+    std::sort(candidates.begin(), candidates.end(), [](const auto& elem1, const auto& elem2){
+        return elem1.segment < elem2.segment;
+    });
+
+    return SelectNearestCandidates(candidates);
+}
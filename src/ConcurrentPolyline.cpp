@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <thread>
+#include "static/GeometryObjects.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/ConcurrentPolyline.h"
+#include <vector>
+
+ConcurrentPolyline3D::Snapshot::Snapshot(ConcurrentPolyline3D* _owner, size_t _slot, const Version* _version) :
+                                owner(_owner), slot(_slot), version(_version){}
+
+ConcurrentPolyline3D::Snapshot::Snapshot(Snapshot&& other) noexcept :
+                                owner(other.owner), slot(other.slot), version(other.version){
+    other.owner = nullptr;
+}
+
+ConcurrentPolyline3D::Snapshot& ConcurrentPolyline3D::Snapshot::operator=(Snapshot&& other) noexcept{
+    if (this != &other){
+        if (owner) owner->slots[slot].epoch.store(0, std::memory_order_release);
+        owner = other.owner;
+        slot = other.slot;
+        version = other.version;
+        other.owner = nullptr;
+    }
+    return *this;
+}
+
+ConcurrentPolyline3D::Snapshot::~Snapshot(){
+    if (owner) owner->slots[slot].epoch.store(0, std::memory_order_release);
+}
+
+ConcurrentPolyline3D::ConcurrentPolyline3D(Polyline3D poly) : current(nullptr){
+    PublishLocked(std::move(poly));
+}
+
+ConcurrentPolyline3D::~ConcurrentPolyline3D(){
+    delete current.load();
+}
+
+ConcurrentPolyline3D::Snapshot ConcurrentPolyline3D::Read(){
+    /// Start at a slot depending on the thread, so that readers rarely compete for the same slot
+    auto start = std::hash<std::thread::id>()(std::this_thread::get_id()) % maxReaders;
+    for (size_t attempt = 0;; ++attempt){
+        auto slot = (start + attempt) % maxReaders;
+        auto epoch = globalEpoch.load();
+        uint64_t expected = 0;
+        /// The announcement precedes the load of the version, so a writer scanning the slots
+        /// afterwards keeps every version this reader may load
+        if (slots[slot].epoch.compare_exchange_strong(expected, epoch))
+            return Snapshot(this, slot, current.load());
+        if (attempt % maxReaders == maxReaders - 1)
+            std::this_thread::yield();
+    }
+}
+
+void ConcurrentPolyline3D::PublishLocked(Polyline3D&& poly){
+    auto* next = new Version{std::move(poly), ++versionsCount};
+    auto* previous = current.exchange(next);
+    if (!previous)
+        return;
+    /// Readers announcing a later epoch have started after the exchange and see the new version
+    retired.emplace_back(globalEpoch.fetch_add(1), std::unique_ptr<const Version>(previous));
+    ReclaimLocked();
+}
+
+void ConcurrentPolyline3D::ReclaimLocked(){
+    auto oldest = std::numeric_limits<uint64_t>::max();
+    for (const auto& slot : slots){
+        auto epoch = slot.epoch.load();
+        if (epoch != 0) oldest = std::min(oldest, epoch);
+    }
+    retired.erase(std::remove_if(retired.begin(), retired.end(), [oldest](const auto& entry){
+        return entry.first < oldest;
+    }), retired.end());
+}
+
+void ConcurrentPolyline3D::Publish(Polyline3D poly){
+    std::lock_guard<std::mutex> lock(writerMutex);
+    PublishLocked(std::move(poly));
+}
+
+void ConcurrentPolyline3D::Update(const std::function<void(Polyline3D&)>& edit){
+    std::lock_guard<std::mutex> lock(writerMutex);
+    /// Only writers free versions, so the current one stays alive while the mutex is held
+    auto poly = current.load()->poly;
+    edit(poly);
+    PublishLocked(std::move(poly));
+}
+
+void ConcurrentPolyline3D::Reclaim(){
+    std::lock_guard<std::mutex> lock(writerMutex);
+    ReclaimLocked();
+}
+
+size_t ConcurrentPolyline3D::GetRetiredCount(){
+    std::lock_guard<std::mutex> lock(writerMutex);
+    return retired.size();
+}
+
+size_t ConcurrentPolyline3D::GetMemoryUsage(){
+    /// Versions are only freed by writers, so the current one stays alive while the mutex is held
+    std::lock_guard<std::mutex> lock(writerMutex);
+    auto usage = sizeof(*this) + sizeof(Version) - sizeof(Polyline3D) + current.load()->poly.GetMemoryUsage() +
+                 retired.capacity() * sizeof(retired[0]);
+    for (const auto& [epoch, version] : retired) usage += sizeof(Version) - sizeof(Polyline3D) + version->poly.GetMemoryUsage();
+    return usage;
+}
+
+std::vector<std::pair<size_t, Point3D>> ConcurrentPolyline3D::FindNearestPoints(const Point3D& point){
+    auto snapshot = Read();
+    return FindNearestPointsToPolyline(snapshot.Get(), point);
+}
@@ -0,0 +1,298 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include "static/GeometryObjects.h"
+#include "static/3DMathOperations.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/DistanceField.h"
+#include "static/Trace.h"
+#include "static/ParallelFor.h"
+#include <vector>
+
+/// Maximum number of bricks along each axis, limited by the brick key packing.
+constexpr int64_t maxBricksPerAxis = int64_t{1} << 21;
+
+constexpr int brickCells = DistanceFieldEngine::brickSize * DistanceFieldEngine::brickSize *
+                           DistanceFieldEngine::brickSize;
+
+/// Squared distance from a point to a segment given by the coordinates of its ends.
+static double SquaredDistanceToSegment(const double* point, const double* start, const double* end){
+    auto dx = end[0] - start[0];
+    auto dy = end[1] - start[1];
+    auto dz = end[2] - start[2];
+    auto px = point[0] - start[0];
+    auto py = point[1] - start[1];
+    auto pz = point[2] - start[2];
+    auto squared_length = dx * dx + dy * dy + dz * dz;
+    auto t = squared_length > 0.0 ? std::clamp((px * dx + py * dy + pz * dz) / squared_length, 0.0, 1.0) : 0.0;
+    px -= t * dx;
+    py -= t * dy;
+    pz -= t * dz;
+    return px * px + py * py + pz * pz;
+}
+
+/// Division rounding towards minus infinity.
+static int64_t FloorDiv(int64_t value, int64_t divisor){
+    return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+uint64_t DistanceFieldEngine::BrickKey(int64_t bx, int64_t by, int64_t bz){
+    return static_cast<uint64_t>(bx) | static_cast<uint64_t>(by) << 21 | static_cast<uint64_t>(bz) << 42;
+}
+
+int64_t DistanceFieldEngine::CellOffset(int64_t cx, int64_t cy, int64_t cz) const{
+    auto bx = FloorDiv(cx, brickSize);
+    auto by = FloorDiv(cy, brickSize);
+    auto bz = FloorDiv(cz, brickSize);
+    if (bx < 0 || by < 0 || bz < 0 || bx >= maxBricksPerAxis || by >= maxBricksPerAxis || bz >= maxBricksPerAxis)
+        return -1;
+
+    auto it = brickIndex.find(BrickKey(bx, by, bz));
+    if (it == brickIndex.end())
+        return -1;
+
+    auto local = ((cz - bz * brickSize) * brickSize + (cy - by * brickSize)) * brickSize + (cx - bx * brickSize);
+    return static_cast<int64_t>(it->second) * brickCells + local;
+}
+
+Point3D DistanceFieldEngine::CellCenter(int64_t cx, int64_t cy, int64_t cz) const{
+    return Point3D{origin.GetX() + (cx + 0.5) * cellSize,
+                   origin.GetY() + (cy + 0.5) * cellSize,
+                   origin.GetZ() + (cz + 0.5) * cellSize};
+}
+
+DistanceFieldEngine::DistanceFieldEngine(const Polyline3D& _poly, double _cellSize, double _bandWidth, size_t threads) :
+                                poly(_poly), cellSize(_cellSize), bandWidth(_bandWidth){
+    TraceScope trace("build_distance_field", "index");
+    if (!(cellSize > 0.0) || !(bandWidth > 0.0))
+        throw std::invalid_argument("Cell size and band width of a distance field must be positive");
+
+    auto start = std::chrono::steady_clock::now();
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    const auto& nodes = poly.GetNodes();
+    if (nodes.size() < 2) return;
+
+    Box3D bounds;
+    for (const auto& node : nodes) bounds.Extend(node);
+    origin = Point3D{bounds.GetMin().GetX() - bandWidth,
+                     bounds.GetMin().GetY() - bandWidth,
+                     bounds.GetMin().GetZ() - bandWidth};
+
+    auto extent = std::max({bounds.GetMax().GetX() - bounds.GetMin().GetX(),
+                            bounds.GetMax().GetY() - bounds.GetMin().GetY(),
+                            bounds.GetMax().GetZ() - bounds.GetMin().GetZ()}) + 2 * bandWidth;
+    if (extent / (cellSize * brickSize) >= static_cast<double>(maxBricksPerAxis - 1))
+        throw std::invalid_argument("Distance field grid is too large for the cell size");
+
+    auto cellOf = [this](double value, double base){
+        return static_cast<int64_t>(std::floor((value - base) / cellSize));
+    };
+
+    /// Allocate the bricks around every piece of every segment, pieces are at most a brick long
+    auto brickExtent = cellSize * brickSize;
+    auto margin = bandWidth + cellSize * std::sqrt(3.0);
+    for (size_t i = 0; i + 1 < nodes.size(); ++i){
+        auto length = DistanceBetweenPoints(nodes[i], nodes[i + 1]);
+        auto pieces = std::max<size_t>(1, static_cast<size_t>(std::ceil(length / brickExtent)));
+        for (size_t piece = 0; piece < pieces; ++piece){
+            Box3D box;
+            for (auto k : {piece, piece + 1}){
+                auto t = static_cast<double>(k) / pieces;
+                box.Extend(Point3D{nodes[i].GetX() + t * (nodes[i + 1].GetX() - nodes[i].GetX()),
+                                   nodes[i].GetY() + t * (nodes[i + 1].GetY() - nodes[i].GetY()),
+                                   nodes[i].GetZ() + t * (nodes[i + 1].GetZ() - nodes[i].GetZ())});
+            }
+            auto bx0 = std::max<int64_t>(0, FloorDiv(cellOf(box.GetMin().GetX() - margin, origin.GetX()), brickSize));
+            auto by0 = std::max<int64_t>(0, FloorDiv(cellOf(box.GetMin().GetY() - margin, origin.GetY()), brickSize));
+            auto bz0 = std::max<int64_t>(0, FloorDiv(cellOf(box.GetMin().GetZ() - margin, origin.GetZ()), brickSize));
+            auto bx1 = FloorDiv(cellOf(box.GetMax().GetX() + margin, origin.GetX()), brickSize);
+            auto by1 = FloorDiv(cellOf(box.GetMax().GetY() + margin, origin.GetY()), brickSize);
+            auto bz1 = FloorDiv(cellOf(box.GetMax().GetZ() + margin, origin.GetZ()), brickSize);
+            for (auto bz = bz0; bz <= bz1; ++bz)
+                for (auto by = by0; by <= by1; ++by)
+                    for (auto bx = bx0; bx <= bx1; ++bx)
+                        brickIndex.emplace(BrickKey(bx, by, bz), static_cast<uint32_t>(brickIndex.size()));
+        }
+    }
+
+    /// Flat copy of the coordinates for the propagation kernel
+    std::vector<double> coords;
+    coords.reserve(nodes.size() * 3);
+    for (const auto& node : nodes){
+        coords.insert(coords.end(), {node.GetX(), node.GetY(), node.GetZ()});
+    }
+
+    /// Position of every brick, to iterate over the cells in parallel
+    std::vector<uint64_t> brickKeys(brickIndex.size());
+    for (const auto& [key, index] : brickIndex) brickKeys[index] = key;
+
+    cells.assign(brickKeys.size() * brickCells, emptyCell);
+    std::vector<double> distances(cells.size(), std::numeric_limits<double>::max());
+
+    /// Seed the cells crossed by the segments
+    for (size_t i = 0; i + 1 < nodes.size(); ++i){
+        if (nodes[i] == nodes[i + 1])
+            continue;
+
+        auto length = DistanceBetweenPoints(nodes[i], nodes[i + 1]);
+        auto samples = static_cast<size_t>(std::ceil(2.0 * length / cellSize)) + 1;
+        for (size_t k = 0; k <= samples; ++k){
+            auto t = static_cast<double>(k) / samples;
+            Point3D sample {nodes[i].GetX() + t * (nodes[i + 1].GetX() - nodes[i].GetX()),
+                            nodes[i].GetY() + t * (nodes[i + 1].GetY() - nodes[i].GetY()),
+                            nodes[i].GetZ() + t * (nodes[i + 1].GetZ() - nodes[i].GetZ())};
+            auto cx = cellOf(sample.GetX(), origin.GetX());
+            auto cy = cellOf(sample.GetY(), origin.GetY());
+            auto cz = cellOf(sample.GetZ(), origin.GetZ());
+            auto offset = CellOffset(cx, cy, cz);
+            if (offset < 0)
+                continue;
+            auto center = CellCenter(cx, cy, cz);
+            double centerCoords[3] = {center.GetX(), center.GetY(), center.GetZ()};
+            auto dist = SquaredDistanceToSegment(centerCoords, &coords[3 * i], &coords[3 * i + 3]);
+            if (dist < distances[offset]){
+                distances[offset] = dist;
+                cells[offset] = static_cast<uint32_t>(i);
+            }
+        }
+    }
+
+    /// Jump flooding: every cell looks at the cells step apart and takes over a nearer segment
+    auto bandCells = static_cast<int64_t>(std::ceil(bandWidth / cellSize)) + 1;
+    std::vector<int64_t> steps;
+    for (int64_t step = 1; step < bandCells; step *= 2) steps.insert(steps.begin(), step);
+    steps.push_back(1);
+
+    std::vector<uint32_t> nextCells(cells.size());
+    std::vector<double> nextDistances(cells.size());
+    const double originCoords[3] = {origin.GetX(), origin.GetY(), origin.GetZ()};
+    for (auto step : steps){
+        /// Bricks the neighbours step apart can fall into, relative to the brick of the cell,
+        /// and for every local coordinate and direction the slot of that brick and the local coordinate in it
+        int64_t offsets[6];
+        int offsetsCount = 0;
+        int slotOf[3][brickSize];
+        int64_t localOf[3][brickSize];
+        for (int d = -1; d <= 1; ++d){
+            for (int64_t local = 0; local < brickSize; ++local){
+                auto offset = FloorDiv(local + d * step, brickSize);
+                auto slot = static_cast<int>(std::find(offsets, offsets + offsetsCount, offset) - offsets);
+                if (slot == offsetsCount) offsets[offsetsCount++] = offset;
+                slotOf[d + 1][local] = slot;
+                localOf[d + 1][local] = local + d * step - offset * brickSize;
+            }
+        }
+
+        ParallelFor(brickKeys.size(), threads, [&](size_t first, size_t last){
+            for (auto brick = first; brick < last; ++brick){
+                int64_t base[3] = {static_cast<int64_t>(brickKeys[brick] & (maxBricksPerAxis - 1)),
+                                   static_cast<int64_t>(brickKeys[brick] >> 21 & (maxBricksPerAxis - 1)),
+                                   static_cast<int64_t>(brickKeys[brick] >> 42)};
+
+                int64_t neighbourBricks[6][6][6];
+                for (int iz = 0; iz < offsetsCount; ++iz)
+                    for (int iy = 0; iy < offsetsCount; ++iy)
+                        for (int ix = 0; ix < offsetsCount; ++ix){
+                            auto offset = CellOffset((base[0] + offsets[ix]) * brickSize,
+                                                     (base[1] + offsets[iy]) * brickSize,
+                                                     (base[2] + offsets[iz]) * brickSize);
+                            neighbourBricks[iz][iy][ix] = offset < 0 ? -1 : offset / brickCells;
+                        }
+
+                for (int local = 0; local < brickCells; ++local){
+                    int64_t l[3] = {local % brickSize, local / brickSize % brickSize, local / (brickSize * brickSize)};
+                    auto offset = static_cast<int64_t>(brick) * brickCells + local;
+                    auto best = cells[offset];
+                    auto bestDistance = distances[offset];
+                    double center[3];
+                    for (int axis = 0; axis < 3; ++axis)
+                        center[axis] = originCoords[axis] + (base[axis] * brickSize + l[axis] + 0.5) * cellSize;
+
+                    for (int dz = -1; dz <= 1; ++dz)
+                        for (int dy = -1; dy <= 1; ++dy)
+                            for (int dx = -1; dx <= 1; ++dx){
+                                auto neighbourBrick = neighbourBricks[slotOf[dz + 1][l[2]]][slotOf[dy + 1][l[1]]]
+                                                                     [slotOf[dx + 1][l[0]]];
+                                if (neighbourBrick < 0)
+                                    continue;
+                                auto segment = cells[neighbourBrick * brickCells +
+                                                     (localOf[dz + 1][l[2]] * brickSize + localOf[dy + 1][l[1]]) *
+                                                     brickSize + localOf[dx + 1][l[0]]];
+                                if (segment == emptyCell || segment == best)
+                                    continue;
+                                auto dist = SquaredDistanceToSegment(center, &coords[3 * segment],
+                                                                     &coords[3 * segment + 3]);
+                                if (dist < bestDistance || (dist == bestDistance && segment < best)){
+                                    best = segment;
+                                    bestDistance = dist;
+                                }
+                            }
+                    nextCells[offset] = best;
+                    nextDistances[offset] = bestDistance;
+                }
+            }
+        });
+        cells.swap(nextCells);
+        distances.swap(nextDistances);
+    }
+
+    /// Cells outside the band are left to the exact fallback
+    for (size_t offset = 0; offset < cells.size(); ++offset){
+        if (distances[offset] > bandWidth * bandWidth) cells[offset] = emptyCell;
+    }
+
+    buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool DistanceFieldEngine::IsInBand(const Point3D& point) const{
+    if (cells.empty()) return false;
+    auto offset = CellOffset(static_cast<int64_t>(std::floor((point.GetX() - origin.GetX()) / cellSize)),
+                             static_cast<int64_t>(std::floor((point.GetY() - origin.GetY()) / cellSize)),
+                             static_cast<int64_t>(std::floor((point.GetZ() - origin.GetZ()) / cellSize)));
+    return offset >= 0 && cells[offset] != emptyCell;
+}
+
+std::vector<std::pair<size_t, Point3D>> DistanceFieldEngine::FindNearestPoints(const Point3D& point) const{
+    if (!IsInBand(point))
+        return FindNearestPointsToPolyline(poly, point);
+
+    auto cx = static_cast<int64_t>(std::floor((point.GetX() - origin.GetX()) / cellSize));
+    auto cy = static_cast<int64_t>(std::floor((point.GetY() - origin.GetY()) / cellSize));
+    auto cz = static_cast<int64_t>(std::floor((point.GetZ() - origin.GetZ()) / cellSize));
+
+    /// Nearest segments of the cell of the point and of its neighbours
+    uint32_t segments[27];
+    size_t count = 0;
+    for (int dz = -1; dz <= 1; ++dz)
+        for (int dy = -1; dy <= 1; ++dy)
+            for (int dx = -1; dx <= 1; ++dx){
+                auto offset = CellOffset(cx + dx, cy + dy, cz + dz);
+                if (offset >= 0 && cells[offset] != emptyCell) segments[count++] = cells[offset];
+            }
+    std::sort(segments, segments + count);
+    count = static_cast<size_t>(std::unique(segments, segments + count) - segments);
+
+    const auto& nodes = poly.GetNodes();
+    std::vector<SegmentCandidate> candidates;
+    candidates.reserve(count);
+    for (size_t k = 0; k < count; ++k){
+        auto i = segments[k];
+        auto [nearest, dist] = NearestPointOnSegment(point, Segment3D {nodes[i], nodes[i + 1]});
+        candidates.push_back(SegmentCandidate{i, nearest, dist});
+    }
+    return SelectNearestCandidates(candidates);
+}
+
+double DistanceFieldEngine::GetMaxError() const{
+    return cellSize * std::sqrt(3.0);
+}
+
+size_t DistanceFieldEngine::GetMemoryUsage() const{
+    return sizeof(*this) + cells.capacity() * sizeof(uint32_t) +
+           brickIndex.size() * (sizeof(uint64_t) + sizeof(uint32_t) + 2 * sizeof(void*)) +
+           brickIndex.bucket_count() * sizeof(void*);
+}
@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include "static/GeometryObjects.h"
+#include "static/SegmentIndex.h"
+#include "static/SegmentKernel.h"
+#include "static/DistanceQueries.h"
+#include <vector>
+
+namespace{
+
+using Kernel = SegmentKernel<3>;
+
+Kernel::Coords ToCoords(const Point3D& point){
+    return {point.GetX(), point.GetY(), point.GetZ()};
+}
+
+/// Squared distance from a point to segment i of the nodes.
+double SquaredDistanceToSegment(const Kernel::Coords& query, const std::vector<Point3D>& nodes, size_t i){
+    double t;
+    return Kernel::SquaredDistance(query, ToCoords(nodes[i]), ToCoords(nodes[i + 1]), t);
+}
+
+void CheckMaxDistance(double maxDistance){
+    if (!(maxDistance >= 0.0))
+        throw std::invalid_argument("Distance must be non-negative");
+}
+
+void CheckIndex(const Polyline3D& poly, const SegmentIndex& index){
+    if (index.GetPolylineNodesCount() != poly.GetNodesCount())
+        throw std::invalid_argument("Segment index belongs to another polyline");
+}
+
+/**
+ * @brief Visits the segments of an index nearest subtree first, skipping subtrees beyond a bound.
+ *
+ * @param limit Squared bound; subtrees at or beyond it are skipped, nearer segments lower it.
+ * @param stopAt The traversal ends as soon as the limit is at most this value.
+ * @return The final squared limit.
+ */
+double TraverseIndex(const Polyline3D& poly, const SegmentIndex& index, const Point3D& point, double limit,
+                     double stopAt){
+    if (index.GetNodesCount() == 0)
+        return limit;
+
+    const auto& nodes = poly.GetNodes();
+    const auto* tree = index.GetNodes();
+    const auto query = ToCoords(point);
+    auto bound = [&](uint32_t node){
+        return Kernel::SquaredDistanceToBox(query, tree[node].boxMin, tree[node].boxMax);
+    };
+
+    std::vector<std::pair<uint32_t, double>> stack;
+    stack.reserve(64);
+    stack.push_back({0, bound(0)});
+    while (!stack.empty()){
+        auto [current, squared] = stack.back();
+        stack.pop_back();
+        if (squared >= limit)
+            continue;
+
+        const auto& node = tree[current];
+        if (node.right == 0){
+            for (auto i = static_cast<size_t>(node.first); i < static_cast<size_t>(node.first) + node.count; ++i){
+                limit = std::min(limit, SquaredDistanceToSegment(query, nodes, i));
+                if (limit <= stopAt)
+                    return limit;
+            }
+            continue;
+        }
+
+        /// Descend into the nearer child first
+        std::pair<uint32_t, double> left{current + 1, bound(current + 1)};
+        std::pair<uint32_t, double> right{node.right, bound(node.right)};
+        if (left.second < right.second) std::swap(left, right);
+        if (left.second < limit) stack.push_back(left);
+        if (right.second < limit) stack.push_back(right);
+    }
+    return limit;
+}
+
+}
+
+double DistanceToPolyline(const Polyline3D& poly, const Point3D& point){
+    const auto& nodes = poly.GetNodes();
+    const auto query = ToCoords(point);
+    auto best = std::numeric_limits<double>::infinity();
+    for (size_t i = 0; i + 1 < nodes.size(); ++i){
+        best = std::min(best, SquaredDistanceToSegment(query, nodes, i));
+        if (best == 0.0)
+            break;
+    }
+    return std::sqrt(best);
+}
+
+bool IsWithinDistance(const Polyline3D& poly, const Point3D& point, double maxDistance){
+    CheckMaxDistance(maxDistance);
+    const auto& nodes = poly.GetNodes();
+    const auto query = ToCoords(point);
+    auto squaredMax = maxDistance * maxDistance;
+    for (size_t i = 0; i + 1 < nodes.size(); ++i){
+        if (SquaredDistanceToSegment(query, nodes, i) <= squaredMax)
+            return true;
+    }
+    return false;
+}
+
+double DistanceToIndexedPolyline(const Polyline3D& poly, const SegmentIndex& index, const Point3D& point){
+    CheckIndex(poly, index);
+    return std::sqrt(TraverseIndex(poly, index, point, std::numeric_limits<double>::infinity(), 0.0));
+}
+
+bool IsWithinDistance(const Polyline3D& poly, const SegmentIndex& index, const Point3D& point, double maxDistance){
+    CheckMaxDistance(maxDistance);
+    CheckIndex(poly, index);
+    if (index.GetNodesCount() == 0)
+        return false;
+    auto squaredMax = maxDistance * maxDistance;
+    /// Segments beyond the distance leave the limit above it
+    return TraverseIndex(poly, index, point, std::nextafter(squaredMax, std::numeric_limits<double>::infinity()),
+                         squaredMax) <= squaredMax;
+}
@@ -1,8 +1,13 @@
 #include "static/GeometryObjects.h"
 #include "static/3DMathOperations.h"
+#include <atomic>
 #include <vector>
 #include <tuple>
 #include <cmath>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
 
 Primitive3D::Primitive3D() : x(0.0), y(0.0), z(0.0) {}
 Primitive3D::Primitive3D(double _x, double _y, double _z) : x(_x), y(_y), z(_z) {}
@@ -47,19 +52,55 @@ Vector3D::Vector3D(const Point3D& pointA, const Point3D& pointB){
     z = pointB.GetZ() - pointA.GetZ();
 }
 
-Polyline3D::Polyline3D() = default;
-Polyline3D::Polyline3D(const std::vector<Point3D>& points) : nodes(points) {}
+/// Returns a new process-wide unique polyline revision.
+static uint64_t NextRevision(){
+    static std::atomic<uint64_t> counter{0};
+    return ++counter;
+}
+
+Polyline3D::Polyline3D() : revision(NextRevision()) {}
+Polyline3D::Polyline3D(const std::vector<Point3D>& points) : nodes(points), revision(NextRevision()) {}
 Polyline3D::Polyline3D(std::vector<Point3D>&& points) noexcept : 
-                                    nodes(std::move(points)) {}
+                                    nodes(std::move(points)), revision(NextRevision()) {}
 
+Polyline3D::Polyline3D(Polyline3D&& other) noexcept : 
+                                    nodes(std::move(other.nodes)), revision(other.revision){
+    other.nodes.clear();
+    other.revision = NextRevision();
+}
+
+Polyline3D& Polyline3D::operator=(Polyline3D&& other) noexcept{
+    if (this != &other){
+        nodes = std::move(other.nodes);
+        revision = other.revision;
+        other.nodes.clear();
+        other.revision = NextRevision();
+    }
+    return *this;
+}
 
 void Polyline3D::SetNodes(const std::vector<Point3D>& points){
     nodes = points;
+    revision = NextRevision();
+}
+
+void Polyline3D::SetNode(size_t index, const Point3D& point){
+    if (index >= nodes.size())
+        throw std::out_of_range("Polyline has no node " + std::to_string(index));
+    nodes[index] = point;
+    revision = NextRevision();
 }
 
-std::vector<Point3D> Polyline3D::GetNodes() const {return nodes;}
+const std::vector<Point3D>& Polyline3D::GetNodes() const {return nodes;}
 
-void Polyline3D::AddPoint(const Point3D& point){nodes.push_back(point);}
+size_t Polyline3D::GetMemoryUsage() const{
+    return sizeof(*this) + nodes.capacity() * sizeof(Point3D);
+}
+
+void Polyline3D::AddPoint(const Point3D& point){
+    nodes.push_back(point);
+    revision = NextRevision();
+}
 
 Segment3D::Segment3D() : start(Point3D()), end(Point3D()) {}
 Segment3D::Segment3D(const Point3D& point1, const Point3D& point2) : start(point1), end(point2) {}
@@ -68,3 +109,35 @@ Point3D Segment3D::GetStart() const{return start;}
 Point3D Segment3D::GetEnd() const{return end;}
 void Segment3D::SetStart(const Point3D& point){start = point;}
 void Segment3D::SetEnd(const Point3D& point){end = point;}
+
+Box3D::Box3D() : minCorner(std::numeric_limits<double>::max(), 
+                           std::numeric_limits<double>::max(), 
+                           std::numeric_limits<double>::max()),
+                 maxCorner(std::numeric_limits<double>::lowest(), 
+                           std::numeric_limits<double>::lowest(), 
+                           std::numeric_limits<double>::lowest()) {}
+Box3D::Box3D(const Point3D& minPoint, const Point3D& maxPoint) : minCorner(minPoint), maxCorner(maxPoint) {}
+
+Point3D Box3D::GetMin() const{return minCorner;}
+Point3D Box3D::GetMax() const{return maxCorner;}
+
+bool Box3D::IsEmpty() const{
+    return minCorner.GetX() > maxCorner.GetX() ||
+           minCorner.GetY() > maxCorner.GetY() ||
+           minCorner.GetZ() > maxCorner.GetZ();
+}
+
+void Box3D::Extend(const Point3D& point){
+    minCorner = Point3D{std::min(minCorner.GetX(), point.GetX()),
+                        std::min(minCorner.GetY(), point.GetY()),
+                        std::min(minCorner.GetZ(), point.GetZ())};
+    maxCorner = Point3D{std::max(maxCorner.GetX(), point.GetX()),
+                        std::max(maxCorner.GetY(), point.GetY()),
+                        std::max(maxCorner.GetZ(), point.GetZ())};
+}
+
+void Box3D::Extend(const Box3D& box){
+    if (box.IsEmpty()) return;
+    Extend(box.minCorner);
+    Extend(box.maxCorner);
+}
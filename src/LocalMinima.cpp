@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include "static/GeometryObjects.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/SegmentKernel.h"
+#include "static/LocalMinima.h"
+#include <vector>
+
+std::vector<LocalMinimum> FindNearestLocalMinima(const Polyline3D& poly, const SegmentIndex& index,
+                                                 const Point3D& point, size_t k){
+    if (index.GetPolylineNodesCount() != poly.GetNodesCount())
+        throw std::invalid_argument("Segment index belongs to another polyline");
+    if (k == 0 || index.GetNodesCount() == 0)
+        return {};
+
+    const auto& nodes = poly.GetNodes();
+    const auto* tree = index.GetNodes();
+    const auto segments = nodes.size() - 1;
+    const SegmentKernel<3>::Coords query{point.GetX(), point.GetY(), point.GetZ()};
+
+    auto degenerate = [&](size_t i){ return nodes[i] == nodes[i + 1]; };
+    auto nearest = [&](size_t i){ return NearestPointOnSegment(point, Segment3D {nodes[i], nodes[i + 1]}); };
+    auto previous = [&](size_t i) -> std::optional<size_t>{
+        while (i-- > 0){
+            if (!degenerate(i)) return i;
+        }
+        return std::nullopt;
+    };
+    auto next = [&](size_t i) -> std::optional<size_t>{
+        while (++i < segments){
+            if (!degenerate(i)) return i;
+        }
+        return std::nullopt;
+    };
+
+    /// The k best minima so far, the worst on top
+    auto worse = [](const LocalMinimum& elem1, const LocalMinimum& elem2){
+        return elem1.distance < elem2.distance || (elem1.distance == elem2.distance && elem1.segment < elem2.segment);
+    };
+    std::vector<LocalMinimum> best;
+    auto kth = [&]{ return best.size() < k ? std::numeric_limits<double>::max() : best.front().distance; };
+
+    using Entry = std::pair<double, uint32_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    queue.push({0.0, 0});
+
+    while (!queue.empty()){
+        auto [bound, current] = queue.top();
+        queue.pop();
+        if (bound > kth() + nearestCandidateMargin)
+            break;
+
+        const auto& node = tree[current];
+        if (node.right != 0){
+            for (auto child : {current + 1, node.right}){
+                queue.push({std::sqrt(SegmentKernel<3>::SquaredDistanceToBox(query, tree[child].boxMin, tree[child].boxMax)),
+                            child});
+            }
+            continue;
+        }
+
+        for (auto i = static_cast<size_t>(node.first); i < static_cast<size_t>(node.first) + node.count; ++i){
+            if (degenerate(i))
+                continue;
+            auto [closest, dist] = nearest(i);
+            if (dist > kth() + nearestCandidateMargin)
+                continue;
+
+            /// A minimum at the start node belongs to the previous segment, if there is one
+            if (closest == nodes[i] && previous(i))
+                continue;
+            /// A minimum at the end node is local only if the next segment also comes closest there
+            if (!(closest == nodes[i]) && closest == nodes[i + 1]){
+                auto following = next(i);
+                if (following && !(nearest(*following).first == nodes[*following]))
+                    continue;
+            }
+
+            best.push_back(LocalMinimum{i, closest, dist});
+            std::push_heap(best.begin(), best.end(), worse);
+            if (best.size() > k){
+                std::pop_heap(best.begin(), best.end(), worse);
+                best.pop_back();
+            }
+        }
+    }
+
+    std::sort_heap(best.begin(), best.end(), worse);
+    return best;
+}
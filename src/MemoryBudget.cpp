@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include "static/3DMathOperations.h"
+#include "static/GeometryObjects.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/SegmentIndex.h"
+#include "static/CompactSegmentIndex.h"
+#include "static/Trace.h"
+#include "static/MemoryBudget.h"
+#include <vector>
+
+namespace{
+
+/// Number of sample queries every index candidate is timed with.
+constexpr size_t sampleQueries = 256;
+/// Number of sample queries brute force is timed with.
+constexpr size_t bruteForceQueries = 8;
+/// Repetitions of every measurement, the fastest counts.
+constexpr int sampleRepetitions = 3;
+
+/// Keeps the results of the measured calls from being optimized away.
+std::atomic<size_t> sampleSink{0};
+
+/// Fastest of several runs of a function, in nanoseconds.
+template <typename Function>
+double FastestRun(const Function& function){
+    auto best = std::numeric_limits<double>::max();
+    for (int r = 0; r < sampleRepetitions; ++r){
+        auto start = std::chrono::steady_clock::now();
+        sampleSink += function();
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+        best = std::min(best, elapsed.count());
+    }
+    return std::max(best, 1.0);
+}
+
+/// Points next to evenly spaced segments of a polyline, at about a segment length from them.
+std::vector<Point3D> SampleQueries(const Polyline3D& poly, size_t count){
+    const auto& nodes = poly.GetNodes();
+    std::vector<Point3D> points;
+    for (size_t q = 0; q < count; ++q){
+        auto i = (nodes.size() - 1) * q / count;
+        auto length = DistanceBetweenPoints(nodes[i], nodes[i + 1]);
+        points.push_back(Point3D(nodes[i].GetX() + length, nodes[i].GetY() + 0.5 * length,
+                                 nodes[i].GetZ() - 0.3 * length));
+    }
+    return points;
+}
+
+/// A combination of leaf size and node format measured on the prefix.
+struct Candidate{
+    size_t leafSize;
+    bool compact;
+    size_t estimatedBytes;            ///< Size extrapolated to the whole polyline.
+    double nanoseconds;               ///< Time of the sample queries on the prefix.
+};
+
+std::string FormatBytes(size_t bytes){
+    const char* units[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+    auto value = static_cast<double>(bytes);
+    size_t unit = 0;
+    while (value >= 1024.0 && unit + 1 < std::size(units)){
+        value /= 1024.0;
+        ++unit;
+    }
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), unit == 0 ? "%.0f %s" : "%.1f %s", value, units[unit]);
+    return buffer;
+}
+
+}
+
+void WriteMemoryReport(std::ostream& output, const std::vector<MemoryReportEntry>& entries){
+    size_t width = 5;
+    size_t total = 0;
+    for (const auto& entry : entries){
+        width = std::max(width, entry.name.size());
+        total += entry.bytes;
+    }
+    auto line = [&](const std::string& name, size_t bytes){
+        output << name << std::string(width - name.size() + 2, ' ') << bytes << " bytes (" << FormatBytes(bytes) << ")\n";
+    };
+    for (const auto& entry : entries) line(entry.name, entry.bytes);
+    line("total", total);
+}
+
+BudgetedSegmentIndex::BudgetedSegmentIndex(const Polyline3D& poly, size_t memoryBudget)
+    : polylineNodes(poly.GetNodesCount()){
+    TraceScope trace("build_budgeted_index", "index");
+    report.memoryBudget = memoryBudget;
+    if (poly.GetNodesCount() < 2)
+        return;
+
+    /// Measure every candidate on a prefix and extrapolate its size to the whole polyline
+    const auto& nodes = poly.GetNodes();
+    auto segments = nodes.size() - 1;
+    Polyline3D prefix(std::vector<Point3D>(nodes.begin(), nodes.begin() + std::min(nodes.size(), sampleNodes)));
+    auto prefixSegments = prefix.GetNodesCount() - 1;
+    auto scale = static_cast<double>(segments) / prefixSegments;
+    auto queries = SampleQueries(prefix, sampleQueries);
+
+    /// Brute force grows with the number of segments, indexes hardly do
+    auto bruteForceTime = FastestRun([&]{
+        size_t found = 0;
+        for (size_t q = 0; q < bruteForceQueries; ++q){
+            found += FindNearestPointsToPolyline(prefix, queries[q * sampleQueries / bruteForceQueries]).size();
+        }
+        return found;
+    }) * sampleQueries / bruteForceQueries * scale;
+
+    /// Coarser leaves are tried until both formats fit, or until they are slower than brute force
+    std::vector<Candidate> candidates;
+    for (auto leafSize = SegmentIndex::defaultLeafSize; ; leafSize *= 2){
+        SegmentIndex full(prefix, leafSize);
+        CompactSegmentIndex small(full);
+        auto fullTime = FastestRun([&]{
+            size_t found = 0;
+            for (const auto& point : queries) found += FindNearestPointsToIndexedPolyline(prefix, full, point).size();
+            return found;
+        });
+        auto smallTime = FastestRun([&]{
+            size_t found = 0;
+            for (const auto& point : queries) found += FindNearestPointsToIndexedPolyline(prefix, small, point).size();
+            return found;
+        });
+        candidates.push_back(Candidate{leafSize, false, static_cast<size_t>(full.GetMemoryUsage() * scale), fullTime});
+        candidates.push_back(Candidate{leafSize, true, static_cast<size_t>(small.GetMemoryUsage() * scale), smallTime});
+        auto fits = candidates[candidates.size() - 2].estimatedBytes <= memoryBudget &&
+                    candidates.back().estimatedBytes <= memoryBudget;
+        if (fits || std::min(fullTime, smallTime) >= bruteForceTime || leafSize >= std::min(maxLeafSize, segments))
+            break;
+    }
+    auto defaultTime = candidates[0].nanoseconds;
+    report.defaultMemoryUsage = candidates[0].estimatedBytes;
+
+    std::stable_sort(candidates.begin(), candidates.end(), [](const auto& elem1, const auto& elem2){
+        return elem1.nanoseconds < elem2.nanoseconds;
+    });
+    for (const auto& candidate : candidates){
+        if (candidate.estimatedBytes > memoryBudget || candidate.nanoseconds >= bruteForceTime)
+            continue;
+        auto built = std::make_unique<SegmentIndex>(poly, candidate.leafSize);
+        if (candidate.compact){
+            auto converted = std::make_unique<CompactSegmentIndex>(*built);
+            built.reset();
+            if (converted->GetMemoryUsage() > memoryBudget)
+                continue;
+            compact = std::move(converted);
+            report.memoryUsage = compact->GetMemoryUsage();
+        }
+        else{
+            if (built->GetMemoryUsage() > memoryBudget)
+                continue;
+            index = std::move(built);
+            report.memoryUsage = index->GetMemoryUsage();
+        }
+        report.leafSize = candidate.leafSize;
+        report.compact = candidate.compact;
+        report.querySlowdown = candidate.nanoseconds / defaultTime;
+        return;
+    }
+    report.querySlowdown = bruteForceTime / defaultTime;
+}
+
+std::vector<std::pair<size_t, Point3D>> BudgetedSegmentIndex::FindNearestPoints(const Polyline3D& poly,
+                                                                                const Point3D& point) const{
+    if (poly.GetNodesCount() != polylineNodes)
+        throw std::invalid_argument("Segment index belongs to another polyline");
+    if (index)
+        return FindNearestPointsToIndexedPolyline(poly, *index, point);
+    if (compact)
+        return FindNearestPointsToIndexedPolyline(poly, *compact, point);
+    return FindNearestPointsToPolyline(poly, point);
+}
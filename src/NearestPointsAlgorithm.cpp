@@ -3,6 +3,7 @@
 #include <map>
 #include "static/GeometryObjects.h"
 #include "static/3DMathOperations.h"
+#include "static/NearestPointsAlgorithm.h"
 #include <vector>
 
 bool IsProjectionInSegment(const Point3D& point, const Segment3D& seg){
@@ -14,43 +15,28 @@ bool IsProjectionInSegment(const Point3D& point, const Segment3D& seg){
            std::max(seg.GetStart().GetZ(), seg.GetEnd().GetZ()) >= point.GetZ();
 }
 
-std::vector<std::pair<size_t, Point3D>> FindNearestPointsToPolyline(const Polyline3D& poly, const Point3D& point){
-    auto n = poly.GetNodesCount();
-    const auto nodes = poly.GetNodes();
+std::pair<Point3D, double> NearestPointOnSegment(const Point3D& point, const Segment3D& seg){
+    auto proj = PointProjectionOnLineThroughSegment(point, seg);
 
+    if (IsProjectionInSegment(proj, seg)){
+        return {proj, DistanceBetweenPoints(proj, point)};
+    }
+
+    auto dist1 = DistanceBetweenPoints(seg.GetStart(), point);
+    auto dist2 = DistanceBetweenPoints(seg.GetEnd(), point);
+    if (dist1 < dist2) 
+        return {seg.GetStart(), dist1};
+    return {seg.GetEnd(), dist2};
+}
+
+std::vector<std::pair<size_t, Point3D>> SelectNearestCandidates(const std::vector<SegmentCandidate>& candidates){
     std::map<Point3D, std::pair<size_t, double>> distances;
     double min_distance = std::numeric_limits<double>::max();
     std::vector<std::pair<size_t, Point3D>> answer;
 
-    if (n < 2)
-        return answer;
-
-    for (size_t i = 0; i < n - 1; ++i){
-        if (nodes[i] == nodes[i + 1]) 
-            continue;
-
-        Segment3D SegI (nodes[i], nodes[i + 1]);
-        auto proj = PointProjectionOnLineThroughSegment(point, SegI);
-
-        if (IsProjectionInSegment(proj, SegI)){
-            auto dist = DistanceBetweenPoints(proj, point);
-            distances.insert({proj, std::pair{i, dist}});
-            if (dist < min_distance) min_distance = dist;
-        }
-        else
-        {
-            auto dist1 = DistanceBetweenPoints(nodes[i], point);
-            auto dist2 = DistanceBetweenPoints(nodes[i + 1], point);
-            if (dist1 < dist2) {
-                distances.insert({nodes[i], std::pair{i, dist1}});
-                if (dist1 < min_distance) min_distance = dist1;
-            }
-            else
-            {
-                distances.insert({nodes[i + 1], std::pair{i, dist2}});
-                if (dist2 < min_distance) min_distance = dist2;
-            }
-        }
+    for (const auto& candidate : candidates){
+        distances.insert({candidate.point, std::pair{candidate.segment, candidate.distance}});
+        if (candidate.distance < min_distance) min_distance = candidate.distance;
     }
     for (const auto& pair : distances)
     {
@@ -66,4 +52,41 @@ std::vector<std::pair<size_t, Point3D>> FindNearestPointsToPolyline(const Polyli
     });
 
     return answer;
-}
\ No newline at end of file
+}
+
+std::vector<std::pair<size_t, Point3D>> FindNearestPointsToPolyline(const Polyline3D& poly, const Point3D& point){
+    auto n = poly.GetNodesCount();
+    const auto& nodes = poly.GetNodes();
+
+    std::vector<SegmentCandidate> candidates;
+
+    if (n < 2)
+        return {};
+
+    /// Only segments near the running minimum are kept, and the list is pruned whenever it doubles,
+    /// so memory does not grow with the polyline even if every segment comes closer
+    double min_distance = std::numeric_limits<double>::max();
+    auto prune = [&candidates, &min_distance]{
+        candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [min_distance](const auto& candidate){
+            return candidate.distance > min_distance + nearestCandidateMargin;
+        }), candidates.end());
+    };
+    size_t pruneAt = 64;
+    for (size_t i = 0; i < n - 1; ++i){
+        if (nodes[i] == nodes[i + 1]) 
+            continue;
+
+        auto [nearest, dist] = NearestPointOnSegment(point, Segment3D {nodes[i], nodes[i + 1]});
+        if (dist > min_distance + nearestCandidateMargin)
+            continue;
+        candidates.push_back(SegmentCandidate{i, nearest, dist});
+        if (dist < min_distance) min_distance = dist;
+        if (candidates.size() >= pruneAt){
+            prune();
+            pruneAt = std::max<size_t>(64, 2 * candidates.size());
+        }
+    }
+    prune();
+
+    return SelectNearestCandidates(candidates);
+}
@@ -0,0 +1,178 @@
+#include <atomic>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include "static/GeometryObjects.h"
+#include "static/3DMathOperations.h"
+#include "static/SegmentIndex.h"
+#include "static/DistanceQueries.h"
+#include "static/ParallelFor.h"
+#include "shared/NearestPointsC.h"
+#include <vector>
+
+struct np_polyline{
+    Polyline3D poly;
+    SegmentIndex index;
+};
+
+namespace{
+
+/// Converts the exception being handled into a status.
+np_status CurrentStatus(){
+    try{
+        throw;
+    } catch (const std::bad_alloc&){
+        return NP_ERROR_OUT_OF_MEMORY;
+    } catch (const std::invalid_argument&){
+        return NP_ERROR_INVALID_ARGUMENT;
+    } catch (...){
+        return NP_ERROR_INTERNAL;
+    }
+}
+
+/// Resolves a stride in bytes to a stride in doubles, 0 if it is invalid.
+size_t StrideInDoubles(size_t stride){
+    if (stride == 0) return 3;
+    if (stride % sizeof(double) != 0 || stride < 3 * sizeof(double)) return 0;
+    return stride / sizeof(double);
+}
+
+Point3D PointAt(const double* coords, size_t stride, size_t i){
+    const auto* point = coords + i * stride;
+    return Point3D(point[0], point[1], point[2]);
+}
+
+/**
+ * @brief Runs query(i) for every point on several threads and collects the first failure.
+ */
+template <typename Query>
+np_status ForEachPoint(size_t count, size_t threads, const Query& query){
+    std::atomic<int> status{NP_OK};
+    try{
+        ParallelFor(count, threads, [&](size_t first, size_t last){
+            try{
+                for (auto i = first; i < last; ++i) query(i);
+            } catch (...){
+                int expected = NP_OK;
+                status.compare_exchange_strong(expected, CurrentStatus());
+            }
+        });
+    } catch (...){
+        /// Only the bookkeeping of ParallelFor throws here, e.g. when allocating its threads
+        return CurrentStatus();
+    }
+    return static_cast<np_status>(status.load());
+}
+
+}
+
+extern "C" {
+
+int np_abi_version(void){
+    return NP_ABI_VERSION;
+}
+
+const char* np_status_message(np_status status){
+    switch (status){
+        case NP_OK: return "Success";
+        case NP_ERROR_INVALID_ARGUMENT: return "Invalid argument";
+        case NP_ERROR_BUFFER_TOO_SMALL: return "Output buffer too small";
+        case NP_ERROR_OUT_OF_MEMORY: return "Out of memory";
+        case NP_ERROR_INTERNAL: return "Internal error";
+    }
+    return "Unknown status";
+}
+
+np_status np_polyline_create(const double* coords, size_t count, size_t stride, np_polyline** polyline){
+    auto step = StrideInDoubles(stride);
+    if (!polyline || step == 0 || (count != 0 && !coords))
+        return NP_ERROR_INVALID_ARGUMENT;
+    try{
+        std::vector<Point3D> nodes;
+        nodes.reserve(count);
+        for (size_t i = 0; i < count; ++i) nodes.push_back(PointAt(coords, step, i));
+        Polyline3D poly(std::move(nodes));
+        SegmentIndex index(poly);
+        *polyline = new np_polyline{std::move(poly), std::move(index)};
+        return NP_OK;
+    } catch (...){
+        return CurrentStatus();
+    }
+}
+
+void np_polyline_destroy(np_polyline* polyline){
+    delete polyline;
+}
+
+np_status np_polyline_nodes_count(const np_polyline* polyline, size_t* count){
+    if (!polyline || !count)
+        return NP_ERROR_INVALID_ARGUMENT;
+    *count = polyline->poly.GetNodesCount();
+    return NP_OK;
+}
+
+np_status np_nearest_points(const np_polyline* polyline, const double* points, size_t count, size_t stride,
+                            size_t threads, size_t* segments, double* nearest, double* distances){
+    auto step = StrideInDoubles(stride);
+    if (!polyline || step == 0 || (count != 0 && !points))
+        return NP_ERROR_INVALID_ARGUMENT;
+    return ForEachPoint(count, threads, [&](size_t i){
+        auto point = PointAt(points, step, i);
+        auto ans = FindNearestPointsToIndexedPolyline(polyline->poly, polyline->index, point);
+        auto found = !ans.empty();
+        auto nan = std::numeric_limits<double>::quiet_NaN();
+        if (segments) segments[i] = found ? ans[0].first : std::numeric_limits<size_t>::max();
+        if (nearest){
+            nearest[3 * i] = found ? ans[0].second.GetX() : nan;
+            nearest[3 * i + 1] = found ? ans[0].second.GetY() : nan;
+            nearest[3 * i + 2] = found ? ans[0].second.GetZ() : nan;
+        }
+        if (distances)
+            distances[i] = found ? DistanceBetweenPoints(point, ans[0].second) : std::numeric_limits<double>::infinity();
+    });
+}
+
+np_status np_nearest_points_all(const np_polyline* polyline, const double* point, size_t capacity,
+                                size_t* segments, double* nearest, size_t* found){
+    if (!polyline || !point || !found)
+        return NP_ERROR_INVALID_ARGUMENT;
+    try{
+        auto ans = FindNearestPointsToIndexedPolyline(polyline->poly, polyline->index, PointAt(point, 3, 0));
+        *found = ans.size();
+        if (ans.size() > capacity)
+            return NP_ERROR_BUFFER_TOO_SMALL;
+        for (size_t i = 0; i < ans.size(); ++i){
+            if (segments) segments[i] = ans[i].first;
+            if (nearest){
+                nearest[3 * i] = ans[i].second.GetX();
+                nearest[3 * i + 1] = ans[i].second.GetY();
+                nearest[3 * i + 2] = ans[i].second.GetZ();
+            }
+        }
+        return NP_OK;
+    } catch (...){
+        return CurrentStatus();
+    }
+}
+
+np_status np_distances(const np_polyline* polyline, const double* points, size_t count, size_t stride,
+                       size_t threads, double* distances){
+    auto step = StrideInDoubles(stride);
+    if (!polyline || step == 0 || (count != 0 && (!points || !distances)))
+        return NP_ERROR_INVALID_ARGUMENT;
+    return ForEachPoint(count, threads, [&](size_t i){
+        distances[i] = DistanceToIndexedPolyline(polyline->poly, polyline->index, PointAt(points, step, i));
+    });
+}
+
+np_status np_within_distance(const np_polyline* polyline, const double* points, size_t count, size_t stride,
+                             double maxDistance, size_t threads, uint8_t* within){
+    auto step = StrideInDoubles(stride);
+    if (!polyline || step == 0 || !(maxDistance >= 0.0) || (count != 0 && (!points || !within)))
+        return NP_ERROR_INVALID_ARGUMENT;
+    return ForEachPoint(count, threads, [&](size_t i){
+        within[i] = IsWithinDistance(polyline->poly, polyline->index, PointAt(points, step, i), maxDistance) ? 1 : 0;
+    });
+}
+
+}
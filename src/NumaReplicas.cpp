@@ -0,0 +1,200 @@
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include "static/GeometryObjects.h"
+#include "static/SegmentIndex.h"
+#include "static/Trace.h"
+#include "static/NumaReplicas.h"
+#include <vector>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace{
+
+/// CPUs this process may run on.
+std::vector<size_t> UsableCpus(){
+    std::vector<size_t> cpus;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0){
+        for (size_t cpu = 0; cpu < CPU_SETSIZE; ++cpu){
+            if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+        }
+    }
+#endif
+    if (cpus.empty()){
+        for (size_t cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); ++cpu) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+/// Parses a CPU list such as "0-3,8,10-11"; an invalid list yields no CPUs.
+std::vector<size_t> ParseCpuList(const std::string& text){
+    std::vector<size_t> cpus;
+    std::stringstream ranges(text);
+    std::string range;
+    while (std::getline(ranges, range, ',')){
+        if (range.empty() || range == "\n")
+            continue;
+        try{
+            auto dash = range.find('-');
+            auto first = std::stoul(range.substr(0, dash));
+            auto last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+            for (auto cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+        } catch (const std::exception&){
+            return {};
+        }
+    }
+    return cpus;
+}
+
+}
+
+NumaTopology NumaTopology::Detect(){
+    auto usable = UsableCpus();
+    NumaTopology topology;
+
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator("/sys/devices/system/node", error)){
+        auto name = entry.path().filename().string();
+        if (name.rfind("node", 0) != 0 || name.size() == 4 ||
+            !std::all_of(name.begin() + 4, name.end(), [](char c){ return c >= '0' && c <= '9'; }))
+            continue;
+        std::ifstream file(entry.path() / "cpulist");
+        std::string text;
+        std::getline(file, text);
+
+        /// Nodes with memory only, or with CPUs outside the affinity mask, get no workers
+        NumaNode node{std::stoul(name.substr(4)), {}};
+        for (auto cpu : ParseCpuList(text)){
+            if (std::binary_search(usable.begin(), usable.end(), cpu)) node.cpus.push_back(cpu);
+        }
+        if (!node.cpus.empty()) topology.nodes.push_back(std::move(node));
+    }
+    std::sort(topology.nodes.begin(), topology.nodes.end(), [](const auto& elem1, const auto& elem2){
+        return elem1.id < elem2.id;
+    });
+    if (topology.nodes.empty()) topology.nodes.push_back(NumaNode{0, usable});
+    return topology;
+}
+
+NumaTopology NumaTopology::Simulate(size_t nodesCount){
+    if (nodesCount == 0)
+        throw std::invalid_argument("A topology needs at least one node");
+    auto usable = UsableCpus();
+    NumaTopology topology;
+    for (size_t n = 0; n < nodesCount; ++n){
+        NumaNode node{n, {}};
+        for (auto c = usable.size() * n / nodesCount; c < usable.size() * (n + 1) / nodesCount; ++c){
+            node.cpus.push_back(usable[c]);
+        }
+        if (node.cpus.empty()) node.cpus.push_back(usable[n % usable.size()]);
+        topology.nodes.push_back(std::move(node));
+    }
+    return topology;
+}
+
+NumaTopology NumaTopology::GetFirstNodes(size_t nodesCount) const{
+    NumaTopology first;
+    first.nodes.assign(nodes.begin(), nodes.begin() + std::min(nodesCount, nodes.size()));
+    return first;
+}
+
+bool PinThreadToCpus(const std::vector<size_t>& cpus){
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (auto cpu : cpus){
+        if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    return CPU_COUNT(&set) > 0 && pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
+
+ReplicatedPolyline3D::ReplicatedPolyline3D(const Polyline3D& poly, NumaTopology _topology, bool _replicated,
+                                           size_t leafSize) : topology(std::move(_topology)){
+    TraceScope trace("replicate_polyline", "prepare");
+    if (leafSize == 0)
+        throw std::invalid_argument("Leaf size must be positive");
+    if (topology.nodes.empty()) topology.nodes.push_back(NumaNode{0, UsableCpus()});
+    auto pinned = topology.nodes.size() > 1;
+    replicated = _replicated && pinned;
+
+    /// Each replica is written by a thread on its node, so that its pages are allocated there
+    replicas.resize(replicated ? topology.nodes.size() : 1);
+    std::vector<std::exception_ptr> errors(replicas.size());
+    std::vector<std::thread> builders;
+    for (size_t r = 0; r < replicas.size(); ++r){
+        builders.emplace_back([&, r]{
+            try{
+                if (pinned) PinThreadToCpus(topology.nodes[r].cpus);
+                auto replica = std::make_unique<Replica>();
+                replica->poly = poly;
+                replica->index = std::make_unique<SegmentIndex>(replica->poly, leafSize);
+                replicas[r] = std::move(replica);
+            } catch (...){
+                errors[r] = std::current_exception();
+            }
+        });
+    }
+    for (auto& builder : builders) builder.join();
+    for (const auto& error : errors){
+        if (error) std::rethrow_exception(error);
+    }
+}
+
+const Polyline3D& ReplicatedPolyline3D::GetPolyline(size_t node) const{
+    return replicas[replicated ? node : 0]->poly;
+}
+
+size_t ReplicatedPolyline3D::GetMemoryUsage() const{
+    auto usage = sizeof(*this) + replicas.capacity() * sizeof(replicas[0]);
+    for (const auto& node : topology.nodes) usage += sizeof(NumaNode) + node.cpus.capacity() * sizeof(size_t);
+    for (const auto& replica : replicas){
+        usage += sizeof(Replica) - sizeof(Polyline3D) + replica->poly.GetMemoryUsage() + replica->index->GetMemoryUsage();
+    }
+    return usage;
+}
+
+std::vector<std::vector<std::pair<size_t, Point3D>>> ReplicatedPolyline3D::FindNearestPoints(
+    const std::vector<Point3D>& points, size_t threadsPerNode) const{
+    TraceScope trace("replicated_queries", "query");
+    auto pinned = topology.nodes.size() > 1;
+
+    /// Workers in node order, so that every node answers a contiguous range of points
+    std::vector<size_t> workerNodes;
+    for (size_t n = 0; n < topology.nodes.size(); ++n){
+        auto threads = threadsPerNode == 0 ? topology.nodes[n].cpus.size() : threadsPerNode;
+        workerNodes.insert(workerNodes.end(), threads, n);
+    }
+    auto count = points.size();
+    auto workersCount = std::max<size_t>(1, std::min(workerNodes.size(), count));
+
+    std::vector<std::vector<std::pair<size_t, Point3D>>> results(count);
+    auto work = [&](size_t w){
+        auto node = workerNodes[w];
+        if (pinned) PinThreadToCpus(topology.nodes[node].cpus);
+        const auto& replica = *replicas[replicated ? node : 0];
+        for (auto i = count * w / workersCount; i < count * (w + 1) / workersCount; ++i){
+            results[i] = FindNearestPointsToIndexedPolyline(replica.poly, *replica.index, points[i]);
+        }
+    };
+    if (workersCount == 1 && !pinned){
+        work(0);
+        return results;
+    }
+    std::vector<std::thread> workers;
+    for (size_t w = 0; w < workersCount; ++w) workers.emplace_back(work, w);
+    for (auto& worker : workers) worker.join();
+    return results;
+}
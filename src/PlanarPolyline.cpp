@@ -0,0 +1,272 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "static/GeometryObjects.h"
+#include "static/3DMathOperations.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/Trace.h"
+#include "static/PlanarPolyline.h"
+#include <vector>
+
+/// Upper bound of the number of grid cells per segment.
+static constexpr size_t maxCellsPerSegment = 4;
+
+PlanarPolyline3D::PlanarPolyline3D(const Polyline3D& _poly, double tolerance){
+    TraceScope trace("prepare_planar", "prepare");
+    const auto& points = _poly.GetNodes();
+    if (points.size() < 2 || !DetectPlane(points, tolerance)){
+        poly = _poly;
+        return;
+    }
+
+    planar = true;
+    nodes.reserve(points.size());
+    for (const auto& node : points){
+        Vector3D offset(origin, node);
+        nodes.push_back(Coords{ScalarProduct(offset, axisU), ScalarProduct(offset, axisV)});
+    }
+    BuildGrid(points);
+}
+
+bool PlanarPolyline3D::DetectPlane(const std::vector<Point3D>& points, double tolerance){
+    const auto& first = points.front();
+
+    /// Span the plane by the node farthest from the first one and the node farthest from that line
+    size_t far = 0;
+    auto far_distance = 0.0;
+    for (size_t i = 1; i < points.size(); ++i){
+        auto dist = DistanceBetweenPoints(first, points[i]);
+        if (dist > far_distance){
+            far_distance = dist;
+            far = i;
+        }
+    }
+
+    if (far_distance <= tolerance){
+        normal = Vector3D(0.0, 0.0, 1.0);
+    }
+    else{
+        Vector3D direction(first, points[far]);
+        auto unit = NormalizedVector(direction);
+
+        size_t side = 0;
+        auto side_distance = 0.0;
+        for (size_t i = 1; i < points.size(); ++i){
+            Vector3D offset(first, points[i]);
+            auto along = ScalarProduct(offset, unit);
+            auto dist = LengthOfVector(Vector3D{offset.GetX() - along * unit.GetX(),
+                                                offset.GetY() - along * unit.GetY(),
+                                                offset.GetZ() - along * unit.GetZ()});
+            if (dist > side_distance){
+                side_distance = dist;
+                side = i;
+            }
+        }
+
+        if (side_distance <= tolerance){
+            /// Collinear nodes: any plane through the line will do
+            auto axis = std::abs(unit.GetX()) < std::abs(unit.GetZ()) ? Vector3D(1.0, 0.0, 0.0)
+                                                                      : Vector3D(0.0, 0.0, 1.0);
+            normal = NormalizedVector(VectorProduct(unit, axis));
+        }
+        else{
+            normal = NormalizedVector(VectorProduct(direction, Vector3D(first, points[side])));
+        }
+    }
+
+    /// Make the largest component positive, so that the frame does not depend on the node order
+    auto largest = std::max({std::abs(normal.GetX()), std::abs(normal.GetY()), std::abs(normal.GetZ())});
+    auto sign = (std::abs(normal.GetX()) == largest ? normal.GetX() :
+                 std::abs(normal.GetY()) == largest ? normal.GetY() : normal.GetZ()) < 0.0 ? -1.0 : 1.0;
+    normal = VectorMultipliedByScalar(normal, sign);
+
+    for (const auto& node : points){
+        if (std::abs(ScalarProduct(Vector3D(first, node), normal)) > tolerance)
+            return false;
+    }
+
+    /// The world axis least aligned with the normal, projected onto the plane, is the first axis
+    Vector3D axes[3] = {Vector3D(1.0, 0.0, 0.0), Vector3D(0.0, 1.0, 0.0), Vector3D(0.0, 0.0, 1.0)};
+    auto axis = *std::min_element(std::begin(axes), std::end(axes), [this](const auto& axis1, const auto& axis2){
+        return std::abs(ScalarProduct(axis1, normal)) < std::abs(ScalarProduct(axis2, normal));
+    });
+    auto along = ScalarProduct(axis, normal);
+    axisU = NormalizedVector(Vector3D{axis.GetX() - along * normal.GetX(),
+                                      axis.GetY() - along * normal.GetY(),
+                                      axis.GetZ() - along * normal.GetZ()});
+    axisV = VectorProduct(normal, axisU);
+
+    auto height = ScalarProduct(Vector3D(Point3D(), first), normal);
+    origin = Point3D{normal.GetX() * height, normal.GetY() * height, normal.GetZ() * height};
+    return true;
+}
+
+void PlanarPolyline3D::BuildGrid(const std::vector<Point3D>& points){
+    Coords low{std::numeric_limits<double>::max(), std::numeric_limits<double>::max()};
+    Coords high{std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest()};
+    for (const auto& node : nodes){
+        for (int axis = 0; axis < 2; ++axis){
+            low[axis] = std::min(low[axis], node[axis]);
+            high[axis] = std::max(high[axis], node[axis]);
+        }
+    }
+
+    std::vector<uint32_t> segments;
+    auto total_length = 0.0;
+    for (size_t i = 0; i + 1 < points.size(); ++i){
+        if (points[i] == points[i + 1])
+            continue;
+        segments.push_back(static_cast<uint32_t>(i));
+        total_length += std::hypot(nodes[i + 1][0] - nodes[i][0], nodes[i + 1][1] - nodes[i][1]);
+    }
+    if (segments.empty()) return;
+
+    /// Cells about as large as a segment, but not more cells than the segments can fill
+    auto count = static_cast<double>(segments.size());
+    auto width = high[0] - low[0];
+    auto height = high[1] - low[1];
+    cellSize = std::max({total_length / count, std::sqrt(width * height / count), eps});
+    auto cells = [&]{
+        columns = static_cast<size_t>(width / cellSize) + 1;
+        rows = static_cast<size_t>(height / cellSize) + 1;
+        return columns * rows;
+    };
+    while (cells() > maxCellsPerSegment * segments.size() + 16) cellSize *= 2.0;
+    gridMin = low;
+
+    /// Split segments into pieces no longer than a cell and register them in the cells of the pieces' boxes
+    std::vector<std::pair<uint32_t, uint32_t>> entries;
+    auto cellOf = [this](double value, int axis){
+        auto limit = axis == 0 ? columns : rows;
+        auto cell = static_cast<int64_t>(std::floor((value - gridMin[axis]) / cellSize));
+        return static_cast<size_t>(std::clamp<int64_t>(cell, 0, static_cast<int64_t>(limit) - 1));
+    };
+    for (auto segment : segments){
+        const auto& start = nodes[segment];
+        const auto& end = nodes[segment + 1];
+        auto length = std::hypot(end[0] - start[0], end[1] - start[1]);
+        auto pieces = static_cast<size_t>(length / cellSize) + 1;
+        for (size_t piece = 0; piece < pieces; ++piece){
+            auto t0 = static_cast<double>(piece) / pieces;
+            auto t1 = static_cast<double>(piece + 1) / pieces;
+            Coords a{start[0] + t0 * (end[0] - start[0]), start[1] + t0 * (end[1] - start[1])};
+            Coords b{start[0] + t1 * (end[0] - start[0]), start[1] + t1 * (end[1] - start[1])};
+            for (auto row = cellOf(std::min(a[1], b[1]), 1); row <= cellOf(std::max(a[1], b[1]), 1); ++row){
+                for (auto column = cellOf(std::min(a[0], b[0]), 0); column <= cellOf(std::max(a[0], b[0]), 0); ++column){
+                    entries.push_back({static_cast<uint32_t>(row * columns + column), segment});
+                }
+            }
+        }
+    }
+    std::sort(entries.begin(), entries.end());
+    entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+
+    cellStart.assign(columns * rows + 1, 0);
+    cellSegments.reserve(entries.size());
+    for (const auto& [cell, segment] : entries){
+        ++cellStart[cell + 1];
+        cellSegments.push_back(segment);
+    }
+    for (size_t cell = 0; cell < columns * rows; ++cell) cellStart[cell + 1] += cellStart[cell];
+}
+
+Point3D PlanarPolyline3D::ToWorld(double u, double v) const{
+    return Point3D{origin.GetX() + u * axisU.GetX() + v * axisV.GetX(),
+                   origin.GetY() + u * axisU.GetY() + v * axisV.GetY(),
+                   origin.GetZ() + u * axisU.GetZ() + v * axisV.GetZ()};
+}
+
+std::vector<std::pair<size_t, Point3D>> PlanarPolyline3D::FindNearestPoints(const Point3D& point) const{
+    if (!planar)
+        return FindNearestPointsToPolyline(poly, point);
+    if (cellSegments.empty())
+        return {};
+
+    Vector3D offset(origin, point);
+    Coords query{ScalarProduct(offset, axisU), ScalarProduct(offset, axisV)};
+    auto w = ScalarProduct(offset, normal);
+
+    auto center = [&](int axis, size_t limit){
+        auto cell = std::floor((query[axis] - gridMin[axis]) / cellSize);
+        return static_cast<int64_t>(std::clamp(cell, 0.0, static_cast<double>(limit - 1)));
+    };
+    auto cx = center(0, columns);
+    auto cy = center(1, rows);
+
+    struct Candidate{
+        size_t segment;
+        double t;
+        double distance;
+    };
+    std::vector<Candidate> found;
+    auto min_distance = std::numeric_limits<double>::max();
+    /// Squared in-plane distance beyond which a segment cannot be within the margin of the nearest one
+    auto limit = [&]{
+        if (min_distance == std::numeric_limits<double>::max()) return min_distance;
+        auto reach = min_distance + nearestCandidateMargin;
+        return reach * reach - w * w;
+    };
+
+    auto visit = [&](int64_t column, int64_t row){
+        Coords cellLow{gridMin[0] + column * cellSize, gridMin[1] + row * cellSize};
+        Coords cellHigh{cellLow[0] + cellSize, cellLow[1] + cellSize};
+        if (Kernel::SquaredDistanceToBox(query, cellLow, cellHigh) > limit())
+            return;
+        auto cell = static_cast<size_t>(row) * columns + static_cast<size_t>(column);
+        for (auto i = cellStart[cell]; i < cellStart[cell + 1]; ++i){
+            auto segment = cellSegments[i];
+            auto t = 0.0;
+            auto squared = Kernel::SquaredDistance(query, nodes[segment], nodes[segment + 1], t);
+            auto dist = std::sqrt(squared + w * w);
+            if (dist > min_distance + nearestCandidateMargin)
+                continue;
+            found.push_back(Candidate{segment, t, dist});
+            if (dist < min_distance) min_distance = dist;
+        }
+    };
+
+    /// Visit rings of cells around the cell of the projected query point. Cells of ring r + 1 are at least
+    /// r cells away from that cell, and so from the query point itself
+    auto rings = static_cast<int64_t>(std::max(columns, rows));
+    for (int64_t r = 0; r <= rings; ++r){
+        for (auto row = std::max<int64_t>(cy - r, 0); row <= std::min<int64_t>(cy + r, rows - 1); ++row){
+            if (row == cy - r || row == cy + r){
+                for (auto column = std::max<int64_t>(cx - r, 0); column <= std::min<int64_t>(cx + r, columns - 1); ++column)
+                    visit(column, row);
+                continue;
+            }
+            if (cx - r >= 0) visit(cx - r, row);
+            if (cx + r < static_cast<int64_t>(columns)) visit(cx + r, row);
+        }
+        auto ring_distance = static_cast<double>(r) * cellSize;
+        if (ring_distance * ring_distance > limit())
+            break;
+    }
+
+    std::sort(found.begin(), found.end(), [](const auto& elem1, const auto& elem2){
+        return elem1.segment < elem2.segment;
+    });
+    std::vector<SegmentCandidate> candidates;
+    candidates.reserve(found.size());
+    for (size_t i = 0; i < found.size(); ++i){
+        /// A segment crossing several cells is found several times
+        if (i > 0 && found[i].segment == found[i - 1].segment)
+            continue;
+        if (found[i].distance > min_distance + nearestCandidateMargin)
+            continue;
+        const auto& start = nodes[found[i].segment];
+        const auto& end = nodes[found[i].segment + 1];
+        auto t = found[i].t;
+        candidates.push_back(SegmentCandidate{found[i].segment,
+                                              ToWorld(start[0] + t * (end[0] - start[0]),
+                                                      start[1] + t * (end[1] - start[1])),
+                                              found[i].distance});
+    }
+
+    return SelectNearestCandidates(candidates);
+}
+
+size_t PlanarPolyline3D::GetMemoryUsage() const{
+    return sizeof(*this) + poly.GetNodes().capacity() * sizeof(Point3D) + nodes.capacity() * sizeof(Coords) +
+           cellStart.capacity() * sizeof(uint32_t) + cellSegments.capacity() * sizeof(uint32_t);
+}
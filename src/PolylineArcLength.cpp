@@ -0,0 +1,82 @@
+#include <algorithm>
+#include <stdexcept>
+#include "static/GeometryObjects.h"
+#include "static/3DMathOperations.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/PolylineArcLength.h"
+#include <vector>
+
+ArcLengthTable::ArcLengthTable() = default;
+
+ArcLengthTable::ArcLengthTable(const Polyline3D& poly){
+    const auto& nodes = poly.GetNodes();
+    cumulativeLengths.reserve(nodes.size());
+
+    auto length = 0.0;
+    for (size_t i = 0; i < nodes.size(); ++i){
+        if (i > 0) length += DistanceBetweenPoints(nodes[i - 1], nodes[i]);
+        cumulativeLengths.push_back(length);
+    }
+}
+
+double ArcLengthTable::GetTotalLength() const{
+    return cumulativeLengths.empty() ? 0.0 : cumulativeLengths.back();
+}
+
+size_t ArcLengthTable::FindSegmentAtDistance(double distance) const{
+    /// The last node starts no segment, so the search is limited to the first n - 1 nodes
+    auto last = cumulativeLengths.end() - 1;
+    auto it = std::upper_bound(cumulativeLengths.begin(), last, std::max(distance, 0.0));
+    return static_cast<size_t>(it - cumulativeLengths.begin()) - 1;
+}
+
+size_t ArcLengthTable::GetMemoryUsage() const{
+    return sizeof(*this) + cumulativeLengths.capacity() * sizeof(double);
+}
+
+/// Creates a route position for a point known to lie on the given segment.
+static RoutePosition MakeRoutePosition(const Polyline3D& poly, const ArcLengthTable& table,
+                                       size_t segment, const Point3D& point){
+    const auto& nodes = poly.GetNodes();
+    Vector3D StartToEnd (nodes[segment], nodes[segment + 1]);
+    Vector3D StartToP (nodes[segment], point);
+
+    auto squared_length = ScalarProduct(StartToEnd, StartToEnd);
+    auto t = 0.0;
+    if (squared_length > 0.0)
+        t = std::clamp(ScalarProduct(StartToP, StartToEnd) / squared_length, 0.0, 1.0);
+
+    auto segment_length = table.GetCumulativeLength(segment + 1) - table.GetCumulativeLength(segment);
+    return RoutePosition{segment, point, t, table.GetCumulativeLength(segment) + t * segment_length};
+}
+
+std::vector<RoutePosition> FindNearestRoutePositions(const Polyline3D& poly, const ArcLengthTable& table,
+                                                     const Point3D& point){
+    if (table.GetNodesCount() != poly.GetNodesCount())
+        throw std::invalid_argument("FindNearestRoutePositions requires the table of the polyline");
+
+    std::vector<RoutePosition> answer;
+    for (const auto& pair : FindNearestPointsToPolyline(poly, point)){
+        answer.push_back(MakeRoutePosition(poly, table, pair.first, pair.second));
+    }
+    return answer;
+}
+
+RoutePosition PointAtDistance(const Polyline3D& poly, const ArcLengthTable& table, double distance){
+    if (poly.GetNodesCount() < 2 || table.GetNodesCount() != poly.GetNodesCount())
+        throw std::invalid_argument("PointAtDistance requires a polyline with at least two nodes and its table");
+
+    distance = std::clamp(distance, 0.0, table.GetTotalLength());
+    auto segment = table.FindSegmentAtDistance(distance);
+
+    const auto& nodes = poly.GetNodes();
+    auto segment_length = table.GetCumulativeLength(segment + 1) - table.GetCumulativeLength(segment);
+    auto t = 0.0;
+    if (segment_length > 0.0)
+        t = std::clamp((distance - table.GetCumulativeLength(segment)) / segment_length, 0.0, 1.0);
+
+    Point3D point {nodes[segment].GetX() + t * (nodes[segment + 1].GetX() - nodes[segment].GetX()),
+                   nodes[segment].GetY() + t * (nodes[segment + 1].GetY() - nodes[segment].GetY()),
+                   nodes[segment].GetZ() + t * (nodes[segment + 1].GetZ() - nodes[segment].GetZ())};
+    return RoutePosition{segment, point, t, distance};
+}
@@ -0,0 +1,276 @@
+#include <algorithm>
+#include <charconv>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include "static/GeometryObjects.h"
+#include "static/BatchQueries.h"
+#include "static/Trace.h"
+#include "static/QueryPipeline.h"
+#include <vector>
+
+namespace {
+
+/**
+ * @class BoundedQueue
+ * @brief Blocking FIFO queue with a limited capacity connecting two pipeline stages.
+ */
+template <typename T>
+class BoundedQueue{
+private:
+    std::deque<T> items;
+    std::mutex mutex;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+    size_t capacity;
+    bool closed = false;
+public:
+    explicit BoundedQueue(size_t _capacity) : capacity(_capacity) {}
+
+    /// Adds an item, waits while the queue is full. Returns false if the queue has been closed.
+    bool Push(T item){
+        std::unique_lock lock(mutex);
+        notFull.wait(lock, [this]{ return items.size() < capacity || closed; });
+        if (closed) return false;
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    /// Takes the next item, waits while the queue is empty. Returns nothing once closed and drained.
+    std::optional<T> Pop(){
+        std::unique_lock lock(mutex);
+        notEmpty.wait(lock, [this]{ return !items.empty() || closed; });
+        if (items.empty()) return std::nullopt;
+        auto item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return item;
+    }
+
+    /// Wakes up all waiting threads; remaining items can still be taken.
+    void Close(){
+        std::lock_guard lock(mutex);
+        closed = true;
+        notFull.notify_all();
+        notEmpty.notify_all();
+    }
+};
+
+/// Query points of one chunk together with the number of its first query.
+struct QueryChunk{
+    size_t firstQuery;
+    std::vector<Point3D> points;
+};
+
+/// Results of one chunk together with the number of its first query.
+struct ResultChunk{
+    size_t firstQuery;
+    std::vector<std::vector<std::pair<size_t, Point3D>>> results;
+};
+
+constexpr size_t readBlockSize = 1 << 20;
+constexpr size_t queueCapacity = 4;
+
+bool IsSpace(char c){
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+/// True on hosts that store the least significant byte first.
+bool IsLittleEndian(){
+    const uint16_t probe = 1;
+    unsigned char first = 0;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+/// Appends the bytes of a value in little-endian order, whatever the byte order of the host.
+template <typename T>
+void AppendBinary(std::string& buffer, T value){
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    if (!IsLittleEndian()) std::reverse(bytes, bytes + sizeof(T));
+    buffer.append(bytes, sizeof(T));
+}
+
+template <typename T>
+void AppendText(std::string& buffer, T value){
+    char chars[32];
+    auto [end, ec] = std::to_chars(chars, chars + sizeof(chars), value);
+    buffer.append(chars, end);
+}
+
+} // namespace
+
+void ParseQueryPoints(const std::string& text, size_t firstLine, std::vector<Point3D>& points){
+    TraceScope trace("parse_queries", "load");
+    const char* pos = text.data();
+    const char* end = pos + text.size();
+    auto line = firstLine;
+
+    while (pos < end){
+        const char* lineEnd = static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+        if (lineEnd == nullptr) lineEnd = end;
+
+        double coords[3];
+        int count = 0;
+        while (true){
+            while (pos < lineEnd && IsSpace(*pos)) ++pos;
+            if (pos == lineEnd) break;
+            if (count == 3)
+                throw std::invalid_argument("Too many coordinates at line " + std::to_string(line));
+
+            auto [next, ec] = std::from_chars(pos, lineEnd, coords[count]);
+            if (ec == std::errc::result_out_of_range)
+                throw std::out_of_range("Coordinate out of range at line " + std::to_string(line));
+            if (ec != std::errc() || (next < lineEnd && !IsSpace(*next)))
+                throw std::invalid_argument("Invalid coordinate at line " + std::to_string(line));
+            pos = next;
+            ++count;
+        }
+        if (count == 3)
+            points.push_back(Point3D{coords[0], coords[1], coords[2]});
+        else if (count != 0)
+            throw std::invalid_argument("Expected three coordinates at line " + std::to_string(line));
+
+        pos = lineEnd + 1;
+        ++line;
+    }
+}
+
+void FormatQueryResults(const std::vector<std::vector<std::pair<size_t, Point3D>>>& results,
+                        size_t firstQuery, BatchOutputFormat format, std::string& buffer){
+    TraceScope trace("format_results", "output");
+    for (size_t i = 0; i < results.size(); ++i){
+        const auto& ans = results[i];
+        if (format == BatchOutputFormat::Binary){
+            AppendBinary<uint64_t>(buffer, firstQuery + i + 1);
+            AppendBinary<uint32_t>(buffer, static_cast<uint32_t>(ans.size()));
+            for (const auto& pair : ans){
+                AppendBinary<uint64_t>(buffer, pair.first + 1);
+                AppendBinary(buffer, pair.second.GetX());
+                AppendBinary(buffer, pair.second.GetY());
+                AppendBinary(buffer, pair.second.GetZ());
+            }
+            continue;
+        }
+
+        AppendText(buffer, firstQuery + i + 1);
+        buffer.push_back(' ');
+        AppendText(buffer, ans.size());
+        for (const auto& pair : ans){
+            buffer.push_back(' ');
+            AppendText(buffer, pair.first + 1);
+            buffer.push_back(' ');
+            AppendText(buffer, pair.second.GetX());
+            buffer.push_back(' ');
+            AppendText(buffer, pair.second.GetY());
+            buffer.push_back(' ');
+            AppendText(buffer, pair.second.GetZ());
+        }
+        buffer.push_back('\n');
+    }
+}
+
+size_t RunQueryPipeline(const Polyline3D& poly, std::istream& input, std::ostream& output, BatchOutputFormat format,
+                        const EngineCalibration* calibration){
+    BoundedQueue<QueryChunk> queries(queueCapacity);
+    BoundedQueue<ResultChunk> results(queueCapacity);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    auto fail = [&](std::exception_ptr e){
+        std::lock_guard lock(errorMutex);
+        if (!error) error = e;
+        queries.Close();
+        results.Close();
+    };
+
+    /// Stage 1: read blocks of text and parse complete lines into chunks of points
+    std::thread reader([&]{
+        if (IsTracing()) SetTraceThreadName("pipeline_reader");
+        try{
+            std::string pending;
+            std::vector<char> block(readBlockSize);
+            size_t line = 1;
+            size_t queryCount = 0;
+            std::vector<Point3D> points;
+
+            auto flush = [&](bool all){
+                while (points.size() >= pipelineChunkSize || (all && !points.empty())){
+                    auto size = std::min(points.size(), pipelineChunkSize);
+                    QueryChunk chunk{queryCount, std::vector<Point3D>(points.begin(), points.begin() + size)};
+                    points.erase(points.begin(), points.begin() + size);
+                    queryCount += size;
+                    if (!queries.Push(std::move(chunk))) return false;
+                }
+                return true;
+            };
+
+            while (input){
+                input.read(block.data(), block.size());
+                pending.append(block.data(), static_cast<size_t>(input.gcount()));
+
+                auto lastNewline = pending.rfind('\n');
+                if (lastNewline == std::string::npos) continue;
+
+                auto complete = pending.substr(0, lastNewline + 1);
+                pending.erase(0, lastNewline + 1);
+                ParseQueryPoints(complete, line, points);
+                line += static_cast<size_t>(std::count(complete.begin(), complete.end(), '\n'));
+                if (!flush(false)) return;
+            }
+            ParseQueryPoints(pending, line, points);
+            flush(true);
+            queries.Close();
+        } catch (...){
+            fail(std::current_exception());
+        }
+    });
+
+    /// Stage 2: answer the queries of every chunk
+    std::thread worker([&]{
+        if (IsTracing()) SetTraceThreadName("pipeline_worker");
+        try{
+            std::optional<AdaptiveNearestPoints> adaptive;
+            if (calibration) adaptive.emplace(poly, *calibration);
+            while (auto chunk = queries.Pop()){
+                ResultChunk result{chunk->firstQuery, adaptive ? adaptive->FindNearestPoints(chunk->points)
+                                                               : FindNearestPointsToPolylineBatch(poly, chunk->points)};
+                if (!results.Push(std::move(result))) return;
+            }
+            results.Close();
+        } catch (...){
+            fail(std::current_exception());
+        }
+    });
+
+    /// Stage 3: format and write the results in the calling thread
+    /// A failure here closes the queues as well, so that the other stages can be joined
+    size_t processed = 0;
+    try{
+        if (format == BatchOutputFormat::Binary)
+            output.write(binaryResultsMagic, sizeof(binaryResultsMagic));
+
+        std::string buffer;
+        while (auto chunk = results.Pop()){
+            buffer.clear();
+            FormatQueryResults(chunk->results, chunk->firstQuery, format, buffer);
+            output.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            processed += chunk->results.size();
+        }
+    } catch (...){
+        fail(std::current_exception());
+    }
+
+    reader.join();
+    worker.join();
+    if (error) std::rethrow_exception(error);
+
+    output.flush();
+    return processed;
+}
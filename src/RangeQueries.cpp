@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include "static/GeometryObjects.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/RangeTraversal.h"
+#include "static/SegmentIndex.h"
+#include "static/SegmentKernel.h"
+#include "static/RangeQueries.h"
+#include <vector>
+
+namespace{
+
+using Kernel = SegmentKernel<3>;
+
+Kernel::Coords ToCoords(const Point3D& point){
+    return {point.GetX(), point.GetY(), point.GetZ()};
+}
+
+void CheckRange(const Polyline3D& poly, const SegmentIndex& index, size_t first, size_t last){
+    if (index.GetPolylineNodesCount() != poly.GetNodesCount())
+        throw std::invalid_argument("Segment index belongs to another polyline");
+    auto segments = poly.GetNodesCount() < 2 ? 0 : poly.GetNodesCount() - 1;
+    if (first > last || last > segments)
+        throw std::invalid_argument("Segment range exceeds the polyline");
+}
+
+}
+
+std::vector<std::pair<size_t, Point3D>> FindNearestPointsInRange(const Polyline3D& poly, const SegmentIndex& index,
+                                                                 const Point3D& point, size_t first, size_t last){
+    CheckRange(poly, index, first, last);
+    const auto& nodes = poly.GetNodes();
+
+    auto candidates = range_detail::CollectNearestCandidates(index, point, first, last, [&](size_t i){
+        if (nodes[i] == nodes[i + 1])
+            return range_detail::MeasuredSegment();
+        return range_detail::MeasuredSegment(NearestPointOnSegment(point, Segment3D {nodes[i], nodes[i + 1]}));
+    });
+    return SelectNearestCandidates(candidates);
+}
+
+std::vector<SegmentCandidate> FindSegmentsWithinRadius(const Polyline3D& poly, const SegmentIndex& index,
+                                                       const Point3D& point, double radius, size_t first, size_t last){
+    if (!(radius >= 0.0))
+        throw std::invalid_argument("Radius must be non-negative");
+    CheckRange(poly, index, first, last);
+    const auto& nodes = poly.GetNodes();
+
+    /// The margin keeps segments at the radius whose box distance rounds above it
+    auto limit = (radius + nearestCandidateMargin) * (radius + nearestCandidateMargin);
+    std::vector<SegmentCandidate> found;
+    range_detail::TraverseRange(index, point, first, last, [&]{ return limit; }, [&](size_t i){
+        if (nodes[i] == nodes[i + 1])
+            return;
+        auto [nearest, dist] = NearestPointOnSegment(point, Segment3D {nodes[i], nodes[i + 1]});
+        if (dist <= radius) found.push_back(SegmentCandidate{i, nearest, dist});
+    });
+    std::sort(found.begin(), found.end(), [](const auto& elem1, const auto& elem2){
+        return elem1.segment < elem2.segment;
+    });
+    return found;
+}
+
+double DistanceToPolylineRange(const Polyline3D& poly, const SegmentIndex& index, const Point3D& point,
+                               size_t first, size_t last){
+    CheckRange(poly, index, first, last);
+    const auto& nodes = poly.GetNodes();
+    const auto query = ToCoords(point);
+
+    auto best = std::numeric_limits<double>::infinity();
+    range_detail::TraverseRange(index, point, first, last, [&]{ return best; }, [&](size_t i){
+        double t;
+        best = std::min(best, Kernel::SquaredDistance(query, ToCoords(nodes[i]), ToCoords(nodes[i + 1]), t));
+    });
+    return std::sqrt(best);
+}
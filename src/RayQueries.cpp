@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include "static/GeometryObjects.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/ParallelFor.h"
+#include "static/RayQueries.h"
+#include "static/Trace.h"
+#include "static/SegmentKernel.h"
+#include <vector>
+
+namespace{
+
+using Coords = SegmentKernel<3>::Coords;
+
+Coords ToCoords(const Primitive3D& primitive){
+    return Coords{primitive.GetX(), primitive.GetY(), primitive.GetZ()};
+}
+
+LineSegmentClosestPoints MakeClosestPoints(const Coords& origin, const Coords& direction, const Segment3D& seg,
+                                           double sMin){
+    if (direction[0] == 0.0 && direction[1] == 0.0 && direction[2] == 0.0)
+        throw std::invalid_argument("Direction of a line must not be zero");
+
+    auto start = ToCoords(seg.GetStart());
+    auto end = ToCoords(seg.GetEnd());
+    auto s = 0.0;
+    auto t = 0.0;
+    auto squared = SegmentKernel<3>::SquaredDistanceLineToSegment(origin, direction, sMin,
+                                                                  std::numeric_limits<double>::infinity(),
+                                                                  start, end, s, t);
+    return LineSegmentClosestPoints{s, t,
+                                    Point3D{origin[0] + s * direction[0], origin[1] + s * direction[1],
+                                            origin[2] + s * direction[2]},
+                                    Point3D{start[0] + t * (end[0] - start[0]), start[1] + t * (end[1] - start[1]),
+                                            start[2] + t * (end[2] - start[2])},
+                                    std::sqrt(squared)};
+}
+
+/**
+ * @brief Slab test of a ray against a box inflated by a radius.
+ * @return Ray parameter where the ray enters the inflated box, or nothing if it misses it.
+ */
+std::optional<double> EnterInflatedBox(const Coords& origin, const Coords& direction, const SegmentIndexNode& node,
+                                       double radius){
+    auto enter = 0.0;
+    auto exit = std::numeric_limits<double>::infinity();
+    for (int axis = 0; axis < 3; ++axis){
+        auto low = node.boxMin[axis] - radius;
+        auto high = node.boxMax[axis] + radius;
+        if (direction[axis] == 0.0){
+            if (origin[axis] < low || origin[axis] > high) return std::nullopt;
+            continue;
+        }
+        auto t1 = (low - origin[axis]) / direction[axis];
+        auto t2 = (high - origin[axis]) / direction[axis];
+        if (t1 > t2) std::swap(t1, t2);
+        enter = std::max(enter, t1);
+        exit = std::min(exit, t2);
+        if (enter > exit) return std::nullopt;
+    }
+    return enter;
+}
+
+/// Segment of the polyline close to the ray.
+struct RayCandidate{
+    size_t segment;
+    double s;
+    double t;
+    double distance;
+};
+
+std::optional<RayHit> NearestPointToRay(const Polyline3D& poly, const SegmentIndex& index, const Ray3D& ray,
+                                        double maxDistance, std::vector<uint32_t>& stack,
+                                        std::vector<RayCandidate>& candidates){
+    if (index.GetNodesCount() == 0)
+        return std::nullopt;
+
+    const auto& nodes = poly.GetNodes();
+    const auto* tree = index.GetNodes();
+    auto origin = ToCoords(ray.origin);
+    auto direction = ToCoords(ray.direction);
+
+    auto min_distance = std::numeric_limits<double>::infinity();
+    auto radius = [&]{ return std::min(maxDistance, min_distance + nearestCandidateMargin); };
+    candidates.clear();
+    stack.clear();
+    stack.push_back(0);
+
+    while (!stack.empty()){
+        auto current = stack.back();
+        stack.pop_back();
+        const auto& node = tree[current];
+        /// Also tests the root; for other nodes the best distance may have shrunk since they were pushed
+        if (!EnterInflatedBox(origin, direction, node, radius()))
+            continue;
+
+        if (node.right == 0){
+            for (auto i = static_cast<size_t>(node.first); i < static_cast<size_t>(node.first) + node.count; ++i){
+                if (nodes[i] == nodes[i + 1])
+                    continue;
+                auto s = 0.0;
+                auto t = 0.0;
+                auto dist = std::sqrt(SegmentKernel<3>::SquaredDistanceLineToSegment(
+                    origin, direction, 0.0, std::numeric_limits<double>::infinity(),
+                    ToCoords(nodes[i]), ToCoords(nodes[i + 1]), s, t));
+                if (dist > radius())
+                    continue;
+                candidates.push_back(RayCandidate{i, s, t, dist});
+                if (dist < min_distance) min_distance = dist;
+            }
+            continue;
+        }
+
+        /// Visit the child entered first along the ray first
+        auto left = EnterInflatedBox(origin, direction, tree[current + 1], radius());
+        auto right = EnterInflatedBox(origin, direction, tree[node.right], radius());
+        if (left && right && *left <= *right){
+            stack.push_back(node.right);
+            stack.push_back(current + 1);
+            continue;
+        }
+        if (left) stack.push_back(current + 1);
+        if (right) stack.push_back(node.right);
+    }
+
+    const RayCandidate* best = nullptr;
+    for (const auto& candidate : candidates){
+        if (candidate.distance >= min_distance + eps)
+            continue;
+        if (best == nullptr || candidate.s < best->s || (candidate.s == best->s && candidate.segment < best->segment))
+            best = &candidate;
+    }
+    if (best == nullptr)
+        return std::nullopt;
+
+    auto start = ToCoords(nodes[best->segment]);
+    auto end = ToCoords(nodes[best->segment + 1]);
+    return RayHit{best->segment,
+                  Point3D{start[0] + best->t * (end[0] - start[0]), start[1] + best->t * (end[1] - start[1]),
+                          start[2] + best->t * (end[2] - start[2])},
+                  best->s, best->distance};
+}
+
+void CheckRayQuery(const Polyline3D& poly, const SegmentIndex& index, const Ray3D& ray){
+    if (index.GetPolylineNodesCount() != poly.GetNodesCount())
+        throw std::invalid_argument("Segment index belongs to another polyline");
+    if (ray.direction.GetX() == 0.0 && ray.direction.GetY() == 0.0 && ray.direction.GetZ() == 0.0)
+        throw std::invalid_argument("Direction of a ray must not be zero");
+}
+
+}
+
+LineSegmentClosestPoints ClosestPointsOfLineAndSegment(const Point3D& origin, const Vector3D& direction,
+                                                       const Segment3D& seg){
+    return MakeClosestPoints(ToCoords(origin), ToCoords(direction), seg, -std::numeric_limits<double>::infinity());
+}
+
+LineSegmentClosestPoints ClosestPointsOfRayAndSegment(const Ray3D& ray, const Segment3D& seg){
+    return MakeClosestPoints(ToCoords(ray.origin), ToCoords(ray.direction), seg, 0.0);
+}
+
+std::optional<RayHit> FindNearestPointToRay(const Polyline3D& poly, const SegmentIndex& index, const Ray3D& ray,
+                                            double maxDistance){
+    CheckRayQuery(poly, index, ray);
+    std::vector<uint32_t> stack;
+    std::vector<RayCandidate> candidates;
+    return NearestPointToRay(poly, index, ray, maxDistance, stack, candidates);
+}
+
+std::vector<std::optional<RayHit>> FindNearestPointsToRays(const Polyline3D& poly, const SegmentIndex& index,
+                                                           const std::vector<Ray3D>& rays, double maxDistance,
+                                                           size_t threads){
+    TraceScope trace("ray_queries", "query");
+    /// Check everything first, the workers must not throw
+    for (const auto& ray : rays) CheckRayQuery(poly, index, ray);
+
+    std::vector<std::optional<RayHit>> results(rays.size());
+    ParallelFor(rays.size(), threads, [&](size_t first, size_t last){
+        std::vector<uint32_t> stack;
+        std::vector<RayCandidate> candidates;
+        for (auto i = first; i < last; ++i){
+            results[i] = NearestPointToRay(poly, index, rays[i], maxDistance, stack, candidates);
+        }
+    });
+    return results;
+}
@@ -0,0 +1,108 @@
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include "static/GeometryObjects.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/ResultCache.h"
+#include <vector>
+
+/// Approximate overhead of a list node and a hash table node per entry.
+constexpr size_t entryOverhead = 4 * sizeof(void*) + sizeof(size_t);
+/// Largest magnitude of a cell number, well within the range of int64_t.
+constexpr double cellLimit = 4611686018427387904.0;
+
+size_t NearestPointsCache::KeyHash::operator()(const Key& key) const{
+    auto mix = [](uint64_t h, int64_t value){
+        h ^= static_cast<uint64_t>(value) + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+        return h;
+    };
+    return static_cast<size_t>(mix(mix(mix(mix(0, key.x), key.y), key.z), key.exact));
+}
+
+NearestPointsCache::NearestPointsCache(double _tolerance, size_t _memoryBudget) :
+                                tolerance(_tolerance), memoryBudget(_memoryBudget){
+    if (!(tolerance >= 0.0))
+        throw std::invalid_argument("Cache tolerance must not be negative");
+}
+
+NearestPointsCache::Key NearestPointsCache::MakeKey(const Point3D& point) const{
+    Key key{};
+    auto quantize = [this, &key](double value, int axis){
+        /// Cell numbers beyond 2^62 or of non-finite values do not fit into int64_t, those keep the bits
+        auto cell = tolerance == 0.0 ? 0.0 : std::floor(value / tolerance);
+        if (tolerance == 0.0 || !(std::fabs(cell) < cellLimit)){
+            int64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            if (tolerance != 0.0) key.exact |= static_cast<uint8_t>(1u << axis);
+            return bits;
+        }
+        return static_cast<int64_t>(cell);
+    };
+    key.x = quantize(point.GetX(), 0);
+    key.y = quantize(point.GetY(), 1);
+    key.z = quantize(point.GetZ(), 2);
+    return key;
+}
+
+size_t NearestPointsCache::EntrySize(const Entry& entry){
+    return sizeof(Entry) + entryOverhead + entry.result.capacity() * sizeof(entry.result[0]);
+}
+
+void NearestPointsCache::ClearLocked(){
+    entries.clear();
+    index.clear();
+    memoryUsage = 0;
+}
+
+std::vector<std::pair<size_t, Point3D>> NearestPointsCache::FindNearestPoints(const Polyline3D& poly,
+                                                                              const Point3D& point){
+    auto key = MakeKey(point);
+    {
+        std::lock_guard lock(mutex);
+        if (revision != poly.GetRevision()){
+            ClearLocked();
+            revision = poly.GetRevision();
+        }
+        auto it = index.find(key);
+        if (it != index.end()){
+            entries.splice(entries.begin(), entries, it->second);
+            hits.fetch_add(1, std::memory_order_relaxed);
+            return it->second->result;
+        }
+    }
+    misses.fetch_add(1, std::memory_order_relaxed);
+
+    /// The scan runs without the lock, so other threads can use the cache meanwhile
+    Entry entry{key, FindNearestPointsToPolyline(poly, point)};
+    auto result = entry.result;
+    auto size = EntrySize(entry);
+
+    std::lock_guard lock(mutex);
+    if (revision != poly.GetRevision() || size > memoryBudget || index.count(key) != 0)
+        return result;
+
+    entries.push_front(std::move(entry));
+    index.emplace(key, entries.begin());
+    memoryUsage += size;
+    while (memoryUsage > memoryBudget){
+        memoryUsage -= EntrySize(entries.back());
+        index.erase(entries.back().key);
+        entries.pop_back();
+    }
+    return result;
+}
+
+void NearestPointsCache::Clear(){
+    std::lock_guard lock(mutex);
+    ClearLocked();
+}
+
+size_t NearestPointsCache::GetEntriesCount() const{
+    std::lock_guard lock(mutex);
+    return entries.size();
+}
+
+size_t NearestPointsCache::GetMemoryUsage() const{
+    std::lock_guard lock(mutex);
+    return memoryUsage;
+}
@@ -0,0 +1,628 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "static/AtomicFile.h"
+#include "static/GeometryObjects.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/SegmentKernel.h"
+#include "static/ParallelFor.h"
+#include "static/Trace.h"
+#include "static/SegmentIndex.h"
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define NEARESTPOINTS_HAS_MMAP 1
+#endif
+
+namespace{
+
+/// Identifies index files.
+constexpr char indexMagic[8] = {'N', 'P', 'I', 'N', 'D', 'E', 'X', '\0'};
+
+/// Written as a number to detect files of a machine with another byte order.
+constexpr uint32_t byteOrderTag = 0x01020304;
+
+/**
+ * @struct IndexFileHeader
+ * @brief Header of an index file, followed by the nodes.
+ */
+struct IndexFileHeader{
+    char magic[8];                    ///< Always indexMagic.
+    uint32_t version;                 ///< SegmentIndex::version of the writer.
+    uint32_t nodeSize;                ///< sizeof(SegmentIndexNode) of the writer.
+    uint32_t byteOrder;               ///< Always byteOrderTag.
+    uint32_t reserved;                ///< Always 0.
+    uint64_t polylineNodes;           ///< Number of nodes of the indexed polyline.
+    uint64_t polylineHash;            ///< Fingerprint of the indexed polyline.
+    uint64_t nodesCount;              ///< Number of nodes that follow the header.
+    uint64_t checksum;                ///< Hash of the bytes of the nodes.
+    uint64_t padding;                 ///< Keeps the nodes aligned to their size, always 0.
+};
+
+static_assert(sizeof(IndexFileHeader) == 64, "IndexFileHeader is part of the index file format");
+
+/**
+ * @class Hasher
+ * @brief 64-bit hash of a sequence of words, a word-wise variant of FNV-1a.
+ */
+class Hasher{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+public:
+    void Add(uint64_t word){
+        hash = (hash ^ word) * 0x100000001b3ULL;
+        hash ^= hash >> 29;
+    }
+
+    void Add(double value){
+        uint64_t word;
+        std::memcpy(&word, &value, sizeof(word));
+        Add(word);
+    }
+
+    void AddBytes(const void* data, size_t size){
+        const auto* bytes = static_cast<const unsigned char*>(data);
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)){
+            uint64_t word;
+            std::memcpy(&word, bytes + i, sizeof(word));
+            Add(word);
+        }
+        for (; i < size; ++i) Add(static_cast<uint64_t>(bytes[i]));
+    }
+
+    uint64_t Get() const {return hash;}
+};
+
+/// Measure of a box used by the surface area heuristic.
+double SplitCost(const std::array<double, 3>& low, const std::array<double, 3>& high, bool perimeter){
+    auto dx = high[0] - low[0];
+    auto dy = high[1] - low[1];
+    auto dz = high[2] - low[2];
+    return perimeter ? dx + dy + dz : dx * dy + dy * dz + dz * dx;
+}
+
+/**
+ * @struct HierarchyCost
+ * @brief Surface area heuristic of a set of nodes, with perimeters for hierarchies without area.
+ *
+ * Inner nodes count once and leaves once per segment, so the cost estimates the number of box
+ * and segment tests of a query, up to the normalization by the root.
+ */
+struct HierarchyCost{
+    double area = 0.0;
+    double perimeter = 0.0;
+
+    void Add(const SegmentIndexNode& node){
+        auto weight = node.right == 0 ? static_cast<double>(node.count) : 1.0;
+        area += SplitCost(node.boxMin, node.boxMax, false) * weight;
+        perimeter += SplitCost(node.boxMin, node.boxMax, true) * weight;
+    }
+
+    /// Takes back the Add of a node with the same bounds.
+    void Remove(const SegmentIndexNode& node){
+        auto weight = node.right == 0 ? static_cast<double>(node.count) : 1.0;
+        area -= SplitCost(node.boxMin, node.boxMax, false) * weight;
+        perimeter -= SplitCost(node.boxMin, node.boxMax, true) * weight;
+    }
+
+    /// Cost relative to the measure of the root.
+    double Normalize(const SegmentIndexNode& root) const{
+        auto rootArea = SplitCost(root.boxMin, root.boxMax, false);
+        if (rootArea > 0.0) return area / rootArea;
+        auto rootPerimeter = SplitCost(root.boxMin, root.boxMax, true);
+        return rootPerimeter > 0.0 ? perimeter / rootPerimeter : 0.0;
+    }
+};
+
+/// Cost of a whole hierarchy, before normalization.
+HierarchyCost ComputeHierarchyCost(const SegmentIndexNode* nodes, size_t count){
+    HierarchyCost cost;
+    for (size_t i = 0; i < count; ++i) cost.Add(nodes[i]);
+    return cost;
+}
+
+/// Recomputes the bounds of a node from its segments, or from its children, which must be up to date.
+void RefitNode(SegmentIndexNode* tree, size_t i, const std::vector<Point3D>& points){
+    auto& node = tree[i];
+    if (node.right == 0){
+        node.boxMin = {points[node.first].GetX(), points[node.first].GetY(), points[node.first].GetZ()};
+        node.boxMax = node.boxMin;
+        for (auto k = static_cast<size_t>(node.first) + 1; k <= static_cast<size_t>(node.first) + node.count; ++k){
+            std::array<double, 3> coords{points[k].GetX(), points[k].GetY(), points[k].GetZ()};
+            for (int axis = 0; axis < 3; ++axis){
+                node.boxMin[axis] = std::min(node.boxMin[axis], coords[axis]);
+                node.boxMax[axis] = std::max(node.boxMax[axis], coords[axis]);
+            }
+        }
+        return;
+    }
+    const auto& left = tree[i + 1];
+    const auto& right = tree[node.right];
+    for (int axis = 0; axis < 3; ++axis){
+        node.boxMin[axis] = std::min(left.boxMin[axis], right.boxMin[axis]);
+        node.boxMax[axis] = std::max(left.boxMax[axis], right.boxMax[axis]);
+    }
+}
+
+/// Hash of a node of a polyline at its position; the fingerprint is the sum over all nodes.
+uint64_t NodeHash(size_t index, const Point3D& point){
+    Hasher hasher;
+    hasher.Add(static_cast<uint64_t>(index));
+    hasher.Add(point.GetX());
+    hasher.Add(point.GetY());
+    hasher.Add(point.GetZ());
+    return hasher.Get();
+}
+
+}
+
+SegmentIndex::SegmentIndex() = default;
+
+SegmentIndex::SegmentIndex(const Polyline3D& poly, size_t _leafSize) : leafSize(_leafSize){
+    TraceScope trace("build_segment_index", "index");
+    if (leafSize == 0)
+        throw std::invalid_argument("Leaf size of a segment index must be positive");
+
+    const auto& points = poly.GetNodes();
+    polylineNodes = points.size();
+    polylineHash = Fingerprint(poly);
+    if (points.size() < 2) return;
+    auto segments = points.size() - 1;
+    if (segments >= std::numeric_limits<uint32_t>::max())
+        throw std::invalid_argument("Polyline has too many segments for a segment index");
+
+    std::vector<double> coords(3 * points.size());
+    for (size_t i = 0; i < points.size(); ++i){
+        coords[3 * i] = points[i].GetX();
+        coords[3 * i + 1] = points[i].GetY();
+        coords[3 * i + 2] = points[i].GetZ();
+    }
+    auto extend = [&coords](std::array<double, 3>& low, std::array<double, 3>& high, size_t segment){
+        for (size_t node = segment; node <= segment + 1; ++node){
+            for (int axis = 0; axis < 3; ++axis){
+                low[axis] = std::min(low[axis], coords[3 * node + axis]);
+                high[axis] = std::max(high[axis], coords[3 * node + axis]);
+            }
+        }
+    };
+    const std::array<double, 3> emptyLow{std::numeric_limits<double>::max(), std::numeric_limits<double>::max(),
+                                         std::numeric_limits<double>::max()};
+    const std::array<double, 3> emptyHigh{std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest(),
+                                          std::numeric_limits<double>::lowest()};
+
+    /// Ranges waiting for their node; the left child is always built right after its parent
+    struct Range{
+        size_t first;
+        size_t count;
+        size_t parent;
+    };
+    constexpr auto noParent = std::numeric_limits<size_t>::max();
+    std::vector<Range> stack{{0, segments, noParent}};
+    std::vector<std::array<double, 3>> suffixLow(segments + 1);
+    std::vector<std::array<double, 3>> suffixHigh(segments + 1);
+    owned.reserve(2 * (segments / leafSize + 1));
+
+    while (!stack.empty()){
+        auto range = stack.back();
+        stack.pop_back();
+        auto index = owned.size();
+        if (range.parent != noParent) owned[range.parent].right = static_cast<uint32_t>(index);
+
+        /// Bounds of the segments [k, end) for every k, the whole range for k = first
+        auto end = range.first + range.count;
+        suffixLow[end] = emptyLow;
+        suffixHigh[end] = emptyHigh;
+        for (auto k = end; k-- > range.first;){
+            suffixLow[k] = suffixLow[k + 1];
+            suffixHigh[k] = suffixHigh[k + 1];
+            extend(suffixLow[k], suffixHigh[k], k);
+        }
+
+        SegmentIndexNode node{suffixLow[range.first], suffixHigh[range.first],
+                              static_cast<uint32_t>(range.first), static_cast<uint32_t>(range.count), 0, 0};
+        owned.push_back(node);
+        if (range.count <= leafSize)
+            continue;
+
+        /// Flat and collinear ranges have no area, their boxes are compared by perimeter instead
+        auto perimeter = SplitCost(node.boxMin, node.boxMax, false) == 0.0;
+        auto split = range.first + range.count / 2;
+        auto prefixLow = emptyLow;
+        auto prefixHigh = emptyHigh;
+        for (auto k = range.first; k < split; ++k) extend(prefixLow, prefixHigh, k);
+        auto best = SplitCost(prefixLow, prefixHigh, perimeter) * (split - range.first) +
+                    SplitCost(suffixLow[split], suffixHigh[split], perimeter) * (end - split);
+
+        /// Both children keep at least an eighth of the segments, so that the depth stays logarithmic
+        /// and the build O(n log n) even where the cheapest split would peel off single segments
+        auto minSide = std::max<size_t>(1, range.count / 8);
+        prefixLow = emptyLow;
+        prefixHigh = emptyHigh;
+        for (auto k = range.first + 1; k + minSide <= end; ++k){
+            extend(prefixLow, prefixHigh, k - 1);
+            if (k < range.first + minSide)
+                continue;
+            auto cost = SplitCost(prefixLow, prefixHigh, perimeter) * (k - range.first) +
+                        SplitCost(suffixLow[k], suffixHigh[k], perimeter) * (end - k);
+            if (cost < best){
+                best = cost;
+                split = k;
+            }
+        }
+
+        stack.push_back({split, end - split, index});
+        stack.push_back({range.first, split - range.first, noParent});
+    }
+
+    owned.shrink_to_fit();
+    nodes = owned.data();
+    nodesCount = owned.size();
+    auto cost = ComputeHierarchyCost(nodes, nodesCount);
+    builtCost = cost.Normalize(nodes[0]);
+    currentCost = builtCost;
+    currentArea = cost.area;
+    currentPerimeter = cost.perimeter;
+}
+
+SegmentIndex::SegmentIndex(SegmentIndex&& other) noexcept{
+    *this = std::move(other);
+}
+
+SegmentIndex& SegmentIndex::operator=(SegmentIndex&& other) noexcept{
+    if (this != &other){
+        Release();
+        owned = std::move(other.owned);
+        mapping = other.mapping;
+        mappingSize = other.mappingSize;
+        nodes = mapping != nullptr ? other.nodes : owned.data();
+        nodesCount = other.nodesCount;
+        polylineNodes = other.polylineNodes;
+        polylineHash = other.polylineHash;
+        leafSize = other.leafSize;
+        builtCost = other.builtCost;
+        currentCost = other.currentCost;
+        currentArea = other.currentArea;
+        currentPerimeter = other.currentPerimeter;
+
+        other.mapping = nullptr;
+        other.mappingSize = 0;
+        other.nodes = nullptr;
+        other.nodesCount = 0;
+        other.polylineNodes = 0;
+        other.polylineHash = 0;
+    }
+    return *this;
+}
+
+SegmentIndex::~SegmentIndex(){
+    Release();
+}
+
+void SegmentIndex::Release(){
+#ifdef NEARESTPOINTS_HAS_MMAP
+    if (mapping != nullptr) munmap(mapping, mappingSize);
+#endif
+    mapping = nullptr;
+    mappingSize = 0;
+    owned.clear();
+    nodes = nullptr;
+    nodesCount = 0;
+}
+
+void SegmentIndex::CopyMapping(){
+    if (mapping == nullptr)
+        return;
+    std::vector<SegmentIndexNode> copy(nodes, nodes + nodesCount);
+    auto count = nodesCount;
+    Release();
+    owned = std::move(copy);
+    nodes = owned.data();
+    nodesCount = count;
+}
+
+SegmentIndex::RefitResult SegmentIndex::Refit(const Polyline3D& poly, double maxDegradation, size_t threads){
+    TraceScope trace("refit_segment_index", "index");
+    if (poly.GetNodesCount() != polylineNodes)
+        throw std::invalid_argument("Refitted polyline must have as many nodes as the indexed one");
+    if (!(maxDegradation >= 1.0))
+        throw std::invalid_argument("Allowed degradation of a segment index must be at least 1");
+
+    polylineHash = Fingerprint(poly);
+    if (nodesCount == 0)
+        return RefitResult::Refitted;
+    CopyMapping();
+    if (builtCost < 0.0) builtCost = ComputeHierarchyCost(nodes, nodesCount).Normalize(nodes[0]);
+
+    const auto& points = poly.GetNodes();
+    auto* tree = owned.data();
+    auto refitNode = [&](size_t i, HierarchyCost& cost){
+        RefitNode(tree, i, points);
+        cost.Add(tree[i]);
+    };
+
+    /// Split the hierarchy into subtrees refitted in parallel below a top part refitted afterwards
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<uint32_t> subtrees{0};
+    std::vector<uint32_t> top;
+    while (threads > 1 && subtrees.size() < threads * 8){
+        std::vector<uint32_t> next;
+        for (auto root : subtrees){
+            if (tree[root].right == 0){
+                next.push_back(root);
+                continue;
+            }
+            top.push_back(root);
+            next.push_back(root + 1);
+            next.push_back(tree[root].right);
+        }
+        if (next.size() == subtrees.size()) break;
+        subtrees = std::move(next);
+    }
+
+    /// A subtree occupies the indices from its root to the last node of its rightmost path
+    std::vector<HierarchyCost> costs(subtrees.size());
+    ParallelFor(subtrees.size(), threads, [&](size_t first, size_t last){
+        for (auto t = first; t < last; ++t){
+            size_t end = subtrees[t];
+            while (tree[end].right != 0) end = tree[end].right;
+            for (auto i = end + 1; i-- > subtrees[t];) refitNode(i, costs[t]);
+        }
+    });
+
+    HierarchyCost cost;
+    std::sort(top.begin(), top.end());
+    for (auto i = top.size(); i-- > 0;) refitNode(top[i], cost);
+    for (const auto& subtree : costs){
+        cost.area += subtree.area;
+        cost.perimeter += subtree.perimeter;
+    }
+    currentCost = cost.Normalize(tree[0]);
+    currentArea = cost.area;
+    currentPerimeter = cost.perimeter;
+
+    if (currentCost > builtCost * maxDegradation){
+        *this = SegmentIndex(poly, leafSize);
+        return RefitResult::Rebuilt;
+    }
+    return RefitResult::Refitted;
+}
+
+SegmentIndex::RefitResult SegmentIndex::UpdateNodes(Polyline3D& poly, const std::vector<std::pair<size_t, Point3D>>& moves,
+                                                    double maxDegradation){
+    TraceScope trace("update_segment_index", "index");
+    if (poly.GetNodesCount() != polylineNodes)
+        throw std::invalid_argument("Updated polyline must have as many nodes as the indexed one");
+    if (!(maxDegradation >= 1.0))
+        throw std::invalid_argument("Allowed degradation of a segment index must be at least 1");
+    for (const auto& move : moves){
+        if (move.first >= polylineNodes)
+            throw std::invalid_argument("Moved node " + std::to_string(move.first) + " is not a node of the polyline");
+    }
+
+    for (const auto& [node, point] : moves){
+        polylineHash += NodeHash(node, point) - NodeHash(node, poly.GetNodes()[node]);
+        poly.SetNode(node, point);
+    }
+    if (nodesCount == 0 || moves.empty())
+        return RefitResult::Refitted;
+    CopyMapping();
+    auto* tree = owned.data();
+    if (currentArea < 0.0){
+        auto cost = ComputeHierarchyCost(tree, nodesCount);
+        currentArea = cost.area;
+        currentPerimeter = cost.perimeter;
+        if (builtCost < 0.0) builtCost = cost.Normalize(tree[0]);
+    }
+
+    /// Paths from the root to the leaves of the segments on both sides of every moved node
+    std::vector<uint32_t> touched;
+    auto touch = [&](size_t segment){
+        uint32_t i = 0;
+        touched.push_back(i);
+        while (tree[i].right != 0){
+            i = segment < static_cast<size_t>(tree[i + 1].first) + tree[i + 1].count ? i + 1 : tree[i].right;
+            touched.push_back(i);
+        }
+    };
+    for (const auto& move : moves){
+        if (move.first > 0) touch(move.first - 1);
+        if (move.first + 1 < polylineNodes) touch(move.first);
+    }
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+
+    /// Children have higher indices than their parents, so refitting backwards goes bottom-up
+    HierarchyCost cost{currentArea, currentPerimeter};
+    const auto& points = poly.GetNodes();
+    for (auto i = touched.size(); i-- > 0;){
+        cost.Remove(tree[touched[i]]);
+        RefitNode(tree, touched[i], points);
+        cost.Add(tree[touched[i]]);
+    }
+    currentArea = cost.area;
+    currentPerimeter = cost.perimeter;
+    currentCost = cost.Normalize(tree[0]);
+
+    if (currentCost > builtCost * maxDegradation){
+        *this = SegmentIndex(poly, leafSize);
+        return RefitResult::Rebuilt;
+    }
+    return RefitResult::Refitted;
+}
+
+double SegmentIndex::GetDegradation() const{
+    if (builtCost <= 0.0 || currentCost < 0.0)
+        return 1.0;
+    return currentCost / builtCost;
+}
+
+uint64_t SegmentIndex::Fingerprint(const Polyline3D& poly){
+    Hasher hasher;
+    const auto& points = poly.GetNodes();
+    hasher.Add(static_cast<uint64_t>(points.size()));
+    auto hash = hasher.Get();
+    for (size_t i = 0; i < points.size(); ++i) hash += NodeHash(i, points[i]);
+    return hash;
+}
+
+bool SegmentIndex::Save(const std::string& filename) const{
+    IndexFileHeader header{};
+    std::memcpy(header.magic, indexMagic, sizeof(indexMagic));
+    header.version = version;
+    header.nodeSize = sizeof(SegmentIndexNode);
+    header.byteOrder = byteOrderTag;
+    header.polylineNodes = polylineNodes;
+    header.polylineHash = polylineHash;
+    header.nodesCount = nodesCount;
+    Hasher hasher;
+    hasher.AddBytes(nodes, nodesCount * sizeof(SegmentIndexNode));
+    header.checksum = hasher.Get();
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return false;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(nodes), static_cast<std::streamsize>(nodesCount * sizeof(SegmentIndexNode)));
+    file.close();
+    return static_cast<bool>(file);
+}
+
+std::optional<SegmentIndex> SegmentIndex::Map(const std::string& filename, const Polyline3D& poly){
+    TraceScope trace("map_segment_index", "index");
+    SegmentIndex index;
+    IndexFileHeader header{};
+    size_t size = 0;
+
+#ifdef NEARESTPOINTS_HAS_MMAP
+    auto fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return std::nullopt;
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(IndexFileHeader))){
+        close(fd);
+        return std::nullopt;
+    }
+    size = static_cast<size_t>(info.st_size);
+    auto* address = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) return std::nullopt;
+    index.mapping = address;
+    index.mappingSize = size;
+    std::memcpy(&header, address, sizeof(header));
+#else
+    /// Without memory mapping the nodes are read into memory as they are
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) return std::nullopt;
+    size = static_cast<size_t>(file.tellg());
+    file.seekg(0);
+    if (size < sizeof(IndexFileHeader) || !file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+        return std::nullopt;
+#endif
+
+    auto payload = size - sizeof(IndexFileHeader);
+    if (std::memcmp(header.magic, indexMagic, sizeof(indexMagic)) != 0 || header.version != version ||
+        header.nodeSize != sizeof(SegmentIndexNode) || header.byteOrder != byteOrderTag ||
+        payload % sizeof(SegmentIndexNode) != 0 || header.nodesCount != payload / sizeof(SegmentIndexNode))
+        return std::nullopt;
+    if (header.polylineNodes != poly.GetNodesCount() || header.polylineHash != Fingerprint(poly))
+        return std::nullopt;
+
+#ifdef NEARESTPOINTS_HAS_MMAP
+    index.nodes = reinterpret_cast<const SegmentIndexNode*>(static_cast<const char*>(address) + sizeof(IndexFileHeader));
+#else
+    index.owned.resize(header.nodesCount);
+    if (!file.read(reinterpret_cast<char*>(index.owned.data()), static_cast<std::streamsize>(payload)))
+        return std::nullopt;
+    index.nodes = index.owned.data();
+#endif
+    index.nodesCount = header.nodesCount;
+    index.polylineNodes = header.polylineNodes;
+    index.polylineHash = header.polylineHash;
+
+    Hasher hasher;
+    hasher.AddBytes(index.nodes, payload);
+    if (hasher.Get() != header.checksum)
+        return std::nullopt;
+    return index;
+}
+
+SegmentIndex SegmentIndex::Open(const std::string& filename, const Polyline3D& poly, size_t leafSize){
+    if (auto mapped = Map(filename, poly))
+        return std::move(*mapped);
+
+    SegmentIndex index(poly, leafSize);
+    /// Replace the file atomically, so that other processes never map a partly written index
+    ReplaceFileAtomically(filename, [&index](const std::string& temporary){ return index.Save(temporary); });
+    return index;
+}
+
+size_t SegmentIndex::GetMemoryUsage() const{
+    return sizeof(*this) + owned.capacity() * sizeof(SegmentIndexNode) + mappingSize;
+}
+
+std::vector<std::pair<size_t, Point3D>> FindNearestPointsToIndexedPolyline(const Polyline3D& poly,
+                                                                           const SegmentIndex& index,
+                                                                           const Point3D& point){
+    if (index.GetPolylineNodesCount() != poly.GetNodesCount())
+        throw std::invalid_argument("Segment index belongs to another polyline");
+    if (index.GetNodesCount() == 0)
+        return {};
+
+    const auto& nodes = poly.GetNodes();
+    const auto* tree = index.GetNodes();
+    const SegmentKernel<3>::Coords query{point.GetX(), point.GetY(), point.GetZ()};
+    auto bound = [&](uint32_t node){
+        return std::sqrt(SegmentKernel<3>::SquaredDistanceToBox(query, tree[node].boxMin, tree[node].boxMax));
+    };
+
+    double min_distance = std::numeric_limits<double>::max();
+    std::vector<SegmentCandidate> candidates;
+    std::vector<std::pair<uint32_t, double>> stack{{0, bound(0)}};
+
+    while (!stack.empty()){
+        auto [current, distance] = stack.back();
+        stack.pop_back();
+        if (distance > min_distance + nearestCandidateMargin)
+            continue;
+
+        const auto& node = tree[current];
+        if (node.right == 0){
+            for (auto i = static_cast<size_t>(node.first); i < static_cast<size_t>(node.first) + node.count; ++i){
+                if (nodes[i] == nodes[i + 1])
+                    continue;
+
+                auto [nearest, dist] = NearestPointOnSegment(point, Segment3D {nodes[i], nodes[i + 1]});
+                if (dist > min_distance + nearestCandidateMargin)
+                    continue;
+                candidates.push_back(SegmentCandidate{i, nearest, dist});
+                if (dist < min_distance) min_distance = dist;
+            }
+            continue;
+        }
+
+        /// Descend into the nearer child first
+        std::pair<uint32_t, double> left{current + 1, bound(current + 1)};
+        std::pair<uint32_t, double> right{node.right, bound(node.right)};
+        if (left.second < right.second) std::swap(left, right);
+        stack.push_back(left);
+        stack.push_back(right);
+    }
+
+    /// Candidates collected before the minimum was known may be too far, and leaves came out of order
+    candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [min_distance](const auto& candidate){
+        return candidate.distance > min_distance + nearestCandidateMargin;
+    }), candidates.end());
+    std::sort(candidates.begin(), candidates.end(), [](const auto& elem1, const auto& elem2){
+        return elem1.segment < elem2.segment;
+    });
+
+    return SelectNearestCandidates(candidates);
+}
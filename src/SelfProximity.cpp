@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include "static/GeometryObjects.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/ParallelFor.h"
+#include "static/SegmentKernel.h"
+#include "static/Trace.h"
+#include "static/SelfProximity.h"
+#include <vector>
+
+namespace{
+
+using Kernel = SegmentKernel<3>;
+
+/// Number of independent pairs of subtrees per thread handed to the workers.
+constexpr size_t tasksPerThread = 64;
+
+/// Previous node of the first node, and segment of a closing pair of an open polyline.
+constexpr size_t noNode = std::numeric_limits<size_t>::max();
+
+/// Squared distance between the bounds of two nodes.
+double SquaredDistanceBetweenBoxes(const SegmentIndexNode& node1, const SegmentIndexNode& node2){
+    double result = 0.0;
+    for (int axis = 0; axis < 3; ++axis){
+        auto gap = std::max({node1.boxMin[axis] - node2.boxMax[axis], 0.0, node2.boxMin[axis] - node1.boxMax[axis]});
+        result += gap * gap;
+    }
+    return result;
+}
+
+/**
+ * @class SelfJoin
+ * @brief Traversal of pairs of nodes of one hierarchy.
+ */
+class SelfJoin{
+    const SegmentIndexNode* tree;
+    const std::vector<Kernel::Coords>& coords;
+    const std::vector<size_t>& previousNode; ///< For every node, the previous node not equal to it.
+    std::pair<size_t, size_t> closing; ///< First and last segment of a closed polyline, which share its first node.
+    double limit;                     ///< Largest reported distance.
+
+public:
+    SelfJoin(const SegmentIndexNode* _tree, const std::vector<Kernel::Coords>& _coords,
+             const std::vector<size_t>& _previousNode, std::pair<size_t, size_t> _closing, double _limit) :
+        tree(_tree), coords(_coords), previousNode(_previousNode), closing(_closing), limit(_limit) {}
+
+    /**
+     * @brief Replaces a pair of nodes by the pairs of their children that may hold close segments.
+     * @return False if the pair is a pair of leaves, which cannot be split.
+     */
+    template <typename Output>
+    bool Split(uint32_t node1, uint32_t node2, Output&& output) const{
+        const auto& a = tree[node1];
+        const auto& b = tree[node2];
+        if (node1 == node2){
+            if (a.right == 0) return false;
+            output(node1 + 1, node1 + 1);
+            output(a.right, a.right);
+            if (SquaredDistanceBetweenBoxes(tree[node1 + 1], tree[a.right]) <= limit * limit) output(node1 + 1, a.right);
+            return true;
+        }
+        if (a.right == 0 && b.right == 0) return false;
+
+        /// Split the larger node; the pair keeps the lower segment range first
+        auto splitFirst = b.right == 0 || (a.right != 0 && a.count >= b.count);
+        auto parent = splitFirst ? node1 : node2;
+        for (auto child : {parent + 1, tree[parent].right}){
+            auto first = splitFirst ? child : node1;
+            auto second = splitFirst ? node2 : child;
+            if (SquaredDistanceBetweenBoxes(tree[first], tree[second]) <= limit * limit) output(first, second);
+        }
+        return true;
+    }
+
+    /// Tests all segment pairs of two leaves, or of one leaf with itself.
+    void TestLeaves(uint32_t node1, uint32_t node2, std::vector<SegmentProximity>& results) const{
+        const auto& a = tree[node1];
+        const auto& b = tree[node2];
+        for (size_t i = a.first; i < static_cast<size_t>(a.first) + a.count; ++i){
+            if (previousNode[i + 1] != i)
+                continue;
+            auto j = node1 == node2 ? i + 1 : static_cast<size_t>(b.first);
+            for (; j < static_cast<size_t>(b.first) + b.count; ++j){
+                /// Skip degenerate segments and segments sharing a node with segment i
+                if (previousNode[j + 1] != j || previousNode[j] == i || (i == closing.first && j == closing.second))
+                    continue;
+
+                Kernel::Coords direction{coords[i + 1][0] - coords[i][0], coords[i + 1][1] - coords[i][1],
+                                         coords[i + 1][2] - coords[i][2]};
+                auto s = 0.0;
+                auto t = 0.0;
+                auto squared = Kernel::SquaredDistanceLineToSegment(coords[i], direction, 0.0, 1.0,
+                                                                    coords[j], coords[j + 1], s, t);
+                if (squared > limit * limit)
+                    continue;
+
+                auto point = [](const Kernel::Coords& start, const Kernel::Coords& end, double u){
+                    return Point3D{start[0] + u * (end[0] - start[0]), start[1] + u * (end[1] - start[1]),
+                                   start[2] + u * (end[2] - start[2])};
+                };
+                results.push_back(SegmentProximity{i, j, point(coords[i], coords[i + 1], s),
+                                                   point(coords[j], coords[j + 1], t), std::sqrt(squared)});
+            }
+        }
+    }
+
+    /// Reports all close pairs below a pair of nodes.
+    void Run(uint32_t node1, uint32_t node2, std::vector<SegmentProximity>& results) const{
+        std::vector<std::pair<uint32_t, uint32_t>> stack{{node1, node2}};
+        while (!stack.empty()){
+            auto [first, second] = stack.back();
+            stack.pop_back();
+            if (!Split(first, second, [&stack](uint32_t a, uint32_t b){ stack.push_back({a, b}); }))
+                TestLeaves(first, second, results);
+        }
+    }
+};
+
+}
+
+std::vector<SegmentProximity> FindSelfProximities(const Polyline3D& poly, const SegmentIndex& index, double threshold,
+                                                  size_t threads){
+    TraceScope trace("self_proximity", "query");
+    if (!(threshold >= 0.0))
+        throw std::invalid_argument("Proximity threshold must not be negative");
+    if (index.GetPolylineNodesCount() != poly.GetNodesCount())
+        throw std::invalid_argument("Segment index belongs to another polyline");
+    if (index.GetNodesCount() == 0)
+        return {};
+
+    const auto& nodes = poly.GetNodes();
+    std::vector<Kernel::Coords> coords(nodes.size());
+    /// Segment i is degenerate if previousNode[i + 1] != i; segments i < j share a node if previousNode[j] == i
+    std::vector<size_t> previousNode(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i){
+        coords[i] = Kernel::Coords{nodes[i].GetX(), nodes[i].GetY(), nodes[i].GetZ()};
+        previousNode[i] = i == 0 ? noNode : (nodes[i] == nodes[i - 1] ? previousNode[i - 1] : i - 1);
+    }
+
+    /// The first and last non-degenerate segments of a closed polyline are adjacent through its first node
+    std::pair<size_t, size_t> closing{noNode, noNode};
+    if (nodes.front() == nodes.back()){
+        size_t first = 0;
+        while (first + 1 < nodes.size() && previousNode[first + 1] != first) ++first;
+        auto last = previousNode.back();
+        if (last != noNode && first < last) closing = {first, last};
+    }
+    SelfJoin join(index.GetNodes(), coords, previousNode, closing, threshold + eps);
+
+    /// Expand the pairs of subtrees breadth-first until there is enough work for every thread
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::pair<uint32_t, uint32_t>> tasks{{0, 0}};
+    std::vector<std::pair<uint32_t, uint32_t>> leaves;
+    while (!tasks.empty() && tasks.size() < threads * tasksPerThread){
+        std::vector<std::pair<uint32_t, uint32_t>> expanded;
+        for (const auto& [first, second] : tasks){
+            if (!join.Split(first, second, [&expanded](uint32_t a, uint32_t b){ expanded.push_back({a, b}); }))
+                leaves.push_back({first, second});
+        }
+        tasks = std::move(expanded);
+    }
+    tasks.insert(tasks.end(), leaves.begin(), leaves.end());
+
+    std::vector<std::vector<SegmentProximity>> partial(tasks.size());
+    ParallelFor(tasks.size(), threads, [&](size_t first, size_t last){
+        for (auto task = first; task < last; ++task) join.Run(tasks[task].first, tasks[task].second, partial[task]);
+    });
+
+    std::vector<SegmentProximity> results;
+    for (auto& part : partial) results.insert(results.end(), part.begin(), part.end());
+    std::sort(results.begin(), results.end(), [](const auto& elem1, const auto& elem2){
+        return elem1.first < elem2.first || (elem1.first == elem2.first && elem1.second < elem2.second);
+    });
+    return results;
+}
+
+std::vector<SegmentProximity> FindSelfProximities(const Polyline3D& poly, double threshold, size_t threads){
+    if (!(threshold >= 0.0))
+        throw std::invalid_argument("Proximity threshold must not be negative");
+    return FindSelfProximities(poly, SegmentIndex(poly), threshold, threads);
+}
@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "static/3DMathOperations.h"
+#include "static/GeometryObjects.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/RangeTraversal.h"
+#include "static/SegmentIndex.h"
+#include "static/TimedPolyline.h"
+#include <vector>
+
+namespace{
+
+void CheckWindow(double startTime, double endTime){
+    if (!(startTime <= endTime))
+        throw std::invalid_argument("Time window must be ordered and not NaN");
+}
+
+Point3D Interpolate(const Point3D& start, const Point3D& end, double t){
+    return Point3D(start.GetX() + t * (end.GetX() - start.GetX()),
+                   start.GetY() + t * (end.GetY() - start.GetY()),
+                   start.GetZ() + t * (end.GetZ() - start.GetZ()));
+}
+
+}
+
+TimedPolyline3D::TimedPolyline3D() = default;
+
+TimedPolyline3D::TimedPolyline3D(Polyline3D _poly, std::vector<double> _timestamps, size_t leafSize)
+    : poly(std::move(_poly)), timestamps(std::move(_timestamps)){
+    if (timestamps.size() != poly.GetNodesCount())
+        throw std::invalid_argument("Every node needs a timestamp");
+    for (size_t i = 0; i < timestamps.size(); ++i){
+        if (std::isnan(timestamps[i]) || (i > 0 && timestamps[i] < timestamps[i - 1]))
+            throw std::invalid_argument("Timestamps must be nondecreasing");
+    }
+    index = SegmentIndex(poly, leafSize);
+}
+
+size_t TimedPolyline3D::GetMemoryUsage() const{
+    return sizeof(*this) - sizeof(poly) - sizeof(index) + poly.GetMemoryUsage() +
+           timestamps.capacity() * sizeof(double) + index.GetMemoryUsage();
+}
+
+std::pair<size_t, size_t> TimedPolyline3D::FindSegmentsInWindow(double startTime, double endTime) const{
+    CheckWindow(startTime, endTime);
+    if (timestamps.size() < 2)
+        return {0, 0};
+
+    /// Segment i spans [timestamps[i], timestamps[i + 1]]
+    auto first = std::lower_bound(timestamps.begin() + 1, timestamps.end(), startTime) - (timestamps.begin() + 1);
+    auto last = std::upper_bound(timestamps.begin(), timestamps.end() - 1, endTime) - timestamps.begin();
+    if (first >= last)
+        return {0, 0};
+    return {static_cast<size_t>(first), static_cast<size_t>(last)};
+}
+
+std::vector<TimedNearestPoint> TimedPolyline3D::FindNearestPoints(const Point3D& point, double startTime,
+                                                                  double endTime) const{
+    auto [first, last] = FindSegmentsInWindow(startTime, endTime);
+    const auto& nodes = poly.GetNodes();
+
+    /// Parameters of the part of segment i within the window; a segment without duration lies in it entirely
+    auto clip = [&](size_t i){
+        auto duration = timestamps[i + 1] - timestamps[i];
+        if (duration <= 0.0)
+            return std::pair<double, double>(0.0, 1.0);
+        return std::pair<double, double>(std::clamp((startTime - timestamps[i]) / duration, 0.0, 1.0),
+                                         std::clamp((endTime - timestamps[i]) / duration, 0.0, 1.0));
+    };
+
+    auto candidates = range_detail::CollectNearestCandidates(index, point, first, last, [&](size_t i){
+        /// Whole segments keep their nodes, so that results match FindNearestPointsToPolyline exactly
+        auto [from, to] = clip(i);
+        auto start = from == 0.0 ? nodes[i] : Interpolate(nodes[i], nodes[i + 1], from);
+        auto end = to == 1.0 ? nodes[i + 1] : Interpolate(nodes[i], nodes[i + 1], to);
+        if (start == end)
+            return range_detail::MeasuredSegment({start, DistanceBetweenPoints(point, start)});
+        return range_detail::MeasuredSegment(NearestPointOnSegment(point, Segment3D {start, end}));
+    });
+
+    std::vector<TimedNearestPoint> result;
+    for (const auto& [segment, nearest] : SelectNearestCandidates(candidates)){
+        auto candidate = std::lower_bound(candidates.begin(), candidates.end(), segment, [](const auto& elem, size_t value){
+            return elem.segment < value;
+        });
+
+        /// The point lies on the segment, so its share of the segment length gives the time
+        auto length = DistanceBetweenPoints(nodes[segment], nodes[segment + 1]);
+        auto t = length > 0.0 ? std::clamp(DistanceBetweenPoints(nodes[segment], nearest) / length, 0.0, 1.0) : 0.0;
+        auto time = timestamps[segment] + t * (timestamps[segment + 1] - timestamps[segment]);
+        result.push_back(TimedNearestPoint{segment, nearest, candidate->distance, std::clamp(time, startTime, endTime)});
+    }
+    return result;
+}
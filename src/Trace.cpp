@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "static/Trace.h"
+#include <vector>
+
+namespace{
+
+/**
+ * @struct ThreadBuffer
+ * @brief Events of one thread. The mutex is contended only while the events are collected.
+ */
+struct ThreadBuffer{
+    std::mutex mutex;
+    std::vector<TraceEvent> events;
+    std::string name;
+    uint32_t thread;
+};
+
+/// Buffers of all threads that ever recorded, kept after the threads end.
+struct Registry{
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+};
+
+Registry& GetRegistry(){
+    static Registry registry;
+    return registry;
+}
+
+ThreadBuffer& GetThreadBuffer(){
+    thread_local std::shared_ptr<ThreadBuffer> buffer = []{
+        auto created = std::make_shared<ThreadBuffer>();
+        auto& registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+        created->thread = static_cast<uint32_t>(registry.buffers.size() + 1);
+        registry.buffers.push_back(created);
+        return created;
+    }();
+    return *buffer;
+}
+
+/// Appends a string as a JSON string literal.
+void AppendJsonString(std::string& output, const std::string& value){
+    output.push_back('"');
+    for (auto c : value){
+        if (c == '"' || c == '\\'){
+            output.push_back('\\');
+            output.push_back(c);
+        }
+        else if (static_cast<unsigned char>(c) < 0x20){
+            static const char digits[] = "0123456789abcdef";
+            output += "\\u00";
+            output.push_back(digits[(c >> 4) & 0xf]);
+            output.push_back(digits[c & 0xf]);
+        }
+        else output.push_back(c);
+    }
+    output.push_back('"');
+}
+
+/// Appends nanoseconds as microseconds, the unit of the trace format.
+void AppendMicroseconds(std::string& output, uint64_t nanoseconds){
+    output += std::to_string(nanoseconds / 1000);
+    output.push_back('.');
+    auto fraction = std::to_string(nanoseconds % 1000);
+    output.append(3 - fraction.size(), '0');
+    output += fraction;
+}
+
+}
+
+std::atomic<bool> trace_detail::enabled{false};
+
+uint64_t trace_detail::Now(){
+    static const auto traceEpoch = std::chrono::steady_clock::now();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - traceEpoch).count());
+}
+
+void trace_detail::Record(const char* name, const char* category, uint64_t start, uint64_t end){
+    auto& buffer = GetThreadBuffer();
+    std::lock_guard lock(buffer.mutex);
+    buffer.events.push_back(TraceEvent{name, category, start, end - start, buffer.thread});
+}
+
+void StartTracing(){
+    trace_detail::enabled.store(true);
+}
+
+void StopTracing(){
+    trace_detail::enabled.store(false);
+}
+
+void SetTraceThreadName(const std::string& name){
+    auto& buffer = GetThreadBuffer();
+    std::lock_guard lock(buffer.mutex);
+    buffer.name = name;
+}
+
+std::vector<TraceEvent> CollectTraceEvents(){
+    std::vector<TraceEvent> events;
+    auto& registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+    for (const auto& buffer : registry.buffers){
+        std::lock_guard bufferLock(buffer->mutex);
+        events.insert(events.end(), buffer->events.begin(), buffer->events.end());
+    }
+    std::stable_sort(events.begin(), events.end(), [](const auto& elem1, const auto& elem2){
+        return elem1.start < elem2.start;
+    });
+    return events;
+}
+
+void ClearTraceEvents(){
+    auto& registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+    for (const auto& buffer : registry.buffers){
+        std::lock_guard bufferLock(buffer->mutex);
+        buffer->events.clear();
+    }
+}
+
+bool WriteTrace(const std::string& filename){
+    std::string output = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    auto separate = [&]{
+        if (!first) output.push_back(',');
+        output.push_back('\n');
+        first = false;
+    };
+
+    {
+        auto& registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+        for (const auto& buffer : registry.buffers){
+            std::lock_guard bufferLock(buffer->mutex);
+            if (buffer->name.empty()) continue;
+            separate();
+            output += "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" + std::to_string(buffer->thread) +
+                      ",\"args\":{\"name\":";
+            AppendJsonString(output, buffer->name);
+            output += "}}";
+        }
+    }
+    for (const auto& event : CollectTraceEvents()){
+        separate();
+        output += "{\"ph\":\"X\",\"name\":";
+        AppendJsonString(output, event.name);
+        output += ",\"cat\":";
+        AppendJsonString(output, event.category);
+        output += ",\"pid\":1,\"tid\":" + std::to_string(event.thread) + ",\"ts\":";
+        AppendMicroseconds(output, event.start);
+        output += ",\"dur\":";
+        AppendMicroseconds(output, event.duration);
+        output.push_back('}');
+    }
+    output += "\n]}\n";
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open())
+        return false;
+    file.write(output.data(), static_cast<std::streamsize>(output.size()));
+    file.close();
+    return static_cast<bool>(file);
+}
+
+TraceSession::TraceSession(std::string _filename) : filename(std::move(_filename)){
+    if (!filename.empty()) StartTracing();
+}
+
+bool TraceSession::Finish(){
+    if (filename.empty()) return true;
+    StopTracing();
+    auto written = WriteTrace(filename);
+    filename.clear();
+    return written;
+}
+
+TraceSession::~TraceSession(){
+    Finish();
+}
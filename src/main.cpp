@@ -1,60 +1,217 @@
+#include <cctype>
 #include <fstream>
 #include <filesystem>
+#include <iomanip>
+#include <limits>
+#include <stdexcept>
+#include <string>
 #include "static/GeometryObjects.h"
 #include "static/3DMathOperations.h"
 #include "static/NearestPointsAlgorithm.h"
+#include "static/AdaptiveEngine.h"
+#include "static/CompactSegmentIndex.h"
+#include "static/MemoryBudget.h"
+#include "static/PlanarPolyline.h"
+#include "static/PolylineArcLength.h"
+#include "static/QueryPipeline.h"
+#include "static/Trace.h"
 #include <iostream>
+#include <vector>
 
-int main(int argc, char* argv[])
+/**
+ * @brief Prints the usage of the program.
+ * @param program Name of the executable.
+ */
+static void PrintUsage(const char* program){
+    std::cerr << "Usage: " << program << " <filename> <x_coord> <y_coord> <z_coord> [--trace <trace_file>]\n"
+              << "       " << program << " <filename> --batch <queries_file|-> [--format text|binary]"
+              << " [--trace <trace_file>]\n"
+              << "       " << program << " <filename> --memory [<budget_bytes>]\n";
+}
+
+/**
+ * @brief Parses a memory budget, rejecting signs and text that is not a whole number of bytes.
+ * @param text The argument.
+ * @param budget Receives the budget in bytes.
+ * @return True if the whole text is a valid budget.
+ */
+static bool ParseMemoryBudget(const std::string& text, size_t& budget){
+    if (text.empty() || !std::isdigit(static_cast<unsigned char>(text[0])))
+        return false;
+    try{
+        size_t pos = 0;
+        auto value = std::stoull(text, &pos);
+        if (pos != text.size() || value > std::numeric_limits<size_t>::max())
+            return false;
+        budget = static_cast<size_t>(value);
+        return true;
+    } catch (const std::logic_error&){
+        return false;
+    }
+}
+
+/**
+ * @brief Runs the program without the trace option.
+ * @param argc Number of arguments.
+ * @param argv The arguments.
+ * @return Exit code.
+ */
+static int Run(int argc, char* argv[])
 {
     /// Check if the correct number of arguments is provided
-    if (argc != 5){
-        std::cerr << "Usage: " << argv[0] << "<filename> <x_coord> <y_coord> <z_coord>";
+    auto batch = argc >= 4 && std::string(argv[2]) == "--batch";
+    auto memory = argc >= 3 && std::string(argv[2]) == "--memory";
+    auto format = BatchOutputFormat::Text;
+    size_t budget = 0;
+    if (memory){
+        if (argc > 4){
+            PrintUsage(argv[0]);
+            return 1;
+        }
+        if (argc == 4 && !ParseMemoryBudget(argv[3], budget)){
+            std::cerr << "Invalid memory budget: " << argv[3] << ". Please enter a number of bytes.\n";
+            return 3;
+        }
+    }
+    else if (batch && argc == 6 && std::string(argv[4]) == "--format"){
+        std::string formatName = argv[5];
+        if (formatName == "binary") format = BatchOutputFormat::Binary;
+        else if (formatName != "text"){
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    else if (batch ? argc != 4 : argc != 5){
+        PrintUsage(argv[0]);
         return 1;
     }
 
     /// Get filename from command line
-    std::filesystem::path dataDir = std::filesystem::path(argv[1]); 
+    std::filesystem::path dataDir = std::filesystem::path(argv[1]);
     std::string filename = dataDir.string();
+    std::string queriesSource = batch && std::string(argv[3]) != "-" ? argv[3] : "standard input";
 
     try{
-        /// Get coordinates of point from command line and convert to double
-        auto point_x = std::stod(argv[2]);
-        auto point_y = std::stod(argv[3]);
-        auto point_z = std::stod(argv[4]);
+        Point3D point;
+        if (!batch && !memory){
+            /// Get coordinates of point from command line and convert to double
+            auto point_x = std::stod(argv[2]);
+            auto point_y = std::stod(argv[3]);
+            auto point_z = std::stod(argv[4]);
 
-        Point3D point(point_x, point_y, point_z);
+            point = Point3D(point_x, point_y, point_z);
+        }
 
         /// Read coordinates of Polyline from file
-        std::ifstream file(filename);
-        if (!file.is_open()){
-            std::cerr << "Error opening file: " << filename;
-            return 2;
-        }
         Polyline3D poly;
-        auto x = 0.0;
-        auto y = 0.0;
-        auto z = 0.0;
-        while (file >> x >> y >> z){
-            poly.AddPoint({x, y, z});
+        {
+            TraceScope parse("parse_polyline", "load");
+            std::ifstream file(filename);
+            if (!file.is_open()){
+                std::cerr << "Error opening file: " << filename;
+                return 2;
+            }
+            auto x = 0.0;
+            auto y = 0.0;
+            auto z = 0.0;
+            while (file >> x >> y >> z){
+                poly.AddPoint({x, y, z});
+            }
+            file.close();
+        }
+
+        if (memory){
+            /// Report the polyline and every structure that can be prepared for it
+            SegmentIndex index(poly);
+            std::vector<MemoryReportEntry> entries{
+                {"polyline", poly.GetMemoryUsage()},
+                {"arc_length_table", ArcLengthTable(poly).GetMemoryUsage()},
+                {"segment_index", index.GetMemoryUsage()},
+                {"compact_segment_index", CompactSegmentIndex(index).GetMemoryUsage()},
+                {"planar_polyline", PlanarPolyline3D(poly).GetMemoryUsage()}
+            };
+            WriteMemoryReport(std::cout, entries);
+            if (argc == 4){
+                BudgetedSegmentIndex budgeted(poly, budget);
+                const auto& report = budgeted.GetReport();
+                std::cout << "\nWithin a budget of " << report.memoryBudget << " bytes: ";
+                if (report.leafSize == 0) std::cout << "no index, queries scan every segment";
+                else std::cout << (report.compact ? "compact" : "segment") << " index with leaf size " << report.leafSize
+                               << ", " << report.memoryUsage << " bytes";
+                std::cout << ", queries take " << std::fixed << std::setprecision(2) << report.querySlowdown << " times as long as with the segment index of "
+                          << report.defaultMemoryUsage << " bytes\n";
+            }
+            return 0;
+        }
+
+        if (batch){
+            /// Answer query points from a file or from standard input
+            std::string queriesName = argv[3];
+            std::ifstream queriesFile;
+            if (queriesName != "-"){
+                queriesFile.open(queriesName, std::ios::binary);
+                if (!queriesFile.is_open()){
+                    std::cerr << "Error opening file: " << queriesName;
+                    return 2;
+                }
+            }
+            std::istream& queries = queriesName == "-" ? std::cin : queriesFile;
+
+            std::ios::sync_with_stdio(false);
+            TraceScope run("query_pipeline", "query");
+            RunQueryPipeline(poly, queries, std::cout, format, &EngineCalibration::Get());
+            std::cout.flush();
+            if (!std::cout){
+                std::cerr << "Error writing the answers to standard output\n";
+                return 2;
+            }
+            return 0;
         }
-        file.close();
 
         /// Find and display nearest points
-        auto ans = FindNearestPointsToPolyline(poly, point);
+        std::vector<std::pair<size_t, Point3D>> ans;
+        {
+            TraceScope query("nearest_points", "query");
+            ans = FindNearestPointsToPolyline(poly, point);
+        }
         std::cout << "Found solutions: " << ans.size() << "\n";
         for (const auto& pair : ans){
             std::cout << "Segment " << pair.first + 1 << " : " << pair.second << "\n";
         }
 
     } catch (const std::invalid_argument& e){
-        std::cerr << "Invalid argument for coordinates. Please enter valid numbers.\n";
+        if (batch) std::cerr << "Invalid query points in " << queriesSource << ".\n" << e.what() << "\n";
+        else if (memory) std::cerr << "Cannot report the memory usage of " << filename << ".\n" << e.what() << "\n";
+        else std::cerr << "Invalid argument for coordinates. Please enter valid numbers.\n";
         return 3;
 
     } catch (const std::out_of_range& e) {
-        std::cerr << "One or more coordinates are out of range.\n";
+        if (batch) std::cerr << "Query points in " << queriesSource << " are out of range.\n" << e.what() << "\n";
+        else if (memory) std::cerr << "Cannot report the memory usage of " << filename << ".\n" << e.what() << "\n";
+        else std::cerr << "One or more coordinates are out of range.\n";
         return 4;
     }
 
     return 0;
 }
+
+int main(int argc, char* argv[])
+{
+    /// Take the trace option out of the arguments, it may appear anywhere
+    std::string traceName;
+    std::vector<char*> arguments;
+    for (int i = 0; i < argc; ++i){
+        if (std::string(argv[i]) == "--trace" && i + 1 < argc) traceName = argv[++i];
+        else arguments.push_back(argv[i]);
+    }
+
+    /// Records the phases of the run and writes them afterwards
+    TraceSession trace(traceName);
+    if (!traceName.empty()) SetTraceThreadName("main");
+    auto status = Run(static_cast<int>(arguments.size()), arguments.data());
+    if (!trace.Finish()){
+        std::cerr << "Error writing trace file: " << traceName << "\n";
+        if (status == 0) status = 2;
+    }
+    return status;
+}
@@ -203,4 +203,43 @@ TEST(PointProjectionOnLineThroughSegmentTests, PointOnSegment) {
     EXPECT_NEAR(projected.GetX(), 2.0, eps); 
     EXPECT_NEAR(projected.GetY(), 2.0, eps);
     EXPECT_NEAR(projected.GetZ(), 2.0, eps);
-}
\ No newline at end of file
+}
+
+TEST(DistanceFromPointToBoxTests, PointInside) {
+    Box3D box(Point3D(0.0, 0.0, 0.0), Point3D(2.0, 2.0, 2.0));
+    EXPECT_NEAR(DistanceFromPointToBox(Point3D(1.0, 1.0, 1.0), box), 0.0, eps);
+}
+
+TEST(DistanceFromPointToBoxTests, PointNearFace) {
+    Box3D box(Point3D(0.0, 0.0, 0.0), Point3D(2.0, 2.0, 2.0));
+    EXPECT_NEAR(DistanceFromPointToBox(Point3D(1.0, 5.0, 1.0), box), 3.0, eps);
+}
+
+TEST(DistanceFromPointToBoxTests, PointNearCorner) {
+    Box3D box(Point3D(0.0, 0.0, 0.0), Point3D(2.0, 2.0, 2.0));
+    EXPECT_NEAR(DistanceFromPointToBox(Point3D(-1.0, -1.0, -1.0), box), std::sqrt(3.0), eps);
+}
+
+
+TEST(VectorProductTests, OrthogonalVectors) {
+    Vector3D result = VectorProduct(Vector3D(1.0, 0.0, 0.0), Vector3D(0.0, 1.0, 0.0));
+    EXPECT_NEAR(result.GetX(), 0.0, eps);
+    EXPECT_NEAR(result.GetY(), 0.0, eps);
+    EXPECT_NEAR(result.GetZ(), 1.0, eps);
+}
+
+TEST(VectorProductTests, ParallelVectors) {
+    Vector3D result = VectorProduct(Vector3D(1.0, 2.0, 3.0), Vector3D(2.0, 4.0, 6.0));
+    EXPECT_NEAR(LengthOfVector(result), 0.0, eps);
+}
+
+TEST(VectorProductTests, Anticommutative) {
+    Vector3D vec1(1.0, -2.0, 0.5);
+    Vector3D vec2(3.0, 1.0, -1.0);
+    Vector3D result1 = VectorProduct(vec1, vec2);
+    Vector3D result2 = VectorProduct(vec2, vec1);
+    EXPECT_NEAR(result1.GetX(), -result2.GetX(), eps);
+    EXPECT_NEAR(result1.GetY(), -result2.GetY(), eps);
+    EXPECT_NEAR(result1.GetZ(), -result2.GetZ(), eps);
+    EXPECT_NEAR(ScalarProduct(result1, vec1), 0.0, eps);
+}
@@ -0,0 +1,94 @@
+#include "gtest/gtest.h"
+#include "TestPolylines.h"
+#include "static/AdaptiveEngine.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/GeometryObjects.h"
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+
+/// Costs where threads never pay off, so that choices do not depend on the machine.
+static EngineCalibration SingleThreadCalibration(){
+    EngineCalibration calibration;
+    calibration.threads = 1;
+    return calibration;
+}
+
+TEST(AdaptiveEngineTests, SelectsByWorkload) {
+    auto calibration = SingleThreadCalibration();
+
+    /// Tiny polylines and single queries are not worth an index
+    EXPECT_EQ(SelectEngine(calibration, {4, false, 1, false, false}).engine, NearestPointsEngine::BruteForce);
+    EXPECT_EQ(SelectEngine(calibration, {4, false, 1000, false, false}).engine, NearestPointsEngine::Batch);
+    EXPECT_EQ(SelectEngine(calibration, {1000000, false, 1, false, false}).engine, NearestPointsEngine::BruteForce);
+    EXPECT_EQ(SelectEngine(calibration, {1000000, false, 1000, false, false}).engine,
+              NearestPointsEngine::SegmentIndex);
+    /// A built index is used even for one query
+    EXPECT_EQ(SelectEngine(calibration, {1000000, false, 1, true, false}).engine, NearestPointsEngine::SegmentIndex);
+    EXPECT_EQ(SelectEngine(calibration, {1000000, true, 100000, false, false}).engine, NearestPointsEngine::Planar);
+    EXPECT_EQ(SelectEngine(calibration, {0, false, 10, false, false}).engine, NearestPointsEngine::BruteForce);
+
+    /// Threads pay off only for large batches
+    calibration.threads = 8;
+    EXPECT_EQ(SelectEngine(calibration, {1000, false, 20, false, false}).threads, 1);
+    EXPECT_EQ(SelectEngine(calibration, {1000, false, 100000, false, false}).threads, 8);
+    EXPECT_STREQ(EngineName(NearestPointsEngine::SegmentIndex), "segment_index");
+}
+
+TEST(AdaptiveEngineTests, EveryChoiceMatchesBruteForce) {
+    std::mt19937 gen(31);
+    std::uniform_real_distribution<double> coord(-5.0, 5.0);
+    std::vector<Point3D> nodes;
+    for (int i = 0; i < 3000; ++i) nodes.push_back(Point3D(coord(gen), coord(gen), 0.0));
+    Polyline3D poly(nodes);
+    std::vector<Point3D> points;
+    for (int i = 0; i < 200; ++i) points.push_back(Point3D(coord(gen), coord(gen), coord(gen)));
+
+    AdaptiveNearestPoints adaptive(poly, SingleThreadCalibration());
+    auto check = [&](const std::vector<std::vector<std::pair<size_t, Point3D>>>& results, size_t count){
+        for (size_t i = 0; i < count; ++i){
+            ExpectSameResults(results[i], FindNearestPointsToPolyline(poly, points[i]));
+        }
+    };
+
+    check({adaptive.FindNearestPoints(points[0])}, 1);
+    EXPECT_EQ(adaptive.GetLastChoice().engine, NearestPointsEngine::BruteForce);
+    check(adaptive.FindNearestPoints(std::vector<Point3D>(points.begin(), points.begin() + 20)), 20);
+    EXPECT_EQ(adaptive.GetLastChoice().engine, NearestPointsEngine::Batch);
+    check(adaptive.FindNearestPoints(points), points.size());
+    EXPECT_EQ(adaptive.GetLastChoice().engine, NearestPointsEngine::Planar);
+
+    /// Several threads give the same results
+    auto calibration = SingleThreadCalibration();
+    calibration.threads = 4;
+    calibration.threadStart = 1.0;
+    AdaptiveNearestPoints parallel(poly, calibration);
+    check(parallel.FindNearestPoints(points), points.size());
+    EXPECT_EQ(parallel.GetLastChoice().threads, 4);
+}
+
+TEST(AdaptiveEngineTests, CalibrationCacheFile) {
+    std::string filename = "adaptive_engine_tests/calibration.txt";
+    auto measured = EngineCalibration::Measure();
+    EXPECT_GT(measured.bruteForceSegment, 0.0);
+    EXPECT_GT(measured.indexQueryLevel, 0.0);
+    ASSERT_TRUE(measured.Save(filename));
+
+    auto loaded = EngineCalibration::Load(filename);
+    ASSERT_TRUE(loaded.has_value());
+    EXPECT_DOUBLE_EQ(loaded->batchSegment, measured.batchSegment);
+    EXPECT_DOUBLE_EQ(loaded->planarQuery, measured.planarQuery);
+    EXPECT_EQ(loaded->threads, measured.threads);
+
+    /// Calibrations of another machine are measured again
+    auto other = measured;
+    other.threads = measured.threads + 1;
+    ASSERT_TRUE(other.Save(filename));
+    EXPECT_FALSE(EngineCalibration::Load(filename).has_value());
+    EXPECT_FALSE(EngineCalibration::Load("adaptive_engine_tests/missing.txt").has_value());
+    std::remove(filename.c_str());
+    std::remove("adaptive_engine_tests");
+}
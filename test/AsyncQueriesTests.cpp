@@ -0,0 +1,139 @@
+#include "gtest/gtest.h"
+#include "TestPolylines.h"
+#include "static/AsyncQueries.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/GeometryObjects.h"
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+
+TEST(AsyncQueriesTests, MatchesBruteForce) {
+    auto poly = RandomWalk(2000, 1);
+    AsyncNearestPoints executor(poly, AsyncQueryOptions{4, 16, std::chrono::microseconds(20)});
+    EXPECT_THROW(AsyncNearestPoints(poly, AsyncQueryOptions{1, 0}), std::invalid_argument);
+
+    auto points = RandomPoints(200, 2, 15.0);
+    std::vector<AsyncQuery> queries;
+    for (const auto& point : points) queries.push_back(executor.Submit(point));
+    for (size_t i = 0; i < points.size(); ++i){
+        EXPECT_EQ(queries[i].Get().status, AsyncQueryStatus::Completed);
+        ExpectSameResults(queries[i].Get().points, FindNearestPointsToPolyline(poly, points[i]));
+        EXPECT_TRUE(queries[i].IsReady());
+    }
+}
+
+TEST(AsyncQueriesTests, BatchesSubmissions) {
+    auto poly = RandomWalk(500, 3);
+    AsyncNearestPoints executor(poly, AsyncQueryOptions{1, 64, std::chrono::milliseconds(20)});
+
+    std::vector<Point3D> points;
+    for (int i = 0; i < 128; ++i) points.push_back(Point3D(i * 0.1, 0.0, 0.0));
+    auto queries = executor.SubmitBatch(points);
+    for (size_t i = 0; i < points.size(); ++i){
+        EXPECT_EQ(queries[i].GetFuture().get().status, AsyncQueryStatus::Completed);
+        ExpectSameResults(queries[i].GetFuture().get().points, FindNearestPointsToPolyline(poly, points[i]));
+    }
+    EXPECT_EQ(executor.GetBatchesCount(), 2);
+
+    /// A submission alone waits at most the batch delay
+    auto start = std::chrono::steady_clock::now();
+    executor.Submit(Point3D(0.0, 0.0, 0.0)).Get();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+    EXPECT_EQ(executor.GetBatchesCount(), 3);
+}
+
+TEST(AsyncQueriesTests, CancellationAndDeadlines) {
+    auto poly = RandomWalk(500, 4);
+    AsyncNearestPoints executor(poly, AsyncQueryOptions{1, 64, std::chrono::milliseconds(50)});
+
+    auto cancelled = executor.Submit(Point3D(1.0, 1.0, 1.0));
+    EXPECT_TRUE(cancelled.Cancel());
+    EXPECT_TRUE(cancelled.IsReady());
+    EXPECT_EQ(cancelled.Get().status, AsyncQueryStatus::Cancelled);
+    EXPECT_FALSE(cancelled.Cancel());
+
+    auto late = executor.Submit(Point3D(1.0, 1.0, 1.0), AsyncNearestPoints::Clock::now() - std::chrono::seconds(1));
+    auto budget = executor.Submit(Point3D(1.0, 1.0, 1.0), std::chrono::seconds(60));
+    EXPECT_EQ(late.Get().status, AsyncQueryStatus::DeadlineExceeded);
+    EXPECT_TRUE(late.Get().points.empty());
+    EXPECT_EQ(budget.Get().status, AsyncQueryStatus::Completed);
+    ExpectSameResults(budget.Get().points, FindNearestPointsToPolyline(poly, Point3D(1.0, 1.0, 1.0)));
+    EXPECT_FALSE(budget.Cancel());
+}
+
+TEST(AsyncQueriesTests, CallbacksAndShutdown) {
+    auto poly = RandomWalk(500, 5);
+    std::atomic<int> completed{0};
+    std::atomic<int> cancelled{0};
+    {
+        AsyncNearestPoints executor(poly, AsyncQueryOptions{2, 8, std::chrono::microseconds(10)});
+        auto query = executor.Submit(Point3D(0.0, 1.0, 0.0));
+        /// Every callback registered before completion runs
+        for (int i = 0; i < 2; ++i){
+            query.OnComplete([&](const AsyncQueryResult& result){
+                if (result.status == AsyncQueryStatus::Completed) ++completed;
+            });
+        }
+        while (completed.load() < 2) std::this_thread::yield();
+
+        /// Registered after completion, the callback runs at once
+        query.OnComplete([&](const AsyncQueryResult&){ ++completed; });
+        EXPECT_EQ(completed.load(), 3);
+    }
+    {
+        /// Queries still waiting for their batch are cancelled by the destructor
+        AsyncNearestPoints executor(poly, AsyncQueryOptions{1, 64, std::chrono::seconds(10)});
+        for (int i = 0; i < 5; ++i){
+            executor.Submit(Point3D(i, 0.0, 0.0)).OnComplete([&](const AsyncQueryResult& result){
+                if (result.status == AsyncQueryStatus::Cancelled) ++cancelled;
+            });
+        }
+    }
+    EXPECT_EQ(cancelled.load(), 5);
+}
+
+#ifdef NEARESTPOINTS_HAS_COROUTINES
+/// Coroutine that starts at once and is never awaited itself.
+struct DetachedTask{
+    struct promise_type{
+        DetachedTask get_return_object() {return {};}
+        std::suspend_never initial_suspend() noexcept {return {};}
+        std::suspend_never final_suspend() noexcept {return {};}
+        void return_void() {}
+        void unhandled_exception() {std::terminate();}
+    };
+};
+
+static DetachedTask AwaitQuery(AsyncQuery query, AsyncQueryResult& result, std::atomic<bool>& resumed){
+    result = co_await query;
+    resumed = true;
+}
+
+TEST(AsyncQueriesTests, CoroutinesAwaitQueries) {
+    auto poly = RandomWalk(500, 6);
+    AsyncNearestPoints executor(poly, AsyncQueryOptions{1, 64, std::chrono::milliseconds(20)});
+
+    /// The coroutine suspends until the worker answers, and a callback registered too still runs
+    AsyncQueryResult result;
+    std::atomic<bool> resumed{false};
+    std::atomic<bool> called{false};
+    auto query = executor.Submit(Point3D(2.0, 0.0, 1.0));
+    AwaitQuery(query, result, resumed);
+    query.OnComplete([&](const AsyncQueryResult&){ called = true; });
+    while (!resumed.load() || !called.load()) std::this_thread::yield();
+    EXPECT_EQ(result.status, AsyncQueryStatus::Completed);
+    ExpectSameResults(result.points, FindNearestPointsToPolyline(poly, Point3D(2.0, 0.0, 1.0)));
+
+    /// A finished query does not suspend
+    AsyncQueryResult again;
+    std::atomic<bool> ready{false};
+    AwaitQuery(query, again, ready);
+    EXPECT_TRUE(ready.load());
+    EXPECT_EQ(again.status, AsyncQueryStatus::Completed);
+    ExpectSameResults(again.points, result.points);
+}
+#endif
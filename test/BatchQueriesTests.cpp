@@ -0,0 +1,55 @@
+#include "gtest/gtest.h"
+#include "TestPolylines.h"
+#include "static/BatchQueries.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/GeometryObjects.h"
+
+
+TEST(MortonCodeTests, InterleavesBits) {
+    EXPECT_EQ(MortonCode(0, 0, 0), 0);
+    EXPECT_EQ(MortonCode(1, 0, 0), 1);
+    EXPECT_EQ(MortonCode(0, 1, 0), 2);
+    EXPECT_EQ(MortonCode(0, 0, 1), 4);
+    EXPECT_EQ(MortonCode(3, 0, 0), 9);
+    EXPECT_EQ(MortonCode(0x1FFFFF, 0x1FFFFF, 0x1FFFFF), 0x7FFFFFFFFFFFFFFF);
+}
+
+TEST(BatchQueriesTests, EmptyInputs) {
+    Polyline3D poly({{0.0, 0.0, 0.0}});
+    std::vector<Point3D> points{{1.0, 1.0, 1.0}, {2.0, 2.0, 2.0}};
+
+    auto ans = FindNearestPointsToPolylineBatch(poly, points);
+    ASSERT_EQ(ans.size(), 2);
+    EXPECT_TRUE(ans[0].empty());
+    EXPECT_TRUE(ans[1].empty());
+
+    EXPECT_TRUE(FindNearestPointsToPolylineBatch(poly, {}).empty());
+}
+
+TEST(BatchQueriesTests, SymmetricTies) {
+    Polyline3D poly({{0.0, 0.0, 0.0}, {2.0, 0.0, 0.0}, {2.0, 2.0, 0.0}, {0.0, 2.0, 0.0}, {0.0, 0.0, 0.0}});
+    std::vector<Point3D> points{{1.0, 1.0, 1.0}, {3.0, 3.0, 3.0}, {1.0, 1.0, -1.0}};
+
+    auto ans = FindNearestPointsToPolylineBatch(poly, points);
+
+    ASSERT_EQ(ans.size(), points.size());
+    for (size_t i = 0; i < points.size(); ++i){
+        ExpectSameResults(ans[i], FindNearestPointsToPolyline(poly, points[i]));
+    }
+    EXPECT_EQ(ans[0].size(), 4);
+}
+
+TEST(BatchQueriesTests, MatchesSingleQueries) {
+    /// Some degenerate segments
+    auto poly = RandomWalk(3000, 7, RandomWalkOptions{Point3D(), 1.0, 10});
+    auto points = RandomPoints(203, 8, 30.0);
+    /// Query points lying exactly on nodes
+    for (int i = 0; i < 20; ++i) points.push_back(poly.GetNodes()[i * 100]);
+
+    auto ans = FindNearestPointsToPolylineBatch(poly, points);
+
+    ASSERT_EQ(ans.size(), points.size());
+    for (size_t i = 0; i < points.size(); ++i){
+        ExpectSameResults(ans[i], FindNearestPointsToPolyline(poly, points[i]));
+    }
+}
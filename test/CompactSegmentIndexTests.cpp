@@ -0,0 +1,71 @@
+#include "gtest/gtest.h"
+#include "TestPolylines.h"
+#include "static/CompactSegmentIndex.h"
+#include "static/SegmentIndex.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/GeometryObjects.h"
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+/// Nearly planar walks with a repeated node every 50 nodes
+static const RandomWalkOptions flatWithDuplicates{Point3D(), 0.01, 50};
+
+TEST(CompactSegmentIndexTests, SmallPolylines) {
+    Polyline3D empty;
+    CompactSegmentIndex emptyIndex(SegmentIndex{empty});
+    EXPECT_EQ(emptyIndex.GetLeavesCount(), 0);
+    EXPECT_TRUE(FindNearestPointsToIndexedPolyline(empty, emptyIndex, Point3D()).empty());
+
+    /// A polyline fitting into one leaf has no inner nodes
+    Polyline3D poly({{0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}, {1.0, 1.0, 0.0}});
+    CompactSegmentIndex index(SegmentIndex{poly});
+    EXPECT_TRUE(index.GetNodes().empty());
+    EXPECT_EQ(index.GetRoot(), CompactSegmentIndex::leafFlag);
+    auto ans = FindNearestPointsToIndexedPolyline(poly, index, Point3D(2.0, 0.5, 0.0));
+    ASSERT_EQ(ans.size(), 1);
+    EXPECT_EQ(ans[0].first, 1);
+    EXPECT_THROW(FindNearestPointsToIndexedPolyline(empty, index, Point3D()), std::invalid_argument);
+}
+
+TEST(CompactSegmentIndexTests, LayoutsHoldTheSameTree) {
+    auto poly = RandomWalk(700, 1, flatWithDuplicates);
+    SegmentIndex source(poly, 2);
+    CompactSegmentIndex veb(source);
+    CompactSegmentIndex bfs(source, CompactSegmentIndex::Layout::BreadthFirst);
+
+    size_t leaves = 0;
+    for (size_t i = 0; i < source.GetNodesCount(); ++i) leaves += source.GetNodes()[i].right == 0;
+    EXPECT_EQ(veb.GetLeavesCount(), leaves);
+    EXPECT_EQ(veb.GetNodes().size(), source.GetNodesCount() - leaves);
+    EXPECT_EQ(bfs.GetNodes().size(), veb.GetNodes().size());
+    EXPECT_EQ(veb.GetRoot(), 0);
+    EXPECT_LT(veb.GetMemoryUsage(), source.GetMemoryUsage());
+
+    /// Every inner node is referenced exactly once
+    std::vector<int> references(veb.GetNodes().size(), 0);
+    for (const auto& node : veb.GetNodes()){
+        for (auto child : node.child){
+            if (!(child & CompactSegmentIndex::leafFlag)) ++references[child];
+        }
+    }
+    EXPECT_EQ(references[0], 0);
+    for (size_t i = 1; i < references.size(); ++i) EXPECT_EQ(references[i], 1);
+}
+
+TEST(CompactSegmentIndexTests, MatchesBruteForce) {
+    auto poly = RandomWalk(900, 2, flatWithDuplicates);
+    SegmentIndex source(poly);
+    CompactSegmentIndex veb(source);
+    CompactSegmentIndex bfs(source, CompactSegmentIndex::Layout::BreadthFirst);
+
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<double> coord(-15.0, 15.0);
+    for (int i = 0; i < 100; ++i){
+        Point3D point(coord(gen), coord(gen), coord(gen));
+        auto expected = FindNearestPointsToPolyline(poly, point);
+        for (const auto* index : {&veb, &bfs}){
+            ExpectSameResults(FindNearestPointsToIndexedPolyline(poly, *index, point), expected);
+        }
+    }
+}
@@ -0,0 +1,101 @@
+#include "gtest/gtest.h"
+#include "TestPolylines.h"
+#include "static/CompressedPolyline.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/3DMathOperations.h"
+#include "static/GeometryObjects.h"
+#include <random>
+#include <stdexcept>
+
+/// Walks away from the origin, so that coordinates are not small
+static const RandomWalkOptions offset{Point3D(100.0, -50.0, 3.0)};
+
+TEST(CompressedPolylineTests, EmptyPolyline) {
+    CompressedPolyline3D compressed(Polyline3D(), 0.01);
+
+    EXPECT_EQ(compressed.GetNodesCount(), 0);
+    EXPECT_EQ(compressed.GetBlocksCount(), 0);
+    EXPECT_EQ(FindNearestPointsToCompressedPolyline(compressed, Point3D()).size(), 0);
+}
+
+TEST(CompressedPolylineTests, SingleNode) {
+    CompressedPolyline3D compressed(Polyline3D({{1.0, 2.0, 3.0}}), 0.01);
+
+    EXPECT_EQ(compressed.GetBlocksCount(), 1);
+    EXPECT_EQ(compressed.Decompress().GetNodesCount(), 1);
+    EXPECT_EQ(FindNearestPointsToCompressedPolyline(compressed, Point3D()).size(), 0);
+}
+
+TEST(CompressedPolylineTests, DecompressWithinErrorBound) {
+    auto poly = RandomWalk(1000, 1, offset);
+    CompressedPolyline3D compressed(poly, 0.001, 16);
+
+    auto decoded = compressed.Decompress();
+    ASSERT_EQ(decoded.GetNodesCount(), poly.GetNodesCount());
+    EXPECT_EQ(compressed.GetBlocksCount(), (1000 - 1 + 15) / 16);
+    for (size_t i = 0; i < poly.GetNodesCount(); ++i){
+        EXPECT_LE(DistanceBetweenPoints(decoded.GetNodes()[i], poly.GetNodes()[i]), compressed.GetMaxError());
+    }
+}
+
+TEST(CompressedPolylineTests, BlockBoundsContainNodes) {
+    auto poly = RandomWalk(300, 2, offset);
+    CompressedPolyline3D compressed(poly, 0.01, 32);
+
+    std::vector<Point3D> nodes;
+    for (size_t block = 0; block < compressed.GetBlocksCount(); ++block){
+        compressed.DecodeBlock(block, nodes);
+        auto bounds = compressed.GetBlockBounds(block);
+        for (const auto& node : nodes){
+            EXPECT_NEAR(DistanceFromPointToBox(node, bounds), 0.0, eps);
+        }
+    }
+}
+
+TEST(CompressedPolylineTests, MemorySaving) {
+    auto poly = RandomWalk(10000, 3, offset);
+    CompressedPolyline3D compressed(poly, 0.001);
+
+    EXPECT_EQ(compressed.GetUncompressedSize(), 10000 * sizeof(Point3D));
+    EXPECT_LT(compressed.GetMemoryUsage() * 2, compressed.GetUncompressedSize());
+}
+
+TEST(CompressedPolylineTests, NearestPointsMatchDecompressed) {
+    auto poly = RandomWalk(2000, 4, offset);
+    CompressedPolyline3D compressed(poly, 0.001, 32);
+    auto decoded = compressed.Decompress();
+
+    std::mt19937 gen(5);
+    std::uniform_real_distribution<double> coord(-20.0, 20.0);
+    for (int i = 0; i < 50; ++i){
+        Point3D point(100.0 + coord(gen), -50.0 + coord(gen), 3.0 + coord(gen));
+
+        auto expected = FindNearestPointsToPolyline(decoded, point);
+        auto ans = FindNearestPointsToCompressedPolyline(compressed, point);
+
+        ExpectSameResults(ans, expected);
+        ASSERT_FALSE(ans.empty());
+
+        auto exact = FindNearestPointsToPolyline(poly, point);
+        EXPECT_NEAR(DistanceBetweenPoints(ans[0].second, point),
+                    DistanceBetweenPoints(exact[0].second, point), compressed.GetMaxError());
+    }
+}
+
+TEST(CompressedPolylineTests, SymmetricTies) {
+    Polyline3D poly({{0.0, 0.0, 0.0}, {2.0, 0.0, 0.0}, {2.0, 2.0, 0.0}, {0.0, 2.0, 0.0}, {0.0, 0.0, 0.0}});
+    CompressedPolyline3D compressed(poly, 0.5, 1);
+
+    auto ans = FindNearestPointsToCompressedPolyline(compressed, Point3D(1.0, 1.0, 1.0));
+
+    ASSERT_EQ(ans.size(), 4);
+    for (size_t i = 0; i < ans.size(); ++i) EXPECT_EQ(ans[i].first, i);
+}
+
+TEST(CompressedPolylineTests, InvalidParameters) {
+    Polyline3D poly({{0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}});
+
+    EXPECT_THROW(CompressedPolyline3D(poly, 0.0), std::invalid_argument);
+    EXPECT_THROW(CompressedPolyline3D(poly, 0.1, 0), std::invalid_argument);
+    EXPECT_THROW(CompressedPolyline3D(Polyline3D({{0.0, 0.0, 0.0}, {1e6, 0.0, 0.0}}), 1e-9), std::invalid_argument);
+}
@@ -0,0 +1,82 @@
+#include "gtest/gtest.h"
+#include "static/ConcurrentPolyline.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/GeometryObjects.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+TEST(ConcurrentPolylineTests, PublishAndUpdate) {
+    ConcurrentPolyline3D holder(Polyline3D({{0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}}));
+    EXPECT_EQ(holder.Read().GetVersion(), 1);
+
+    holder.Update([](Polyline3D& poly){ poly.AddPoint(Point3D(1.0, 1.0, 0.0)); });
+    auto snapshot = holder.Read();
+    EXPECT_EQ(snapshot.GetVersion(), 2);
+    EXPECT_EQ(snapshot->GetNodesCount(), 3);
+
+    auto ans = holder.FindNearestPoints(Point3D(2.0, 1.0, 0.0));
+    ASSERT_EQ(ans.size(), 1);
+    EXPECT_EQ(ans[0].first, 1);
+    EXPECT_TRUE(ans[0].second == Point3D(1.0, 1.0, 0.0));
+}
+
+TEST(ConcurrentPolylineTests, SnapshotKeepsItsVersion) {
+    ConcurrentPolyline3D holder(Polyline3D({{0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}}));
+    {
+        auto snapshot = holder.Read();
+        holder.Publish(Polyline3D({{5.0, 0.0, 0.0}, {6.0, 0.0, 0.0}}));
+        holder.Publish(Polyline3D({{7.0, 0.0, 0.0}, {8.0, 0.0, 0.0}}));
+
+        /// The replaced versions stay alive while a snapshot may refer to them
+        EXPECT_EQ(holder.GetRetiredCount(), 2);
+        EXPECT_TRUE(snapshot->GetNodes()[0] == Point3D(0.0, 0.0, 0.0));
+        EXPECT_TRUE(holder.Read()->GetNodes()[0] == Point3D(7.0, 0.0, 0.0));
+    }
+    holder.Reclaim();
+    EXPECT_EQ(holder.GetRetiredCount(), 0);
+}
+
+TEST(ConcurrentPolylineTests, ReadersSeeConsistentVersions) {
+    /// Every node of version v lies at x = v, so a torn version would have mixed coordinates
+    auto make = [](double tag, size_t count){
+        std::vector<Point3D> nodes;
+        for (size_t i = 0; i < count; ++i) nodes.push_back(Point3D(tag, static_cast<double>(i), 0.0));
+        return Polyline3D(std::move(nodes));
+    };
+    ConcurrentPolyline3D holder(make(1.0, 2));
+
+    std::atomic<bool> done{false};
+    std::atomic<size_t> failures{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 4; ++r){
+        readers.emplace_back([&](){
+            uint64_t lastVersion = 0;
+            while (!done.load()){
+                auto snapshot = holder.Read();
+                const auto& nodes = snapshot->GetNodes();
+                auto tag = static_cast<double>(snapshot.GetVersion());
+                for (const auto& node : nodes){
+                    if (node.GetX() != tag) ++failures;
+                }
+                if (snapshot.GetVersion() < lastVersion) ++failures;
+                lastVersion = snapshot.GetVersion();
+                auto ans = FindNearestPointsToPolyline(*snapshot, Point3D(0.0, 0.0, 0.0));
+                if (ans.empty() || ans[0].second.GetX() != tag) ++failures;
+            }
+        });
+    }
+
+    for (int v = 2; v <= 500; ++v){
+        if (v % 2 == 0) holder.Publish(make(v, 2 + v % 7));
+        else holder.Update([&](Polyline3D& poly){ poly = make(v, poly.GetNodesCount() + 1); });
+    }
+    done.store(true);
+    for (auto& reader : readers) reader.join();
+
+    EXPECT_EQ(failures.load(), 0);
+    EXPECT_EQ(holder.Read().GetVersion(), 500);
+    holder.Reclaim();
+    EXPECT_EQ(holder.GetRetiredCount(), 0);
+}
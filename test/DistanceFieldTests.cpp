@@ -0,0 +1,95 @@
+#include "gtest/gtest.h"
+#include "TestPolylines.h"
+#include "static/DistanceField.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/3DMathOperations.h"
+#include "static/GeometryObjects.h"
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+
+static Polyline3D Helix(size_t count){
+    std::vector<Point3D> nodes;
+    for (size_t i = 0; i < count; ++i){
+        auto angle = 0.2 * static_cast<double>(i);
+        nodes.push_back(Point3D(5.0 * std::cos(angle), 5.0 * std::sin(angle), 0.1 * static_cast<double>(i)));
+    }
+    return Polyline3D(std::move(nodes));
+}
+
+TEST(DistanceFieldTests, TooFewNodes) {
+    Polyline3D poly({{1.0, 1.0, 1.0}});
+    DistanceFieldEngine engine(poly, 0.5, 1.0);
+
+    EXPECT_EQ(engine.GetBricksCount(), 0);
+    EXPECT_FALSE(engine.IsInBand(Point3D(1.0, 1.0, 1.0)));
+    EXPECT_TRUE(engine.FindNearestPoints(Point3D(1.0, 1.0, 1.0)).empty());
+}
+
+TEST(DistanceFieldTests, InvalidParameters) {
+    auto poly = Helix(10);
+    EXPECT_THROW(DistanceFieldEngine(poly, 0.0, 1.0), std::invalid_argument);
+    EXPECT_THROW(DistanceFieldEngine(poly, 0.1, -1.0), std::invalid_argument);
+    EXPECT_THROW(DistanceFieldEngine(poly, 1e-12, 1.0), std::invalid_argument);
+}
+
+TEST(DistanceFieldTests, ResultsWithinErrorBound) {
+    auto poly = Helix(150);
+    DistanceFieldEngine engine(poly, 0.2, 1.0, 2);
+
+    EXPECT_GT(engine.GetBricksCount(), 0);
+    EXPECT_GT(engine.GetMemoryUsage(), engine.GetBricksCount() * 512 * sizeof(uint32_t) - 1);
+    EXPECT_GE(engine.GetBuildSeconds(), 0.0);
+
+    std::mt19937 gen(11);
+    std::uniform_int_distribution<size_t> node(0, 148);
+    std::uniform_real_distribution<double> offset(-0.6, 0.6);
+    const auto& nodes = poly.GetNodes();
+    for (int i = 0; i < 500; ++i){
+        const auto& base = nodes[node(gen)];
+        Point3D point(base.GetX() + offset(gen), base.GetY() + offset(gen), base.GetZ() + offset(gen));
+        ASSERT_TRUE(engine.IsInBand(point));
+
+        auto exact = FindNearestPointsToPolyline(poly, point);
+        auto ans = engine.FindNearestPoints(point);
+        ASSERT_FALSE(ans.empty());
+        EXPECT_LE(DistanceBetweenPoints(ans[0].second, point),
+                  DistanceBetweenPoints(exact[0].second, point) + engine.GetMaxError());
+    }
+}
+
+TEST(DistanceFieldTests, OutsideBandIsExact) {
+    auto poly = Helix(100);
+    DistanceFieldEngine engine(poly, 0.2, 0.5);
+
+    Point3D point(0.0, 0.0, 5.0);
+    EXPECT_FALSE(engine.IsInBand(point));
+
+    ExpectSameResults(engine.FindNearestPoints(point), FindNearestPointsToPolyline(poly, point));
+}
+
+TEST(DistanceFieldTests, SameResultForAnyThreadCount) {
+    auto poly = Helix(120);
+    DistanceFieldEngine single(poly, 0.25, 0.8, 1);
+    DistanceFieldEngine multi(poly, 0.25, 0.8, 4);
+
+    for (int i = 0; i < 200; ++i){
+        Point3D point(5.0 * std::cos(0.1 * i) + 0.3, 5.0 * std::sin(0.1 * i), 0.05 * i);
+        auto ans1 = single.FindNearestPoints(point);
+        auto ans2 = multi.FindNearestPoints(point);
+        ASSERT_EQ(ans1.size(), ans2.size());
+        for (size_t j = 0; j < ans1.size(); ++j) EXPECT_EQ(ans1[j].first, ans2[j].first);
+    }
+}
+
+TEST(DistanceFieldTests, PointOnPolyline) {
+    Polyline3D poly({{0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}, {2.0, 1.0, 0.0}, {3.0, 1.0, 1.0}});
+    DistanceFieldEngine engine(poly, 0.05, 0.3);
+
+    auto ans = engine.FindNearestPoints(Point3D(1.5, 0.5, 0.0));
+    ASSERT_EQ(ans.size(), 1);
+    EXPECT_EQ(ans[0].first, 1);
+    EXPECT_NEAR(ans[0].second.GetX(), 1.5, eps);
+    EXPECT_NEAR(ans[0].second.GetY(), 0.5, eps);
+}
@@ -0,0 +1,58 @@
+#include "gtest/gtest.h"
+#include "TestPolylines.h"
+#include "static/DistanceQueries.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/SegmentIndex.h"
+#include "static/3DMathOperations.h"
+#include "static/GeometryObjects.h"
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+
+TEST(DistanceQueriesTests, EmptyAndDegenerate) {
+    EXPECT_TRUE(std::isinf(DistanceToPolyline(Polyline3D(), Point3D())));
+    EXPECT_TRUE(std::isinf(DistanceToIndexedPolyline(Polyline3D(), SegmentIndex(), Point3D())));
+    EXPECT_FALSE(IsWithinDistance(Polyline3D({{1.0, 2.0, 3.0}}), Point3D(1.0, 2.0, 3.0), 1.0));
+
+    /// Without segments no distance is small enough, not even an infinite one
+    Polyline3D single({{1.0, 2.0, 3.0}});
+    const auto infinity = std::numeric_limits<double>::infinity();
+    EXPECT_FALSE(IsWithinDistance(single, Point3D(), infinity));
+    EXPECT_FALSE(IsWithinDistance(single, SegmentIndex(single), Point3D(), infinity));
+
+    Polyline3D poly({{0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, {3.0, 0.0, 0.0}});
+    EXPECT_NEAR(DistanceToPolyline(poly, Point3D(-3.0, 4.0, 0.0)), 5.0, eps);
+    EXPECT_THROW(IsWithinDistance(poly, Point3D(), -1.0), std::invalid_argument);
+    EXPECT_THROW(IsWithinDistance(poly, Point3D(), std::nan("")), std::invalid_argument);
+    EXPECT_THROW(DistanceToIndexedPolyline(poly, SegmentIndex(), Point3D()), std::invalid_argument);
+}
+
+TEST(DistanceQueriesTests, ThresholdIsInclusive) {
+    Polyline3D poly({{0.0, 0.0, 0.0}, {4.0, 0.0, 0.0}});
+    SegmentIndex index(poly);
+    Point3D point(2.0, 3.0, 0.0);
+
+    EXPECT_TRUE(IsWithinDistance(poly, point, 3.0));
+    EXPECT_TRUE(IsWithinDistance(poly, index, point, 3.0));
+    EXPECT_FALSE(IsWithinDistance(poly, point, 2.5));
+    EXPECT_FALSE(IsWithinDistance(poly, index, point, 2.5));
+    EXPECT_TRUE(IsWithinDistance(poly, index, Point3D(1.0, 0.0, 0.0), 0.0));
+}
+
+TEST(DistanceQueriesTests, MatchesNearestPoints) {
+    auto poly = RandomWalk(3001, 23);
+    SegmentIndex index(poly);
+
+    for (const auto& point : RandomPoints(200, 24, 30.0)){
+        auto nearest = FindNearestPointsToPolyline(poly, point);
+        auto expected = DistanceBetweenPoints(point, nearest[0].second);
+
+        EXPECT_NEAR(DistanceToPolyline(poly, point), expected, eps);
+        EXPECT_NEAR(DistanceToIndexedPolyline(poly, index, point), expected, eps);
+        for (auto radius : {0.5 * expected, 2.0 * expected}){
+            EXPECT_EQ(IsWithinDistance(poly, point, radius), radius >= expected);
+            EXPECT_EQ(IsWithinDistance(poly, index, point, radius), radius >= expected);
+        }
+    }
+}
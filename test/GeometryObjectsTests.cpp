@@ -166,3 +166,43 @@ TEST(Polyline3DTests, AddPoint) {
     EXPECT_NEAR(polyline.GetNodes()[0].GetZ(), 3.0, eps);
 }
 
+TEST(Polyline3DTests, SetNode) {
+    Polyline3D polyline({Point3D(1.0, 2.0, 3.0), Point3D(4.0, 5.0, 6.0)});
+    auto revision = polyline.GetRevision();
+    polyline.SetNode(1, Point3D(7.0, 8.0, 9.0));
+    EXPECT_NE(polyline.GetRevision(), revision);
+    EXPECT_NEAR(polyline.GetNodes()[1].GetX(), 7.0, eps);
+    EXPECT_NEAR(polyline.GetNodes()[0].GetX(), 1.0, eps);
+    EXPECT_THROW(polyline.SetNode(2, Point3D()), std::out_of_range);
+}
+
+
+// Box3D Tests
+
+TEST(Box3DTest, DefaultConstructorIsEmpty) {
+    Box3D box;
+    EXPECT_TRUE(box.IsEmpty());
+}
+
+TEST(Box3DTest, ExtendByPoints) {
+    Box3D box;
+    box.Extend(Point3D(1.0, -2.0, 3.0));
+    box.Extend(Point3D(-1.0, 2.0, 0.0));
+
+    EXPECT_FALSE(box.IsEmpty());
+    EXPECT_NEAR(box.GetMin().GetX(), -1.0, eps);
+    EXPECT_NEAR(box.GetMin().GetY(), -2.0, eps);
+    EXPECT_NEAR(box.GetMin().GetZ(), 0.0, eps);
+    EXPECT_NEAR(box.GetMax().GetX(), 1.0, eps);
+    EXPECT_NEAR(box.GetMax().GetY(), 2.0, eps);
+    EXPECT_NEAR(box.GetMax().GetZ(), 3.0, eps);
+}
+
+TEST(Box3DTest, ExtendByBox) {
+    Box3D box(Point3D(0.0, 0.0, 0.0), Point3D(1.0, 1.0, 1.0));
+    box.Extend(Box3D());
+    box.Extend(Box3D(Point3D(2.0, 2.0, 2.0), Point3D(3.0, 3.0, 3.0)));
+
+    EXPECT_NEAR(box.GetMin().GetX(), 0.0, eps);
+    EXPECT_NEAR(box.GetMax().GetZ(), 3.0, eps);
+}
@@ -0,0 +1,88 @@
+#include "gtest/gtest.h"
+#include "static/LocalMinima.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/SegmentIndex.h"
+#include "static/GeometryObjects.h"
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+
+TEST(LocalMinimaTests, EmptyAndZero) {
+    Polyline3D poly({{0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}});
+    SegmentIndex index(poly);
+
+    EXPECT_TRUE(FindNearestLocalMinima(poly, index, Point3D(0.5, 1.0, 0.0), 0).empty());
+    EXPECT_TRUE(FindNearestLocalMinima(Polyline3D(), SegmentIndex(), Point3D(), 3).empty());
+    EXPECT_THROW(FindNearestLocalMinima(Polyline3D(), index, Point3D(), 3), std::invalid_argument);
+}
+
+TEST(LocalMinimaTests, TwoPassesOfTrack) {
+    /// Out along y = 0 and back along y = 2, connected at x = 10
+    Polyline3D poly({{0.0, 0.0, 0.0}, {10.0, 0.0, 0.0}, {10.0, 2.0, 0.0}, {0.0, 2.0, 0.0}});
+    SegmentIndex index(poly, 1);
+
+    auto ans = FindNearestLocalMinima(poly, index, Point3D(5.0, 0.8, 0.0), 2);
+    ASSERT_EQ(ans.size(), 2);
+    EXPECT_EQ(ans[0].segment, 0);
+    EXPECT_NEAR(ans[0].distance, 0.8, eps);
+    EXPECT_NEAR(ans[0].point.GetX(), 5.0, eps);
+    EXPECT_EQ(ans[1].segment, 2);
+    EXPECT_NEAR(ans[1].distance, 1.2, eps);
+
+    /// The connecting segment has a minimum of its own
+    ans = FindNearestLocalMinima(poly, index, Point3D(5.0, 0.8, 0.0), 10);
+    ASSERT_EQ(ans.size(), 3);
+    EXPECT_EQ(ans[2].segment, 1);
+    EXPECT_NEAR(ans[2].distance, 5.0, eps);
+}
+
+TEST(LocalMinimaTests, SharedNodeIsMergedOnce) {
+    Polyline3D poly({{-1.0, 1.0, 0.0}, {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, {1.0, 1.0, 0.0}});
+    SegmentIndex index(poly, 1);
+
+    auto ans = FindNearestLocalMinima(poly, index, Point3D(0.0, -1.0, 0.0), 5);
+    ASSERT_EQ(ans.size(), 1);
+    EXPECT_EQ(ans[0].segment, 0);
+    EXPECT_NEAR(ans[0].point.GetY(), 0.0, eps);
+    EXPECT_NEAR(ans[0].distance, 1.0, eps);
+
+    /// End nodes are minima when the polyline moves away from the point
+    ans = FindNearestLocalMinima(poly, index, Point3D(0.0, 5.0, 0.0), 5);
+    ASSERT_EQ(ans.size(), 2);
+    EXPECT_EQ(ans[0].segment, 0);
+    EXPECT_EQ(ans[1].segment, 2);
+    EXPECT_NEAR(ans[0].distance, ans[1].distance, eps);
+}
+
+TEST(LocalMinimaTests, FirstMinimumIsNearestPoint) {
+    std::mt19937 gen(17);
+    std::vector<Point3D> nodes;
+    for (int i = 0; i < 600; ++i){
+        auto angle = 0.05 * i;
+        auto radius = 4.0 + 0.002 * i;
+        nodes.push_back(Point3D(radius * std::cos(angle), radius * std::sin(angle), 0.1 * std::sin(0.3 * i)));
+    }
+    Polyline3D poly(std::move(nodes));
+    SegmentIndex index(poly);
+
+    std::uniform_real_distribution<double> coord(-6.0, 6.0);
+    for (int i = 0; i < 100; ++i){
+        Point3D point(coord(gen), coord(gen), coord(gen));
+        auto expected = FindNearestPointsToPolyline(poly, point);
+        auto few = FindNearestLocalMinima(poly, index, point, 3);
+        auto all = FindNearestLocalMinima(poly, index, point, 1000);
+
+        ASSERT_FALSE(few.empty());
+        EXPECT_EQ(few[0].segment, expected[0].first);
+        EXPECT_TRUE(few[0].point == expected[0].second);
+        /// The spiral passes the point about once per turn
+        EXPECT_EQ(few.size(), 3);
+        for (size_t j = 0; j < few.size(); ++j){
+            EXPECT_EQ(few[j].segment, all[j].segment);
+            if (j > 0){
+                EXPECT_LE(few[j - 1].distance, few[j].distance);
+            }
+        }
+    }
+}
@@ -0,0 +1,81 @@
+#include "gtest/gtest.h"
+#include "TestPolylines.h"
+#include "static/MemoryBudget.h"
+#include "static/AdaptiveEngine.h"
+#include "static/ConcurrentPolyline.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/PolylineArcLength.h"
+#include "static/TimedPolyline.h"
+#include "static/GeometryObjects.h"
+#include <sstream>
+#include <vector>
+
+static void ExpectIndexMatches(const Polyline3D& poly, const BudgetedSegmentIndex& index, unsigned seed){
+    ExpectMatchesBruteForce(poly, RandomPoints(50, seed, 20.0), [&](const Point3D& point){
+        return index.FindNearestPoints(poly, point);
+    });
+}
+
+TEST(MemoryBudgetTests, StructuresReportTheirMemory) {
+    auto poly = RandomWalk(1000, 1);
+    EXPECT_GE(poly.GetMemoryUsage(), 1000 * sizeof(Point3D));
+    EXPECT_GE(ArcLengthTable(poly).GetMemoryUsage(), 1000 * sizeof(double));
+
+    std::vector<double> timestamps;
+    for (size_t i = 0; i < poly.GetNodesCount(); ++i) timestamps.push_back(static_cast<double>(i));
+    TimedPolyline3D track(poly, timestamps);
+    EXPECT_GE(track.GetMemoryUsage(), poly.GetMemoryUsage() + SegmentIndex(poly).GetMemoryUsage());
+
+    /// Retired versions count until they are reclaimed
+    ConcurrentPolyline3D shared(poly);
+    auto single = shared.GetMemoryUsage();
+    EXPECT_GE(single, poly.GetMemoryUsage());
+    {
+        auto snapshot = shared.Read();
+        shared.Publish(poly);
+        EXPECT_GE(shared.GetMemoryUsage(), single + poly.GetNodesCount() * sizeof(Point3D));
+    }
+    shared.Reclaim();
+    EXPECT_LT(shared.GetMemoryUsage(), single + poly.GetNodesCount() * sizeof(Point3D));
+
+    /// Engines count once they are built
+    AdaptiveNearestPoints adaptive(poly, EngineCalibration());
+    auto unprepared = adaptive.GetMemoryUsage();
+    adaptive.FindNearestPoints(std::vector<Point3D>(2000, Point3D(1.0, 2.0, 3.0)));
+    EXPECT_GE(adaptive.GetMemoryUsage(), unprepared);
+
+    std::ostringstream output;
+    WriteMemoryReport(output, {{"polyline", 2048}, {"segment_index", 512}});
+    EXPECT_NE(output.str().find("polyline       2048 bytes (2.0 KiB)"), std::string::npos);
+    EXPECT_NE(output.str().find("total          2560 bytes (2.5 KiB)"), std::string::npos);
+}
+
+TEST(MemoryBudgetTests, IndexFitsIntoBudget) {
+    auto poly = RandomWalk(20000, 2);
+
+    BudgetedSegmentIndex unlimited(poly, 1ull << 40);
+    EXPECT_GT(unlimited.GetReport().leafSize, 0);
+    EXPECT_GT(unlimited.GetReport().defaultMemoryUsage, 0);
+    ExpectIndexMatches(poly, unlimited, 3);
+
+    /// A tenth of the default index forces coarser leaves or compact nodes
+    auto budget = unlimited.GetReport().defaultMemoryUsage / 10;
+    BudgetedSegmentIndex tight(poly, budget);
+    const auto& report = tight.GetReport();
+    EXPECT_LE(report.memoryUsage, budget);
+    EXPECT_TRUE(report.leafSize > SegmentIndex::defaultLeafSize || (report.compact && report.leafSize > 0));
+    EXPECT_GT(report.querySlowdown, 0.0);
+    ExpectIndexMatches(poly, tight, 4);
+}
+
+TEST(MemoryBudgetTests, NoBudgetFallsBackToBruteForce) {
+    auto poly = RandomWalk(1000, 5);
+    BudgetedSegmentIndex index(poly, 0);
+
+    EXPECT_EQ(index.GetReport().leafSize, 0);
+    EXPECT_EQ(index.GetMemoryUsage(), 0);
+    EXPECT_GT(index.GetReport().querySlowdown, 1.0);
+    ExpectIndexMatches(poly, index, 6);
+    EXPECT_THROW(index.FindNearestPoints(RandomWalk(10, 7), Point3D()), std::invalid_argument);
+    EXPECT_TRUE(BudgetedSegmentIndex(Polyline3D(), 100).FindNearestPoints(Polyline3D(), Point3D()).empty());
+}
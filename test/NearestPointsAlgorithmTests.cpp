@@ -283,4 +283,38 @@ TEST(NearestPointsAlgorithmTests, Example11) {
     EXPECT_NEAR(ans[3].second.GetX(), 0.0, eps);
     EXPECT_NEAR(ans[3].second.GetY(), 1.0, eps);
     EXPECT_NEAR(ans[3].second.GetZ(), 0.5, eps);
-}
\ No newline at end of file
+}
+
+TEST(NearestPointOnSegmentTests, ProjectionInside) {
+    Segment3D seg(Point3D(0.0, 0.0, 0.0), Point3D(2.0, 0.0, 0.0));
+
+    auto [nearest, dist] = NearestPointOnSegment(Point3D(1.0, 1.0, 0.0), seg);
+
+    EXPECT_NEAR(nearest.GetX(), 1.0, eps);
+    EXPECT_NEAR(nearest.GetY(), 0.0, eps);
+    EXPECT_NEAR(dist, 1.0, eps);
+}
+
+TEST(NearestPointOnSegmentTests, ProjectionOutside) {
+    Segment3D seg(Point3D(0.0, 0.0, 0.0), Point3D(2.0, 0.0, 0.0));
+
+    auto [nearest, dist] = NearestPointOnSegment(Point3D(5.0, 4.0, 0.0), seg);
+
+    EXPECT_NEAR(nearest.GetX(), 2.0, eps);
+    EXPECT_NEAR(nearest.GetY(), 0.0, eps);
+    EXPECT_NEAR(dist, 5.0, eps);
+}
+
+TEST(SelectNearestCandidatesTests, CoincidingPointsKeepMinimumSegment) {
+    std::vector<SegmentCandidate> candidates;
+    candidates.push_back(SegmentCandidate{0, Point3D(1.0, 0.0, 0.0), 1.0});
+    candidates.push_back(SegmentCandidate{1, Point3D(1.0, 0.0, 0.0), 1.0});
+    candidates.push_back(SegmentCandidate{2, Point3D(0.0, 1.0, 0.0), 1.0});
+    candidates.push_back(SegmentCandidate{3, Point3D(5.0, 5.0, 0.0), 2.0});
+
+    auto ans = SelectNearestCandidates(candidates);
+
+    ASSERT_EQ(ans.size(), 2);
+    EXPECT_EQ(ans[0].first, 0);
+    EXPECT_EQ(ans[1].first, 2);
+}
@@ -0,0 +1,106 @@
+#include "gtest/gtest.h"
+#include "shared/NearestPointsC.h"
+#include "static/DistanceQueries.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/GeometryObjects.h"
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+
+TEST(NearestPointsCTests, InvalidArguments) {
+    double coords[] = {0.0, 0.0, 0.0, 1.0, 0.0, 0.0};
+    np_polyline* polyline = nullptr;
+
+    EXPECT_EQ(np_abi_version(), NP_ABI_VERSION);
+    EXPECT_EQ(np_polyline_create(coords, 2, 0, nullptr), NP_ERROR_INVALID_ARGUMENT);
+    EXPECT_EQ(np_polyline_create(nullptr, 2, 0, &polyline), NP_ERROR_INVALID_ARGUMENT);
+    EXPECT_EQ(np_polyline_create(coords, 2, 2 * sizeof(double), &polyline), NP_ERROR_INVALID_ARGUMENT);
+    EXPECT_EQ(np_polyline_create(coords, 2, 3 * sizeof(double) + 1, &polyline), NP_ERROR_INVALID_ARGUMENT);
+    ASSERT_EQ(np_polyline_create(coords, 2, 0, &polyline), NP_OK);
+
+    double distance;
+    uint8_t within;
+    EXPECT_EQ(np_distances(nullptr, coords, 1, 0, 1, &distance), NP_ERROR_INVALID_ARGUMENT);
+    EXPECT_EQ(np_distances(polyline, coords, 1, 0, 1, nullptr), NP_ERROR_INVALID_ARGUMENT);
+    EXPECT_EQ(np_within_distance(polyline, coords, 1, 0, -1.0, 1, &within), NP_ERROR_INVALID_ARGUMENT);
+    EXPECT_EQ(np_distances(polyline, nullptr, 0, 0, 1, nullptr), NP_OK);
+    EXPECT_STREQ(np_status_message(NP_ERROR_BUFFER_TOO_SMALL), "Output buffer too small");
+    np_polyline_destroy(polyline);
+    np_polyline_destroy(nullptr);
+}
+
+TEST(NearestPointsCTests, StridedPointsAndTies) {
+    /// Nodes interleaved with a fourth value that must be skipped
+    double records[] = {-1.0, 1.0, 0.0, 7.0,   0.0, 0.0, 0.0, 7.0,   1.0, 1.0, 0.0, 7.0};
+    np_polyline* polyline = nullptr;
+    ASSERT_EQ(np_polyline_create(records, 3, 4 * sizeof(double), &polyline), NP_OK);
+    size_t count = 0;
+    ASSERT_EQ(np_polyline_nodes_count(polyline, &count), NP_OK);
+    EXPECT_EQ(count, 3);
+
+    /// Equally near to both segments
+    double point[] = {0.0, 2.0, 0.0};
+    size_t segments[2];
+    double nearest[6];
+    size_t found = 0;
+    EXPECT_EQ(np_nearest_points_all(polyline, point, 1, segments, nearest, &found), NP_ERROR_BUFFER_TOO_SMALL);
+    EXPECT_EQ(found, 2);
+    ASSERT_EQ(np_nearest_points_all(polyline, point, 2, segments, nearest, &found), NP_OK);
+    EXPECT_EQ(segments[0], 0);
+    EXPECT_EQ(segments[1], 1);
+    EXPECT_NEAR(nearest[0], -1.0, eps);
+    EXPECT_NEAR(nearest[3], 1.0, eps);
+
+    size_t segment;
+    double distance;
+    ASSERT_EQ(np_nearest_points(polyline, point, 1, 0, 1, &segment, nullptr, &distance), NP_OK);
+    EXPECT_EQ(segment, 0);
+    EXPECT_NEAR(distance, std::sqrt(2.0), eps);
+    np_polyline_destroy(polyline);
+
+    /// A polyline without segments
+    ASSERT_EQ(np_polyline_create(records, 1, 0, &polyline), NP_OK);
+    ASSERT_EQ(np_nearest_points(polyline, point, 1, 0, 1, &segment, nearest, &distance), NP_OK);
+    EXPECT_EQ(segment, std::numeric_limits<size_t>::max());
+    EXPECT_TRUE(std::isnan(nearest[0]));
+    EXPECT_TRUE(std::isinf(distance));
+    np_polyline_destroy(polyline);
+}
+
+TEST(NearestPointsCTests, BatchMatchesLibrary) {
+    std::mt19937 gen(29);
+    std::uniform_real_distribution<double> coord(-10.0, 10.0);
+    std::vector<double> coords;
+    std::vector<Point3D> nodes;
+    for (int i = 0; i < 500; ++i){
+        nodes.push_back(Point3D(coord(gen), coord(gen), coord(gen)));
+        coords.insert(coords.end(), {nodes.back().GetX(), nodes.back().GetY(), nodes.back().GetZ()});
+    }
+    Polyline3D poly(nodes);
+    np_polyline* polyline = nullptr;
+    ASSERT_EQ(np_polyline_create(coords.data(), nodes.size(), 0, &polyline), NP_OK);
+
+    const size_t count = 300;
+    std::vector<double> points;
+    for (size_t i = 0; i < 3 * count; ++i) points.push_back(coord(gen));
+    std::vector<size_t> segments(count);
+    std::vector<double> nearest(3 * count), distances(count), onlyDistances(count);
+    std::vector<uint8_t> within(count);
+    ASSERT_EQ(np_nearest_points(polyline, points.data(), count, 0, 4, segments.data(), nearest.data(),
+                                distances.data()), NP_OK);
+    ASSERT_EQ(np_distances(polyline, points.data(), count, 0, 4, onlyDistances.data()), NP_OK);
+    ASSERT_EQ(np_within_distance(polyline, points.data(), count, 0, 1.0, 4, within.data()), NP_OK);
+
+    for (size_t i = 0; i < count; ++i){
+        Point3D point(points[3 * i], points[3 * i + 1], points[3 * i + 2]);
+        auto expected = FindNearestPointsToPolyline(poly, point);
+        EXPECT_EQ(segments[i], expected[0].first);
+        EXPECT_TRUE(Point3D(nearest[3 * i], nearest[3 * i + 1], nearest[3 * i + 2]) == expected[0].second);
+        EXPECT_NEAR(onlyDistances[i], distances[i], eps);
+        EXPECT_EQ(within[i] != 0, IsWithinDistance(poly, point, 1.0));
+    }
+    np_polyline_destroy(polyline);
+}
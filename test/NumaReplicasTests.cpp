@@ -0,0 +1,55 @@
+#include "gtest/gtest.h"
+#include "TestPolylines.h"
+#include "static/NumaReplicas.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/GeometryObjects.h"
+#include <stdexcept>
+#include <vector>
+
+static void ExpectReplicasMatch(const Polyline3D& poly, const ReplicatedPolyline3D& replicas, size_t threadsPerNode){
+    auto points = RandomPoints(300, 7, 15.0);
+    auto ans = replicas.FindNearestPoints(points, threadsPerNode);
+    ASSERT_EQ(ans.size(), points.size());
+    for (size_t i = 0; i < points.size(); ++i) ExpectSameResults(ans[i], FindNearestPointsToPolyline(poly, points[i]));
+}
+
+TEST(NumaReplicasTests, DetectedTopology) {
+    auto topology = NumaTopology::Detect();
+    ASSERT_FALSE(topology.nodes.empty());
+    for (const auto& node : topology.nodes) EXPECT_FALSE(node.cpus.empty());
+    EXPECT_EQ(topology.GetFirstNodes(1).nodes.size(), 1);
+    EXPECT_EQ(topology.GetFirstNodes(1000).nodes.size(), topology.nodes.size());
+}
+
+TEST(NumaReplicasTests, SingleNodeKeepsOneCopy) {
+    auto poly = RandomWalk(2000, 1);
+    ReplicatedPolyline3D replicas(poly, NumaTopology::Simulate(1));
+
+    EXPECT_EQ(replicas.GetReplicasCount(), 1);
+    ExpectReplicasMatch(poly, replicas, 2);
+    EXPECT_THROW(NumaTopology::Simulate(0), std::invalid_argument);
+    EXPECT_THROW(ReplicatedPolyline3D(poly, NumaTopology::Simulate(1), true, 0), std::invalid_argument);
+}
+
+TEST(NumaReplicasTests, SimulatedNodesGetTheirOwnReplica) {
+    auto poly = RandomWalk(2000, 3);
+    auto topology = NumaTopology::Simulate(4);
+    ASSERT_EQ(topology.nodes.size(), 4);
+    for (const auto& node : topology.nodes) EXPECT_FALSE(node.cpus.empty());
+
+    ReplicatedPolyline3D replicas(poly, topology);
+    ASSERT_EQ(replicas.GetReplicasCount(), 4);
+    for (size_t n = 1; n < 4; ++n){
+        EXPECT_NE(&replicas.GetPolyline(n).GetNodes()[0], &replicas.GetPolyline(0).GetNodes()[0]);
+        EXPECT_EQ(replicas.GetPolyline(n).GetNodes(), poly.GetNodes());
+    }
+    ExpectReplicasMatch(poly, replicas, 2);
+    ExpectReplicasMatch(poly, replicas, 0);
+
+    /// The baseline shares the copy of the first node
+    ReplicatedPolyline3D shared(poly, topology, false);
+    EXPECT_EQ(shared.GetReplicasCount(), 1);
+    EXPECT_EQ(&shared.GetPolyline(3).GetNodes()[0], &shared.GetPolyline(0).GetNodes()[0]);
+    EXPECT_LT(shared.GetMemoryUsage(), replicas.GetMemoryUsage());
+    ExpectReplicasMatch(poly, shared, 1);
+}
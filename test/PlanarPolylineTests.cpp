@@ -0,0 +1,86 @@
+#include "gtest/gtest.h"
+#include "TestPolylines.h"
+#include "static/PlanarPolyline.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/3DMathOperations.h"
+#include "static/GeometryObjects.h"
+#include <cmath>
+#include <random>
+
+
+/// The planar kernel works in plane coordinates, so its points may differ from the brute force by rounding.
+static void ExpectPlanarMatches(const PlanarPolyline3D& planar, const Polyline3D& poly, const std::vector<Point3D>& points){
+    ExpectMatchesBruteForce(poly, points, [&](const Point3D& point){ return planar.FindNearestPoints(point); }, eps);
+}
+
+TEST(PlanarPolylineTests, TooFewNodes) {
+    PlanarPolyline3D planar(Polyline3D({{1.0, 1.0, 1.0}}));
+
+    EXPECT_FALSE(planar.IsPlanar());
+    EXPECT_TRUE(planar.FindNearestPoints(Point3D(0.0, 0.0, 0.0)).empty());
+}
+
+TEST(PlanarPolylineTests, AxisAlignedPlane) {
+    Polyline3D poly({{0.0, 0.0, 2.0}, {2.0, 0.0, 2.0}, {2.0, 2.0, 2.0}, {0.0, 2.0, 2.0}, {0.0, 0.0, 2.0}});
+    PlanarPolyline3D planar(poly);
+
+    ASSERT_TRUE(planar.IsPlanar());
+    EXPECT_NEAR(planar.GetNormal().GetZ(), 1.0, eps);
+
+    /// The center of the square is equally close to all four sides
+    auto ans = planar.FindNearestPoints(Point3D(1.0, 1.0, 5.0));
+    ASSERT_EQ(ans.size(), 4);
+    EXPECT_EQ(ans[0].first, 0);
+    EXPECT_DOUBLE_EQ(ans[0].second.GetX(), 1.0);
+    EXPECT_DOUBLE_EQ(ans[0].second.GetY(), 0.0);
+    EXPECT_DOUBLE_EQ(ans[0].second.GetZ(), 2.0);
+
+    ExpectPlanarMatches(planar, poly, {Point3D(1.0, 1.0, 5.0), Point3D(3.0, 3.0, -1.0), Point3D(0.0, 0.0, 2.0)});
+}
+
+TEST(PlanarPolylineTests, TiltedPlaneMatchesBruteForce) {
+    Vector3D axisU = NormalizedVector(Vector3D(1.0, 2.0, -0.5));
+    Vector3D axisV = NormalizedVector(VectorProduct(axisU, Vector3D(0.3, -1.0, 2.0)));
+    std::mt19937 gen(5);
+    std::uniform_real_distribution<double> step(-1.0, 1.0);
+
+    std::vector<Point3D> nodes;
+    auto u = 0.0;
+    auto v = 0.0;
+    for (int i = 0; i < 300; ++i){
+        nodes.push_back(Point3D(3.0 + u * axisU.GetX() + v * axisV.GetX(),
+                                -1.0 + u * axisU.GetY() + v * axisV.GetY(),
+                                0.5 + u * axisU.GetZ() + v * axisV.GetZ()));
+        u += step(gen);
+        v += step(gen);
+        if (i % 50 == 0) nodes.push_back(nodes.back());
+    }
+    Polyline3D poly(std::move(nodes));
+    PlanarPolyline3D planar(poly);
+    ASSERT_TRUE(planar.IsPlanar());
+
+    ExpectPlanarMatches(planar, poly, RandomPoints(200, 6, 15.0));
+}
+
+TEST(PlanarPolylineTests, CollinearNodes) {
+    Polyline3D poly({{0.0, 0.0, 0.0}, {1.0, 1.0, 1.0}, {3.0, 3.0, 3.0}, {2.0, 2.0, 2.0}});
+    PlanarPolyline3D planar(poly);
+
+    ASSERT_TRUE(planar.IsPlanar());
+    ExpectPlanarMatches(planar, poly, {Point3D(2.0, 2.0, 2.0), Point3D(5.0, 0.0, 1.0), Point3D(-1.0, -2.0, 0.0)});
+}
+
+TEST(PlanarPolylineTests, NonPlanarFallsBack) {
+    Polyline3D poly({{0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}, {1.0, 1.0, 0.0}, {1.0, 1.0, 1.0}});
+    PlanarPolyline3D planar(poly);
+
+    EXPECT_FALSE(planar.IsPlanar());
+    ExpectPlanarMatches(planar, poly, {Point3D(0.5, 0.5, 0.5), Point3D(2.0, 2.0, 2.0)});
+}
+
+TEST(PlanarPolylineTests, DegenerateSegmentsOnly) {
+    PlanarPolyline3D planar(Polyline3D({{1.0, 2.0, 3.0}, {1.0, 2.0, 3.0}}));
+
+    EXPECT_TRUE(planar.IsPlanar());
+    EXPECT_TRUE(planar.FindNearestPoints(Point3D(0.0, 0.0, 0.0)).empty());
+}
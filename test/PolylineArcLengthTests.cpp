@@ -0,0 +1,124 @@
+#include "gtest/gtest.h"
+#include "static/PolylineArcLength.h"
+#include "static/GeometryObjects.h"
+#include <stdexcept>
+#include <cmath>
+
+
+TEST(ArcLengthTableTests, EmptyPolyline) {
+    Polyline3D poly;
+    ArcLengthTable table(poly);
+
+    EXPECT_EQ(table.GetNodesCount(), 0);
+    EXPECT_NEAR(table.GetTotalLength(), 0.0, eps);
+}
+
+TEST(ArcLengthTableTests, CumulativeLengths) {
+    Polyline3D poly({{0.0, 0.0, 0.0}, {3.0, 4.0, 0.0}, {3.0, 4.0, 2.0}, {3.0, 4.0, 2.0}});
+    ArcLengthTable table(poly);
+
+    EXPECT_EQ(table.GetNodesCount(), 4);
+    EXPECT_NEAR(table.GetCumulativeLength(0), 0.0, eps);
+    EXPECT_NEAR(table.GetCumulativeLength(1), 5.0, eps);
+    EXPECT_NEAR(table.GetCumulativeLength(2), 7.0, eps);
+    EXPECT_NEAR(table.GetCumulativeLength(3), 7.0, eps);
+    EXPECT_NEAR(table.GetTotalLength(), 7.0, eps);
+}
+
+TEST(ArcLengthTableTests, FindSegmentAtDistance) {
+    Polyline3D poly({{0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}, {3.0, 0.0, 0.0}});
+    ArcLengthTable table(poly);
+
+    EXPECT_EQ(table.FindSegmentAtDistance(-1.0), 1);
+    EXPECT_EQ(table.FindSegmentAtDistance(0.0), 1);
+    EXPECT_EQ(table.FindSegmentAtDistance(0.5), 1);
+    EXPECT_EQ(table.FindSegmentAtDistance(1.0), 2);
+    EXPECT_EQ(table.FindSegmentAtDistance(3.0), 2);
+    EXPECT_EQ(table.FindSegmentAtDistance(10.0), 2);
+}
+
+TEST(FindNearestRoutePositionsTests, Example1) {
+    Polyline3D poly({{0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}, {2.0, 1.0, 0.0}, {3.0, 1.0, 1.0}});
+    ArcLengthTable table(poly);
+
+    auto ans = FindNearestRoutePositions(poly, table, Point3D {2.0, 0.5, 0.5});
+
+    ASSERT_EQ(ans.size(), 2);
+    EXPECT_EQ(ans[0].segment, 1);
+    EXPECT_NEAR(ans[0].point.GetX(), 1.75, eps);
+    EXPECT_NEAR(ans[0].parameter, 0.75, eps);
+    EXPECT_NEAR(ans[0].distanceAlong, 1.0 + 0.75 * std::sqrt(2.0), eps);
+
+    EXPECT_EQ(ans[1].segment, 2);
+    EXPECT_NEAR(ans[1].point.GetX(), 2.25, eps);
+    EXPECT_NEAR(ans[1].parameter, 0.25, eps);
+    EXPECT_NEAR(ans[1].distanceAlong, 1.0 + std::sqrt(2.0) + 0.25 * std::sqrt(2.0), eps);
+}
+
+TEST(FindNearestRoutePositionsTests, NearestVertex) {
+    Polyline3D poly({{0.0, 0.0, 0.0}, {2.0, 0.0, 0.0}, {2.0, 2.0, 0.0}});
+    ArcLengthTable table(poly);
+
+    auto ans = FindNearestRoutePositions(poly, table, Point3D {3.0, -1.0, 0.0});
+
+    ASSERT_EQ(ans.size(), 1);
+    EXPECT_EQ(ans[0].segment, 0);
+    EXPECT_NEAR(ans[0].parameter, 1.0, eps);
+    EXPECT_NEAR(ans[0].distanceAlong, 2.0, eps);
+}
+
+TEST(FindNearestRoutePositionsTests, StaleTable) {
+    Polyline3D poly({{0.0, 0.0, 0.0}, {2.0, 0.0, 0.0}});
+    ArcLengthTable table(poly);
+
+    /// The segment added after the table was built is nearest, but has no cumulative length
+    poly.AddPoint(Point3D {2.0, 2.0, 0.0});
+    EXPECT_THROW(FindNearestRoutePositions(poly, table, Point3D {3.0, 2.0, 0.0}), std::invalid_argument);
+}
+
+TEST(PointAtDistanceTests, InsideSegments) {
+    Polyline3D poly({{0.0, 0.0, 0.0}, {2.0, 0.0, 0.0}, {2.0, 2.0, 0.0}});
+    ArcLengthTable table(poly);
+
+    auto pos = PointAtDistance(poly, table, 3.0);
+    EXPECT_EQ(pos.segment, 1);
+    EXPECT_NEAR(pos.parameter, 0.5, eps);
+    EXPECT_NEAR(pos.point.GetX(), 2.0, eps);
+    EXPECT_NEAR(pos.point.GetY(), 1.0, eps);
+    EXPECT_NEAR(pos.distanceAlong, 3.0, eps);
+}
+
+TEST(PointAtDistanceTests, ClampedToEnds) {
+    Polyline3D poly({{0.0, 0.0, 0.0}, {2.0, 0.0, 0.0}, {2.0, 2.0, 0.0}});
+    ArcLengthTable table(poly);
+
+    auto first = PointAtDistance(poly, table, -5.0);
+    EXPECT_EQ(first.segment, 0);
+    EXPECT_NEAR(first.point.GetX(), 0.0, eps);
+    EXPECT_NEAR(first.distanceAlong, 0.0, eps);
+
+    auto last = PointAtDistance(poly, table, 100.0);
+    EXPECT_EQ(last.segment, 1);
+    EXPECT_NEAR(last.parameter, 1.0, eps);
+    EXPECT_NEAR(last.point.GetY(), 2.0, eps);
+    EXPECT_NEAR(last.distanceAlong, 4.0, eps);
+}
+
+TEST(PointAtDistanceTests, RoundTrip) {
+    Polyline3D poly({{0.0, 0.0, 0.0}, {1.0, 2.0, 3.0}, {4.0, 0.0, 1.0}, {5.0, 5.0, 5.0}});
+    ArcLengthTable table(poly);
+
+    for (auto s = 0.0; s <= table.GetTotalLength(); s += 0.37){
+        auto pos = PointAtDistance(poly, table, s);
+        auto ans = FindNearestRoutePositions(poly, table, pos.point);
+        ASSERT_FALSE(ans.empty());
+        EXPECT_NEAR(ans[0].distanceAlong, s, 1e-6);
+    }
+}
+
+TEST(PointAtDistanceTests, TooFewNodes) {
+    Polyline3D poly({{1.0, 1.0, 1.0}});
+    ArcLengthTable table(poly);
+
+    EXPECT_THROW(PointAtDistance(poly, table, 0.0), std::invalid_argument);
+}
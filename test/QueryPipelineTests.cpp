@@ -0,0 +1,118 @@
+#include "gtest/gtest.h"
+#include "static/QueryPipeline.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/GeometryObjects.h"
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+
+static Polyline3D SquarePolyline(){
+    return Polyline3D({{0.0, 0.0, 0.0}, {2.0, 0.0, 0.0}, {2.0, 2.0, 0.0}, {0.0, 2.0, 0.0}, {0.0, 0.0, 0.0}});
+}
+
+TEST(ParseQueryPointsTests, ValidLines) {
+    std::vector<Point3D> points;
+    ParseQueryPoints("1 2 3\n\n  -4.5\t5e1  6 \r\n7 8 9", 1, points);
+
+    ASSERT_EQ(points.size(), 3);
+    EXPECT_NEAR(points[1].GetX(), -4.5, eps);
+    EXPECT_NEAR(points[1].GetY(), 50.0, eps);
+    EXPECT_NEAR(points[2].GetZ(), 9.0, eps);
+}
+
+TEST(ParseQueryPointsTests, InvalidLines) {
+    std::vector<Point3D> points;
+    EXPECT_THROW(ParseQueryPoints("1 2\n", 1, points), std::invalid_argument);
+    EXPECT_THROW(ParseQueryPoints("1 2 3 4\n", 1, points), std::invalid_argument);
+    EXPECT_THROW(ParseQueryPoints("1 a 3\n", 1, points), std::invalid_argument);
+    EXPECT_THROW(ParseQueryPoints("1 2x 3\n", 1, points), std::invalid_argument);
+    EXPECT_THROW(ParseQueryPoints("1 1e999 3\n", 1, points), std::out_of_range);
+}
+
+TEST(FormatQueryResultsTests, Text) {
+    std::vector<std::vector<std::pair<size_t, Point3D>>> results{
+        {{0, Point3D(1.0, 0.0, 0.0)}, {3, Point3D(0.0, 1.5, 0.0)}},
+        {}
+    };
+    std::string buffer;
+    FormatQueryResults(results, 10, BatchOutputFormat::Text, buffer);
+
+    EXPECT_EQ(buffer, "11 2 1 1 0 0 4 0 1.5 0\n12 0\n");
+}
+
+TEST(FormatQueryResultsTests, Binary) {
+    std::vector<std::vector<std::pair<size_t, Point3D>>> results{{{4, Point3D(1.0, 2.0, 3.0)}}};
+    std::string buffer;
+    FormatQueryResults(results, 0, BatchOutputFormat::Binary, buffer);
+
+    ASSERT_EQ(buffer.size(), 8 + 4 + 8 + 3 * 8);
+    uint64_t query = 0;
+    uint32_t count = 0;
+    uint64_t segment = 0;
+    double y = 0.0;
+    std::memcpy(&query, buffer.data(), 8);
+    std::memcpy(&count, buffer.data() + 8, 4);
+    std::memcpy(&segment, buffer.data() + 12, 8);
+    std::memcpy(&y, buffer.data() + 28, 8);
+    EXPECT_EQ(query, 1);
+    EXPECT_EQ(count, 1);
+    EXPECT_EQ(segment, 5);
+    EXPECT_NEAR(y, 2.0, eps);
+
+    /// Numbers are little-endian on every host
+    EXPECT_EQ(buffer[0], 1);
+    EXPECT_EQ(buffer[7], 0);
+    EXPECT_EQ(buffer[8], 1);
+    EXPECT_EQ(buffer[12], 5);
+}
+
+TEST(RunQueryPipelineTests, TextOutputMatchesSingleQueries) {
+    auto poly = SquarePolyline();
+    std::ostringstream queriesText;
+    queriesText.precision(17);
+    std::vector<Point3D> points;
+    for (int i = 0; i < 10000; ++i){
+        Point3D point((i % 7) * 0.5 - 1.0, (i % 11) * 0.3 - 1.0, (i % 3) - 1.0);
+        points.push_back(point);
+        queriesText << point.GetX() << ' ' << point.GetY() << ' ' << point.GetZ() << '\n';
+    }
+
+    std::istringstream input(queriesText.str());
+    std::ostringstream output;
+    EXPECT_EQ(RunQueryPipeline(poly, input, output, BatchOutputFormat::Text), points.size());
+
+    std::string expected;
+    for (size_t i = 0; i < points.size(); ++i){
+        FormatQueryResults({FindNearestPointsToPolyline(poly, points[i])}, i, BatchOutputFormat::Text, expected);
+    }
+    EXPECT_EQ(output.str(), expected);
+}
+
+TEST(RunQueryPipelineTests, BinaryOutputHasMagic) {
+    std::istringstream input("1 1 1\n");
+    std::ostringstream output;
+    EXPECT_EQ(RunQueryPipeline(SquarePolyline(), input, output, BatchOutputFormat::Binary), 1);
+
+    auto text = output.str();
+    ASSERT_EQ(text.size(), 4 + 12 + 4 * 32);
+    EXPECT_EQ(text.compare(0, 4, std::string(binaryResultsMagic, 4)), 0);
+}
+
+TEST(RunQueryPipelineTests, MalformedInputThrows) {
+    std::istringstream input("1 1 1\n2 2\n");
+    std::ostringstream output;
+    EXPECT_THROW(RunQueryPipeline(SquarePolyline(), input, output, BatchOutputFormat::Text), std::invalid_argument);
+}
+
+TEST(RunQueryPipelineTests, FailingOutputThrows) {
+    std::ostringstream queriesText;
+    for (int i = 0; i < 20000; ++i) queriesText << i % 5 << " 1 0\n";
+    std::istringstream input(queriesText.str());
+
+    /// A file stream that has not been opened fails on the first write
+    std::ofstream output;
+    output.exceptions(std::ios::badbit);
+    EXPECT_THROW(RunQueryPipeline(SquarePolyline(), input, output, BatchOutputFormat::Text), std::ios::failure);
+}
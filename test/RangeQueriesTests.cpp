@@ -0,0 +1,89 @@
+#include "gtest/gtest.h"
+#include "TestPolylines.h"
+#include "static/RangeQueries.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/SegmentIndex.h"
+#include "static/GeometryObjects.h"
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+
+/// The polyline of segments [first, last) of poly.
+static Polyline3D Window(const Polyline3D& poly, size_t first, size_t last){
+    const auto& nodes = poly.GetNodes();
+    return Polyline3D(std::vector<Point3D>(nodes.begin() + first, nodes.begin() + last + 1));
+}
+
+TEST(RangeQueriesTests, InvalidAndEmptyRanges) {
+    Polyline3D poly({{0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}, {2.0, 0.0, 0.0}});
+    SegmentIndex index(poly);
+    Point3D point(0.5, 1.0, 0.0);
+
+    EXPECT_THROW(FindNearestPointsInRange(poly, index, point, 1, 3), std::invalid_argument);
+    EXPECT_THROW(FindNearestPointsInRange(poly, index, point, 2, 1), std::invalid_argument);
+    EXPECT_THROW(FindSegmentsWithinRadius(poly, index, point, -1.0, 0, 2), std::invalid_argument);
+    EXPECT_THROW(DistanceToPolylineRange(poly, SegmentIndex(), point, 0, 0), std::invalid_argument);
+    EXPECT_TRUE(FindNearestPointsInRange(poly, index, point, 1, 1).empty());
+    EXPECT_TRUE(std::isinf(DistanceToPolylineRange(poly, index, point, 2, 2)));
+}
+
+TEST(RangeQueriesTests, WindowOfRepeatedTrack) {
+    /// The same loop driven three times; only the window decides which pass matches
+    const auto pi = std::acos(-1.0);
+    std::vector<Point3D> nodes;
+    for (int lap = 0; lap < 3; ++lap){
+        for (int i = 0; i < 64; ++i){
+            auto angle = 2.0 * pi * i / 64.0;
+            nodes.push_back(Point3D(10.0 * std::cos(angle), 10.0 * std::sin(angle), 0.0));
+        }
+    }
+    Polyline3D poly(std::move(nodes));
+    SegmentIndex index(poly, 2);
+    Point3D point(10.5, 0.1, 0.0);
+
+    auto ans = FindNearestPointsInRange(poly, index, point, 100, 180);
+    ASSERT_EQ(ans.size(), 1);
+    EXPECT_EQ(ans[0].first, 128);
+    auto within = FindSegmentsWithinRadius(poly, index, point, 1.0, 100, 180);
+    ASSERT_EQ(within.size(), 2);
+    EXPECT_EQ(within[0].segment, 127);
+    EXPECT_EQ(within[1].segment, 128);
+}
+
+TEST(RangeQueriesTests, MatchesQueriesOnWindow) {
+    auto poly = RandomWalk(2000, 41, RandomWalkOptions{Point3D(), 1.0, 50});
+    SegmentIndex index(poly);
+    auto segments = poly.GetNodesCount() - 1;
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<size_t> start(0, segments - 1);
+    for (const auto& point : RandomPoints(100, 43, 20.0)){
+        auto first = start(gen);
+        auto last = std::min(segments, first + 1 + start(gen) % 300);
+
+        /// Segments of the window are numbered from the start of the range
+        auto expected = FindNearestPointsToPolyline(Window(poly, first, last), point);
+        for (auto& pair : expected) pair.first += first;
+        ExpectSameResults(FindNearestPointsInRange(poly, index, point, first, last), expected);
+        if (expected.empty()) continue;
+
+        auto distance = DistanceBetweenPoints(point, expected[0].second);
+        EXPECT_NEAR(DistanceToPolylineRange(poly, index, point, first, last), distance, eps);
+        auto radius = 1.5 * distance;
+        size_t count = 0;
+        for (auto k = first; k < last; ++k){
+            const auto& start = poly.GetNodes()[k];
+            const auto& end = poly.GetNodes()[k + 1];
+            if (!(start == end) && NearestPointOnSegment(point, Segment3D{start, end}).second <= radius) ++count;
+        }
+        auto within = FindSegmentsWithinRadius(poly, index, point, radius, first, last);
+        EXPECT_EQ(within.size(), count);
+        for (const auto& candidate : within){
+            EXPECT_GE(candidate.segment, first);
+            EXPECT_LT(candidate.segment, last);
+            EXPECT_LE(candidate.distance, radius);
+        }
+    }
+}
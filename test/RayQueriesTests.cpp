@@ -0,0 +1,97 @@
+#include "gtest/gtest.h"
+#include "TestPolylines.h"
+#include "static/RayQueries.h"
+#include "static/SegmentIndex.h"
+#include "static/GeometryObjects.h"
+#include <cmath>
+#include <stdexcept>
+
+
+TEST(LineSegmentClosestPointsTests, SkewLines) {
+    auto ans = ClosestPointsOfLineAndSegment(Point3D(0.0, 0.0, 1.0), Vector3D(1.0, 0.0, 0.0),
+                                             Segment3D(Point3D(2.0, -1.0, 0.0), Point3D(2.0, 1.0, 0.0)));
+    EXPECT_NEAR(ans.lineParameter, 2.0, eps);
+    EXPECT_NEAR(ans.segmentParameter, 0.5, eps);
+    EXPECT_NEAR(ans.distance, 1.0, eps);
+    EXPECT_NEAR(ans.segmentPoint.GetX(), 2.0, eps);
+    EXPECT_NEAR(ans.segmentPoint.GetY(), 0.0, eps);
+    EXPECT_NEAR(ans.linePoint.GetZ(), 1.0, eps);
+}
+
+TEST(LineSegmentClosestPointsTests, LineBehindOrigin) {
+    Segment3D seg(Point3D(-3.0, -1.0, 0.0), Point3D(-3.0, 1.0, 0.0));
+
+    auto line = ClosestPointsOfLineAndSegment(Point3D(0.0, 0.0, 0.0), Vector3D(2.0, 0.0, 0.0), seg);
+    EXPECT_NEAR(line.lineParameter, -1.5, eps);
+    EXPECT_NEAR(line.distance, 0.0, eps);
+
+    auto ray = ClosestPointsOfRayAndSegment(Ray3D{Point3D(0.0, 0.0, 0.0), Vector3D(2.0, 0.0, 0.0)}, seg);
+    EXPECT_NEAR(ray.lineParameter, 0.0, eps);
+    EXPECT_NEAR(ray.distance, 3.0, eps);
+}
+
+TEST(LineSegmentClosestPointsTests, ParallelAndClampedToEnd) {
+    auto parallel = ClosestPointsOfLineAndSegment(Point3D(0.0, 1.0, 0.0), Vector3D(1.0, 0.0, 0.0),
+                                                  Segment3D(Point3D(1.0, 0.0, 0.0), Point3D(3.0, 0.0, 0.0)));
+    EXPECT_NEAR(parallel.distance, 1.0, eps);
+    EXPECT_NEAR(parallel.linePoint.GetX(), parallel.segmentPoint.GetX(), eps);
+
+    auto clamped = ClosestPointsOfLineAndSegment(Point3D(0.0, 0.0, 0.0), Vector3D(0.0, 0.0, 1.0),
+                                                 Segment3D(Point3D(1.0, 0.0, 5.0), Point3D(4.0, 0.0, 5.0)));
+    EXPECT_NEAR(clamped.segmentParameter, 0.0, eps);
+    EXPECT_NEAR(clamped.lineParameter, 5.0, eps);
+    EXPECT_NEAR(clamped.distance, 1.0, eps);
+
+    EXPECT_THROW(ClosestPointsOfLineAndSegment(Point3D(), Vector3D(), Segment3D(Point3D(), Point3D(1.0, 0.0, 0.0))),
+                 std::invalid_argument);
+}
+
+TEST(RayQueriesTests, MatchesExhaustiveSearch) {
+    auto poly = RandomWalk(400, 3);
+    const auto& nodes = poly.GetNodes();
+    SegmentIndex index(poly, 4);
+
+    /// Rays start at random points and head along the vectors to other random points
+    auto origins = RandomPoints(100, 4, 20.0);
+    auto directions = RandomPoints(100, 5, 1.0);
+    std::vector<Ray3D> rays;
+    for (size_t i = 0; i < origins.size(); ++i){
+        rays.push_back(Ray3D{origins[i], Vector3D(Point3D(), directions[i])});
+    }
+
+    auto batch = FindNearestPointsToRays(poly, index, rays, std::numeric_limits<double>::infinity(), 3);
+    ASSERT_EQ(batch.size(), rays.size());
+    for (size_t r = 0; r < rays.size(); ++r){
+        auto best = std::numeric_limits<double>::infinity();
+        for (size_t i = 0; i + 1 < nodes.size(); ++i){
+            best = std::min(best, ClosestPointsOfRayAndSegment(rays[r], Segment3D(nodes[i], nodes[i + 1])).distance);
+        }
+
+        auto hit = FindNearestPointToRay(poly, index, rays[r]);
+        ASSERT_TRUE(hit.has_value());
+        EXPECT_NEAR(hit->distance, best, eps);
+        auto check = ClosestPointsOfRayAndSegment(rays[r], Segment3D(nodes[hit->segment], nodes[hit->segment + 1]));
+        EXPECT_NEAR(check.lineParameter, hit->rayParameter, 1e-6);
+
+        ASSERT_TRUE(batch[r].has_value());
+        EXPECT_EQ(batch[r]->segment, hit->segment);
+        EXPECT_EQ(batch[r]->rayParameter, hit->rayParameter);
+    }
+}
+
+TEST(RayQueriesTests, PicksNearestAlongRay) {
+    /// Two parallel passes crossed by the ray at the same distance, the first one along the ray wins
+    Polyline3D poly({{-1.0, 0.0, 5.0}, {1.0, 0.0, 5.0}, {1.0, 0.0, 2.0}, {-1.0, 0.0, 2.0}});
+    SegmentIndex index(poly, 1);
+
+    auto hit = FindNearestPointToRay(poly, index, Ray3D{Point3D(0.0, 0.5, 0.0), Vector3D(0.0, 0.0, 1.0)});
+    ASSERT_TRUE(hit.has_value());
+    EXPECT_EQ(hit->segment, 2);
+    EXPECT_NEAR(hit->rayParameter, 2.0, eps);
+    EXPECT_NEAR(hit->distance, 0.5, eps);
+    EXPECT_NEAR(hit->point.GetX(), 0.0, eps);
+
+    EXPECT_FALSE(FindNearestPointToRay(poly, index, Ray3D{Point3D(0.0, 0.5, 0.0), Vector3D(0.0, 0.0, 1.0)}, 0.25));
+    EXPECT_THROW(FindNearestPointToRay(poly, index, Ray3D{Point3D(), Vector3D()}), std::invalid_argument);
+    EXPECT_FALSE(FindNearestPointToRay(Polyline3D(), SegmentIndex(), Ray3D{Point3D(), Vector3D(1.0, 0.0, 0.0)}));
+}
@@ -0,0 +1,139 @@
+#include "gtest/gtest.h"
+#include "static/ResultCache.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/GeometryObjects.h"
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+
+static Polyline3D SquarePolyline(){
+    return Polyline3D({{0.0, 0.0, 0.0}, {2.0, 0.0, 0.0}, {2.0, 2.0, 0.0}, {0.0, 2.0, 0.0}, {0.0, 0.0, 0.0}});
+}
+
+TEST(PolylineRevisionTests, ChangesOnModification) {
+    Polyline3D poly({{0.0, 0.0, 0.0}});
+    auto revision = poly.GetRevision();
+
+    poly.AddPoint(Point3D(1.0, 0.0, 0.0));
+    EXPECT_NE(poly.GetRevision(), revision);
+
+    revision = poly.GetRevision();
+    poly.SetNodes({{0.0, 0.0, 0.0}});
+    EXPECT_NE(poly.GetRevision(), revision);
+
+    Polyline3D copy(poly);
+    EXPECT_EQ(copy.GetRevision(), poly.GetRevision());
+
+    Polyline3D moved(std::move(copy));
+    EXPECT_EQ(moved.GetRevision(), poly.GetRevision());
+    EXPECT_NE(copy.GetRevision(), poly.GetRevision());
+    EXPECT_NE(Polyline3D().GetRevision(), Polyline3D().GetRevision());
+}
+
+TEST(NearestPointsCacheTests, ExactRepeats) {
+    auto poly = SquarePolyline();
+    NearestPointsCache cache;
+
+    auto first = cache.FindNearestPoints(poly, Point3D(1.0, 1.0, 1.0));
+    auto second = cache.FindNearestPoints(poly, Point3D(1.0, 1.0, 1.0));
+    cache.FindNearestPoints(poly, Point3D(1.0, 1.0, 1.0 + 1e-12));
+
+    EXPECT_EQ(first.size(), 4);
+    EXPECT_EQ(second.size(), 4);
+    EXPECT_EQ(cache.GetHits(), 1);
+    EXPECT_EQ(cache.GetMisses(), 2);
+    EXPECT_EQ(cache.GetEntriesCount(), 2);
+}
+
+TEST(NearestPointsCacheTests, QuantizedKeys) {
+    auto poly = SquarePolyline();
+    NearestPointsCache cache(0.1);
+
+    cache.FindNearestPoints(poly, Point3D(3.01, 3.01, 0.01));
+    auto ans = cache.FindNearestPoints(poly, Point3D(3.09, 3.05, 0.02));
+
+    EXPECT_EQ(cache.GetHits(), 1);
+    ASSERT_EQ(ans.size(), 1);
+    EXPECT_NEAR(ans[0].second.GetX(), 2.0, eps);
+    EXPECT_NEAR(ans[0].second.GetY(), 2.0, eps);
+}
+
+TEST(NearestPointsCacheTests, InvalidatedByPolylineChange) {
+    auto poly = SquarePolyline();
+    NearestPointsCache cache;
+
+    cache.FindNearestPoints(poly, Point3D(5.0, 5.0, 0.0));
+    poly.AddPoint(Point3D(5.0, 5.0, 0.0));
+    auto ans = cache.FindNearestPoints(poly, Point3D(5.0, 5.0, 0.0));
+
+    EXPECT_EQ(cache.GetHits(), 0);
+    EXPECT_EQ(cache.GetEntriesCount(), 1);
+    ASSERT_EQ(ans.size(), 1);
+    EXPECT_EQ(ans[0].first, 4);
+
+    poly.SetNodes({{0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}});
+    ans = cache.FindNearestPoints(poly, Point3D(5.0, 5.0, 0.0));
+    ASSERT_EQ(ans.size(), 1);
+    EXPECT_EQ(ans[0].first, 0);
+    EXPECT_EQ(cache.GetHits(), 0);
+}
+
+TEST(NearestPointsCacheTests, MemoryBudgetEvictsLeastRecentlyUsed) {
+    auto poly = SquarePolyline();
+    NearestPointsCache probe;
+    probe.FindNearestPoints(poly, Point3D(5.0, 5.0, 0.0));
+    auto entrySize = probe.GetMemoryUsage();
+
+    NearestPointsCache cache(0.0, 2 * entrySize);
+    cache.FindNearestPoints(poly, Point3D(5.0, 5.0, 0.0));
+    cache.FindNearestPoints(poly, Point3D(6.0, 5.0, 0.0));
+    cache.FindNearestPoints(poly, Point3D(5.0, 5.0, 0.0));
+    cache.FindNearestPoints(poly, Point3D(7.0, 5.0, 0.0));
+
+    EXPECT_EQ(cache.GetEntriesCount(), 2);
+    EXPECT_LE(cache.GetMemoryUsage(), 2 * entrySize);
+
+    cache.FindNearestPoints(poly, Point3D(5.0, 5.0, 0.0));
+    EXPECT_EQ(cache.GetHits(), 2);
+    cache.FindNearestPoints(poly, Point3D(6.0, 5.0, 0.0));
+    EXPECT_EQ(cache.GetHits(), 2);
+}
+
+TEST(NearestPointsCacheTests, ConcurrentQueries) {
+    auto poly = SquarePolyline();
+    NearestPointsCache cache(0.5);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t){
+        threads.emplace_back([&cache, &poly, t]{
+            for (int i = 0; i < 1000; ++i){
+                Point3D point((i % 10) * 0.5 + 0.1, t * 0.5 + 0.1, 0.1);
+                auto ans = cache.FindNearestPoints(poly, point);
+                EXPECT_FALSE(ans.empty());
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    EXPECT_EQ(cache.GetHits() + cache.GetMisses(), 4000);
+    EXPECT_LE(cache.GetEntriesCount(), 40);
+}
+
+TEST(NearestPointsCacheTests, NegativeTolerance) {
+    EXPECT_THROW(NearestPointsCache(-1.0), std::invalid_argument);
+}
+
+TEST(NearestPointsCacheTests, CoordinatesBeyondTheGrid) {
+    auto poly = SquarePolyline();
+    NearestPointsCache cache(1e-12);
+
+    /// Cell numbers of these coordinates do not fit into 64 bits, so only equal points share results
+    auto far = cache.FindNearestPoints(poly, Point3D(1e8, 1.0, 0.0));
+    cache.FindNearestPoints(poly, Point3D(1e8, 1.0, 0.0));
+    cache.FindNearestPoints(poly, Point3D(-1e8, 1.0, 0.0));
+    cache.FindNearestPoints(poly, Point3D(std::numeric_limits<double>::infinity(), 1.0, 0.0));
+    EXPECT_EQ(cache.GetHits(), 1);
+    EXPECT_EQ(cache.GetMisses(), 3);
+    EXPECT_EQ(far.size(), FindNearestPointsToPolyline(poly, Point3D(1e8, 1.0, 0.0)).size());
+}
@@ -0,0 +1,276 @@
+#include "gtest/gtest.h"
+#include "TestPolylines.h"
+#include "static/SegmentIndex.h"
+#include "static/AtomicFile.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/GeometryObjects.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+
+/// Walks with a repeated node every 40 nodes, which make degenerate segments
+static const RandomWalkOptions duplicates{Point3D(), 1.0, 40};
+
+static void ExpectIndexMatches(const Polyline3D& poly, const SegmentIndex& index, unsigned seed){
+    ExpectMatchesBruteForce(poly, RandomPoints(100, seed, 12.0), [&](const Point3D& point){
+        return FindNearestPointsToIndexedPolyline(poly, index, point);
+    });
+}
+
+static std::string TemporaryFile(const std::string& name){
+    auto path = std::filesystem::temp_directory_path() / name;
+    std::filesystem::remove(path);
+    return path.string();
+}
+
+TEST(SegmentIndexTests, TooFewNodes) {
+    Polyline3D poly({{1.0, 1.0, 1.0}});
+    SegmentIndex index(poly);
+
+    EXPECT_EQ(index.GetNodesCount(), 0);
+    EXPECT_TRUE(FindNearestPointsToIndexedPolyline(poly, index, Point3D(0.0, 0.0, 0.0)).empty());
+    EXPECT_THROW(SegmentIndex(poly, 0), std::invalid_argument);
+}
+
+TEST(SegmentIndexTests, NodesCoverContiguousRanges) {
+    auto poly = RandomWalk(500, 1, duplicates);
+    SegmentIndex index(poly, 4);
+    const auto* nodes = index.GetNodes();
+
+    ASSERT_GT(index.GetNodesCount(), 1);
+    EXPECT_EQ(nodes[0].first, 0);
+    EXPECT_EQ(nodes[0].count, poly.GetNodesCount() - 1);
+    for (size_t i = 0; i < index.GetNodesCount(); ++i){
+        if (nodes[i].right == 0){
+            EXPECT_LE(nodes[i].count, 4);
+            continue;
+        }
+        const auto& left = nodes[i + 1];
+        const auto& right = nodes[nodes[i].right];
+        EXPECT_EQ(left.first, nodes[i].first);
+        EXPECT_EQ(right.first, left.first + left.count);
+        EXPECT_EQ(left.count + right.count, nodes[i].count);
+    }
+}
+
+TEST(SegmentIndexTests, LopsidedSplitsKeepDepthLogarithmic) {
+    /// Every segment is longer than all previous ones together, so area-based splits peel off one segment per level
+    std::vector<Point3D> nodes{Point3D(0.0, 0.0, 0.0)};
+    for (int i = 0; i < 1500; ++i) nodes.push_back(Point3D(std::pow(1.5, i), 0.0, (i % 2) * std::pow(1.5, i - 1)));
+    Polyline3D poly(std::move(nodes));
+    SegmentIndex index(poly, 4);
+    const auto* tree = index.GetNodes();
+
+    std::vector<size_t> depth(index.GetNodesCount(), 0);
+    size_t maxDepth = 0;
+    for (size_t i = 0; i < index.GetNodesCount(); ++i){
+        maxDepth = std::max(maxDepth, depth[i]);
+        if (tree[i].right == 0)
+            continue;
+        depth[i + 1] = depth[i] + 1;
+        depth[tree[i].right] = depth[i] + 1;
+    }
+    EXPECT_LE(maxDepth, 64);
+}
+
+TEST(SegmentIndexTests, MatchesBruteForce) {
+    auto poly = RandomWalk(800, 2, duplicates);
+    SegmentIndex index(poly);
+    ExpectIndexMatches(poly, index, 3);
+
+    /// Ties between symmetric segments
+    Polyline3D square({{0.0, 0.0, 0.0}, {2.0, 0.0, 0.0}, {2.0, 2.0, 0.0}, {0.0, 2.0, 0.0}, {0.0, 0.0, 0.0}});
+    SegmentIndex squareIndex(square, 1);
+    EXPECT_EQ(FindNearestPointsToIndexedPolyline(square, squareIndex, Point3D(1.0, 1.0, 0.0)).size(), 4);
+    EXPECT_THROW(FindNearestPointsToIndexedPolyline(poly, squareIndex, Point3D(1.0, 1.0, 0.0)), std::invalid_argument);
+}
+
+TEST(SegmentIndexTests, SaveAndMap) {
+    auto poly = RandomWalk(600, 4, duplicates);
+    auto filename = TemporaryFile("segment_index_save.idx");
+    SegmentIndex built(poly);
+    ASSERT_TRUE(built.Save(filename));
+
+    auto mapped = SegmentIndex::Map(filename, poly);
+    ASSERT_TRUE(mapped.has_value());
+    EXPECT_EQ(mapped->GetNodesCount(), built.GetNodesCount());
+    ExpectIndexMatches(poly, *mapped, 5);
+
+    /// Moving keeps the mapping
+    SegmentIndex moved = std::move(*mapped);
+    EXPECT_EQ(moved.GetNodesCount(), built.GetNodesCount());
+    ExpectIndexMatches(poly, moved, 6);
+
+    std::filesystem::remove(filename);
+}
+
+TEST(SegmentIndexTests, MismatchedFilesAreRejected) {
+    auto poly = RandomWalk(300, 7, duplicates);
+    auto filename = TemporaryFile("segment_index_mismatch.idx");
+    ASSERT_TRUE(SegmentIndex(poly).Save(filename));
+
+    EXPECT_FALSE(SegmentIndex::Map(filename, RandomWalk(300, 8, duplicates)).has_value());
+    EXPECT_FALSE(SegmentIndex::Map(filename + ".missing", poly).has_value());
+
+    /// Corrupt a node
+    {
+        std::fstream file(filename, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(64 + 8);
+        file.put('\x7f');
+    }
+    EXPECT_FALSE(SegmentIndex::Map(filename, poly).has_value());
+
+    /// Another format version
+    ASSERT_TRUE(SegmentIndex(poly).Save(filename));
+    {
+        std::fstream file(filename, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(8);
+        file.put(static_cast<char>(SegmentIndex::version + 1));
+    }
+    EXPECT_FALSE(SegmentIndex::Map(filename, poly).has_value());
+
+    std::filesystem::remove(filename);
+}
+
+TEST(SegmentIndexTests, OpenRebuildsAndRewrites) {
+    auto poly = RandomWalk(300, 9, duplicates);
+    auto filename = TemporaryFile("segment_index_open.idx");
+
+    auto rebuilt = SegmentIndex::Open(filename, poly);
+    EXPECT_FALSE(rebuilt.IsMapped());
+    ExpectIndexMatches(poly, rebuilt, 10);
+
+    auto mapped = SegmentIndex::Open(filename, poly);
+#if defined(__unix__) || defined(__APPLE__)
+    EXPECT_TRUE(mapped.IsMapped());
+#endif
+    EXPECT_EQ(mapped.GetNodesCount(), rebuilt.GetNodesCount());
+
+    /// The polyline changed, so the file is replaced
+    poly.AddPoint(Point3D(1.0, 2.0, 3.0));
+    auto updated = SegmentIndex::Open(filename, poly);
+    EXPECT_FALSE(updated.IsMapped());
+    ExpectIndexMatches(poly, updated, 11);
+    EXPECT_TRUE(SegmentIndex::Map(filename, poly).has_value());
+
+    std::filesystem::remove(filename);
+}
+
+TEST(SegmentIndexTests, OpenFromSeveralThreads) {
+    auto poly = RandomWalk(2000, 12, duplicates);
+    auto filename = TemporaryFile("segment_index_open_threads.idx");
+
+    /// Every thread writes its own temporary file, so no rename publishes a partly written one
+    EXPECT_NE(TemporaryFileName(filename), filename + ".tmp");
+    std::vector<std::thread> threads;
+    std::vector<size_t> counts(8, 0);
+    for (size_t t = 0; t < counts.size(); ++t){
+        threads.emplace_back([&, t]{ counts[t] = SegmentIndex::Open(filename, poly).GetNodesCount(); });
+    }
+    for (auto& thread : threads) thread.join();
+    for (auto count : counts) EXPECT_EQ(count, SegmentIndex(poly).GetNodesCount());
+    EXPECT_TRUE(SegmentIndex::Map(filename, poly).has_value());
+
+    for (const auto& entry : std::filesystem::directory_iterator(std::filesystem::path(filename).parent_path())){
+        EXPECT_NE(entry.path().string().rfind(filename + ".tmp", 0), 0) << entry.path();
+    }
+    std::filesystem::remove(filename);
+}
+
+TEST(SegmentIndexTests, RefitAfterSmallMotion) {
+    auto poly = RandomWalk(3000, 11, duplicates);
+    SegmentIndex index(poly, 4);
+    SegmentIndex serial(poly, 4);
+
+    std::mt19937 gen(12);
+    std::uniform_real_distribution<double> jitter(-0.05, 0.05);
+    for (int tick = 0; tick < 5; ++tick){
+        auto nodes = poly.GetNodes();
+        for (auto& node : nodes) node = Point3D(node.GetX() + jitter(gen), node.GetY() + jitter(gen), node.GetZ());
+        poly.SetNodes(nodes);
+
+        EXPECT_EQ(index.Refit(poly, SegmentIndex::defaultMaxDegradation, 4), SegmentIndex::RefitResult::Refitted);
+        EXPECT_EQ(serial.Refit(poly, SegmentIndex::defaultMaxDegradation, 1), SegmentIndex::RefitResult::Refitted);
+        EXPECT_GT(index.GetDegradation(), 0.5);
+        EXPECT_LT(index.GetDegradation(), SegmentIndex::defaultMaxDegradation);
+        ExpectIndexMatches(poly, index, 13 + tick);
+    }
+
+    /// Threads refit the same bounds
+    ASSERT_EQ(index.GetNodesCount(), serial.GetNodesCount());
+    for (size_t i = 0; i < index.GetNodesCount(); ++i){
+        EXPECT_EQ(index.GetNodes()[i].boxMin, serial.GetNodes()[i].boxMin);
+        EXPECT_EQ(index.GetNodes()[i].boxMax, serial.GetNodes()[i].boxMax);
+    }
+    EXPECT_THROW(index.Refit(RandomWalk(10, 1, duplicates)), std::invalid_argument);
+    EXPECT_THROW(index.Refit(poly, 0.5), std::invalid_argument);
+}
+
+TEST(SegmentIndexTests, UpdateNodesRefitsTouchedLeaves) {
+    auto poly = RandomWalk(3000, 31, duplicates);
+    auto filename = TemporaryFile("segment_index_update.idx");
+    ASSERT_TRUE(SegmentIndex(poly, 4).Save(filename));
+    auto index = SegmentIndex::Map(filename, poly);
+    ASSERT_TRUE(index.has_value());
+
+    /// Moves of the first, the last and some inner nodes, one of them twice
+    std::mt19937 gen(32);
+    std::uniform_real_distribution<double> jitter(-0.3, 0.3);
+    std::vector<std::pair<size_t, Point3D>> moves;
+    for (size_t node : {size_t{0}, size_t{17}, size_t{18}, size_t{1500}, size_t{17}, poly.GetNodesCount() - 1}){
+        const auto& old = poly.GetNodes()[node];
+        moves.push_back({node, Point3D(old.GetX() + jitter(gen), old.GetY() + jitter(gen), old.GetZ() + jitter(gen))});
+    }
+    EXPECT_EQ(index->UpdateNodes(poly, moves), SegmentIndex::RefitResult::Refitted);
+    EXPECT_FALSE(index->IsMapped());
+    EXPECT_TRUE(poly.GetNodes()[17] == moves[4].second);
+
+    /// The bounds, the cost and the fingerprint are those of a full refit
+    SegmentIndex refitted(RandomWalk(3000, 31, duplicates), 4);
+    refitted.Refit(poly);
+    ASSERT_EQ(index->GetNodesCount(), refitted.GetNodesCount());
+    for (size_t i = 0; i < index->GetNodesCount(); ++i){
+        EXPECT_EQ(index->GetNodes()[i].boxMin, refitted.GetNodes()[i].boxMin);
+        EXPECT_EQ(index->GetNodes()[i].boxMax, refitted.GetNodes()[i].boxMax);
+    }
+    EXPECT_NEAR(index->GetDegradation(), refitted.GetDegradation(), 1e-9);
+    ExpectIndexMatches(poly, *index, 33);
+    ASSERT_TRUE(index->Save(filename));
+    EXPECT_TRUE(SegmentIndex::Map(filename, poly).has_value());
+
+    auto before = poly.GetNodes();
+    EXPECT_THROW(index->UpdateNodes(poly, {{1, Point3D()}, {poly.GetNodesCount(), Point3D()}}), std::invalid_argument);
+    EXPECT_THROW(index->UpdateNodes(poly, moves, 0.5), std::invalid_argument);
+    EXPECT_EQ(poly.GetNodes(), before);
+    std::filesystem::remove(filename);
+}
+
+TEST(SegmentIndexTests, RefitRebuildsDegradedHierarchy) {
+    auto poly = RandomWalk(2000, 21, duplicates);
+    auto filename = TemporaryFile("segment_index_refit.idx");
+    ASSERT_TRUE(SegmentIndex(poly).Save(filename));
+    auto index = SegmentIndex::Map(filename, poly);
+    ASSERT_TRUE(index.has_value());
+
+    /// Shuffled nodes leave neighbouring segments far apart, so every box grows
+    auto nodes = poly.GetNodes();
+    std::shuffle(nodes.begin(), nodes.end(), std::mt19937(22));
+    poly.SetNodes(nodes);
+    EXPECT_EQ(index->Refit(poly), SegmentIndex::RefitResult::Rebuilt);
+    EXPECT_FALSE(index->IsMapped());
+    EXPECT_DOUBLE_EQ(index->GetDegradation(), 1.0);
+    ExpectIndexMatches(poly, *index, 23);
+
+    /// Without a limit the degraded bounds are kept and still give exact results
+    SegmentIndex refitted(RandomWalk(2000, 21, duplicates));
+    EXPECT_EQ(refitted.Refit(poly, 1e9), SegmentIndex::RefitResult::Refitted);
+    EXPECT_GT(refitted.GetDegradation(), SegmentIndex::defaultMaxDegradation);
+    ExpectIndexMatches(poly, refitted, 24);
+    std::filesystem::remove(filename);
+}
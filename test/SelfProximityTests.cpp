@@ -0,0 +1,103 @@
+#include "gtest/gtest.h"
+#include "TestPolylines.h"
+#include "static/SelfProximity.h"
+#include "static/SegmentIndex.h"
+#include "static/SegmentKernel.h"
+#include "static/3DMathOperations.h"
+#include "static/GeometryObjects.h"
+#include <cmath>
+#include <stdexcept>
+
+
+TEST(SelfProximityTests, InvalidArguments) {
+    Polyline3D poly({{0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}});
+    EXPECT_THROW(FindSelfProximities(poly, -1.0), std::invalid_argument);
+    EXPECT_THROW(FindSelfProximities(poly, SegmentIndex(), 1.0), std::invalid_argument);
+    EXPECT_TRUE(FindSelfProximities(Polyline3D(), 1.0).empty());
+}
+
+TEST(SelfProximityTests, HairpinAndCrossing) {
+    /// Legs of the hairpin are 0.5 apart, the last segment crosses the first one
+    Polyline3D poly({{0.0, 0.0, 0.0}, {4.0, 0.0, 0.0}, {4.0, 0.5, 0.0}, {1.0, 0.5, 0.0}, {1.0, -1.0, 0.0}});
+    SegmentIndex index(poly, 1);
+
+    auto ans = FindSelfProximities(poly, index, 0.6, 1);
+    ASSERT_EQ(ans.size(), 2);
+    EXPECT_EQ(ans[0].first, 0);
+    EXPECT_EQ(ans[0].second, 2);
+    EXPECT_NEAR(ans[0].distance, 0.5, eps);
+    EXPECT_NEAR(ans[0].firstPoint.GetY(), 0.0, eps);
+    EXPECT_NEAR(ans[0].secondPoint.GetY(), 0.5, eps);
+
+    EXPECT_EQ(ans[1].first, 0);
+    EXPECT_EQ(ans[1].second, 3);
+    EXPECT_NEAR(ans[1].distance, 0.0, eps);
+    EXPECT_NEAR(ans[1].firstPoint.GetX(), 1.0, eps);
+
+    /// Only the crossing is an intersection
+    ans = FindSelfProximities(poly, index, 0.0, 1);
+    ASSERT_EQ(ans.size(), 1);
+    EXPECT_EQ(ans[0].second, 3);
+}
+
+TEST(SelfProximityTests, AdjacentThroughDegenerateSegments) {
+    Polyline3D poly({{0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}, {1.0, 0.0, 0.0}, {1.0, 0.0, 0.0}, {0.0, 0.1, 0.0}});
+    EXPECT_TRUE(FindSelfProximities(poly, 1.0).empty());
+
+    /// A repeated first node is a degenerate segment as well
+    Polyline3D repeatedStart({{0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, {0.1, 0.0, 0.0}, {0.2, 0.0, 0.0}});
+    EXPECT_TRUE(FindSelfProximities(repeatedStart, 0.5).empty());
+}
+
+TEST(SelfProximityTests, ClosedLoop) {
+    /// The square closes at its first node, which is no intersection; the last leg comes close to the first one
+    Polyline3D square({{0.0, 0.0, 0.0}, {2.0, 0.0, 0.0}, {2.0, 2.0, 0.0}, {0.0, 2.0, 0.0}, {0.0, 0.0, 0.0}});
+    EXPECT_TRUE(FindSelfProximities(square, 0.0).empty());
+
+    Polyline3D repeatedEnds({{0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, {2.0, 0.0, 0.0}, {2.0, 2.0, 0.0}, {0.0, 2.0, 0.0},
+                             {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}});
+    EXPECT_TRUE(FindSelfProximities(repeatedEnds, 0.0).empty());
+
+    Polyline3D crossing({{0.0, 0.0, 0.0}, {2.0, 0.0, 0.0}, {2.0, 2.0, 0.0}, {1.0, -1.0, 0.0}, {0.0, 0.0, 0.0}});
+    auto ans = FindSelfProximities(crossing, 0.0);
+    ASSERT_EQ(ans.size(), 1);
+    EXPECT_EQ(ans[0].first, 0);
+    EXPECT_EQ(ans[0].second, 2);
+}
+
+TEST(SelfProximityTests, MatchesAllPairs) {
+    auto poly = RandomWalk(300, 23);
+    const auto& nodes = poly.GetNodes();
+    SegmentIndex index(poly, 4);
+    const auto threshold = 0.3;
+
+    size_t expected = 0;
+    for (size_t i = 0; i + 1 < nodes.size(); ++i){
+        for (size_t j = i + 2; j + 1 < nodes.size(); ++j){
+            auto coords = [&nodes](size_t k){ return SegmentKernel<3>::Coords{nodes[k].GetX(), nodes[k].GetY(), nodes[k].GetZ()}; };
+            SegmentKernel<3>::Coords direction{nodes[i + 1].GetX() - nodes[i].GetX(), nodes[i + 1].GetY() - nodes[i].GetY(),
+                                               nodes[i + 1].GetZ() - nodes[i].GetZ()};
+            auto s = 0.0;
+            auto t = 0.0;
+            auto squared = SegmentKernel<3>::SquaredDistanceLineToSegment(coords(i), direction, 0.0, 1.0,
+                                                                          coords(j), coords(j + 1), s, t);
+            if (std::sqrt(squared) <= threshold) ++expected;
+        }
+    }
+
+    auto single = FindSelfProximities(poly, index, threshold, 1);
+    auto parallel = FindSelfProximities(poly, index, threshold, 4);
+    EXPECT_GT(single.size(), 0);
+    EXPECT_EQ(single.size(), expected);
+    ASSERT_EQ(single.size(), parallel.size());
+    for (size_t i = 0; i < single.size(); ++i){
+        EXPECT_EQ(single[i].first, parallel[i].first);
+        EXPECT_EQ(single[i].second, parallel[i].second);
+        EXPECT_LE(single[i].distance, threshold + eps);
+        EXPECT_NEAR(DistanceBetweenPoints(single[i].firstPoint, single[i].secondPoint), single[i].distance, eps);
+        if (i > 0){
+            EXPECT_TRUE(single[i - 1].first < single[i].first ||
+                        (single[i - 1].first == single[i].first && single[i - 1].second < single[i].second));
+        }
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "gtest/gtest.h"
+#include "static/GeometryObjects.h"
+#include "static/NearestPointsAlgorithm.h"
+#include <random>
+#include <utility>
+#include <vector>
+
+/**
+ * @struct RandomWalkOptions
+ * @brief Shape of the polylines made by RandomWalk.
+ */
+struct RandomWalkOptions{
+    Point3D start;                    ///< First node.
+    double zScale = 1.0;              ///< Scale of the steps along z, small for nearly planar walks.
+    size_t repeatEvery = 0;           ///< Repeat every node whose number is a multiple of it, 0 for none.
+};
+
+/**
+ * @brief Makes a polyline whose nodes take random steps of at most 1 along each axis.
+ * @param count Number of steps plus one, repeated nodes come on top.
+ * @param seed Seed of the steps.
+ * @param options Shape of the walk.
+ * @return The polyline.
+ */
+inline Polyline3D RandomWalk(size_t count, unsigned seed, const RandomWalkOptions& options = RandomWalkOptions()){
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> step(-1.0, 1.0);
+    std::vector<Point3D> nodes{options.start};
+    for (size_t i = 1; i < count; ++i){
+        const auto& last = nodes.back();
+        nodes.push_back(Point3D(last.GetX() + step(gen), last.GetY() + step(gen), last.GetZ() + options.zScale * step(gen)));
+        if (options.repeatEvery != 0 && i % options.repeatEvery == 0) nodes.push_back(nodes.back());
+    }
+    return Polyline3D(std::move(nodes));
+}
+
+/**
+ * @brief Makes query points spread uniformly over a cube around the origin.
+ * @param count Number of points.
+ * @param seed Seed of the coordinates.
+ * @param range Half the edge of the cube.
+ * @return The points.
+ */
+inline std::vector<Point3D> RandomPoints(size_t count, unsigned seed, double range){
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> coord(-range, range);
+    std::vector<Point3D> points;
+    for (size_t i = 0; i < count; ++i){
+        auto x = coord(gen);
+        auto y = coord(gen);
+        points.push_back(Point3D(x, y, coord(gen)));
+    }
+    return points;
+}
+
+/**
+ * @brief Expects a result to have the segments of one of FindNearestPointsToPolyline and the same points.
+ * @param ans The result to check.
+ * @param expected The result of FindNearestPointsToPolyline.
+ * @param tolerance Largest difference of a coordinate, 0 for bitwise equal points.
+ */
+inline void ExpectSameResults(const std::vector<std::pair<size_t, Point3D>>& ans,
+                              const std::vector<std::pair<size_t, Point3D>>& expected, double tolerance = 0.0){
+    ASSERT_EQ(ans.size(), expected.size());
+    for (size_t i = 0; i < ans.size(); ++i){
+        EXPECT_EQ(ans[i].first, expected[i].first);
+        if (tolerance == 0.0){
+            EXPECT_TRUE(ans[i].second == expected[i].second);
+            continue;
+        }
+        EXPECT_NEAR(ans[i].second.GetX(), expected[i].second.GetX(), tolerance);
+        EXPECT_NEAR(ans[i].second.GetY(), expected[i].second.GetY(), tolerance);
+        EXPECT_NEAR(ans[i].second.GetZ(), expected[i].second.GetZ(), tolerance);
+    }
+}
+
+/**
+ * @brief Expects a query to give the results of FindNearestPointsToPolyline for every point.
+ * @param poly The polyline.
+ * @param points The query points.
+ * @param find Returns the result of the query under test for a point.
+ * @param tolerance Largest difference of a coordinate, 0 for bitwise equal points.
+ */
+template <typename Find>
+void ExpectMatchesBruteForce(const Polyline3D& poly, const std::vector<Point3D>& points, const Find& find,
+                             double tolerance = 0.0){
+    for (const auto& point : points){
+        ExpectSameResults(find(point), FindNearestPointsToPolyline(poly, point), tolerance);
+    }
+}
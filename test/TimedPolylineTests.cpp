@@ -0,0 +1,117 @@
+#include "gtest/gtest.h"
+#include "TestPolylines.h"
+#include "static/TimedPolyline.h"
+#include "static/NearestPointsAlgorithm.h"
+#include "static/3DMathOperations.h"
+#include "static/GeometryObjects.h"
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+
+TEST(TimedPolylineTests, InvalidTimestampsAndWindows) {
+    Polyline3D poly({{0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}, {2.0, 0.0, 0.0}});
+
+    EXPECT_THROW(TimedPolyline3D(poly, {0.0, 1.0}), std::invalid_argument);
+    EXPECT_THROW(TimedPolyline3D(poly, {0.0, 2.0, 1.0}), std::invalid_argument);
+    EXPECT_THROW(TimedPolyline3D(poly, {0.0, std::nan(""), 2.0}), std::invalid_argument);
+
+    TimedPolyline3D track(poly, {0.0, 10.0, 20.0});
+    EXPECT_THROW(track.FindNearestPoints(Point3D(0.0, 0.0, 0.0), 5.0, 4.0), std::invalid_argument);
+    EXPECT_THROW(track.FindSegmentsInWindow(std::nan(""), 4.0), std::invalid_argument);
+    EXPECT_TRUE(track.FindNearestPoints(Point3D(0.0, 0.0, 0.0), 21.0, 30.0).empty());
+    EXPECT_TRUE(TimedPolyline3D().FindNearestPoints(Point3D(0.0, 0.0, 0.0), 0.0, 1.0).empty());
+}
+
+TEST(TimedPolylineTests, WindowMapsToSegments) {
+    Polyline3D poly({{0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}, {2.0, 0.0, 0.0}, {3.0, 0.0, 0.0}, {4.0, 0.0, 0.0}});
+    TimedPolyline3D track(poly, {0.0, 10.0, 10.0, 20.0, 30.0});
+
+    using Range = std::pair<size_t, size_t>;
+    EXPECT_EQ(track.FindSegmentsInWindow(-5.0, 30.0), Range(0, 4));
+    EXPECT_EQ(track.FindSegmentsInWindow(12.0, 15.0), Range(2, 3));
+    EXPECT_EQ(track.FindSegmentsInWindow(10.0, 10.0), Range(0, 3));
+    EXPECT_EQ(track.FindSegmentsInWindow(30.0, 40.0), Range(3, 4));
+    EXPECT_EQ(track.FindSegmentsInWindow(31.0, 40.0), Range(0, 0));
+}
+
+TEST(TimedPolylineTests, ClipsSegmentsAndInterpolatesTime) {
+    /// Out along the x axis from t = 0 to 10 and back from t = 10 to 20
+    Polyline3D poly({{0.0, 0.0, 0.0}, {10.0, 0.0, 0.0}, {0.0, 1.0, 0.0}});
+    TimedPolyline3D track(poly, {0.0, 10.0, 20.0});
+    Point3D point(3.0, -1.0, 0.0);
+
+    auto ans = track.FindNearestPoints(point, 0.0, 20.0);
+    ASSERT_EQ(ans.size(), 1);
+    EXPECT_EQ(ans[0].segment, 0);
+    EXPECT_TRUE(ans[0].point == Point3D(3.0, 0.0, 0.0));
+    EXPECT_NEAR(ans[0].time, 3.0, 1e-9);
+    EXPECT_NEAR(ans[0].distance, 1.0, 1e-9);
+
+    /// The start of the window cuts off the nearest part of the first segment
+    ans = track.FindNearestPoints(Point3D(4.0, -1.0, 0.0), 5.0, 20.0);
+    ASSERT_EQ(ans.size(), 1);
+    EXPECT_EQ(ans[0].segment, 0);
+    EXPECT_TRUE(ans[0].point == Point3D(5.0, 0.0, 0.0));
+    EXPECT_NEAR(ans[0].time, 5.0, 1e-9);
+
+    /// Later in the window the track is only on its way back
+
+    ans = track.FindNearestPoints(point, 12.0, 20.0);
+    ASSERT_EQ(ans.size(), 1);
+    EXPECT_EQ(ans[0].segment, 1);
+    EXPECT_NEAR(ans[0].time, 12.0 + 8.0 * 39.04 / 64.64, 1e-9);
+    auto expected = FindNearestPointsToPolyline(Polyline3D({{8.0, 0.2, 0.0}, {0.0, 1.0, 0.0}}), point);
+    ASSERT_EQ(expected.size(), 1);
+    EXPECT_TRUE(ans[0].point == expected[0].second);
+
+    /// A single instant is the position of the track at that time
+    ans = track.FindNearestPoints(point, 15.0, 15.0);
+    ASSERT_EQ(ans.size(), 1);
+    EXPECT_TRUE(ans[0].point == Point3D(5.0, 0.5, 0.0));
+    EXPECT_DOUBLE_EQ(ans[0].time, 15.0);
+}
+
+TEST(TimedPolylineTests, StandingStillCountsAsPosition) {
+    Polyline3D poly({{0.0, 0.0, 0.0}, {2.0, 0.0, 0.0}, {2.0, 0.0, 0.0}, {2.0, 4.0, 0.0}});
+    TimedPolyline3D track(poly, {0.0, 2.0, 8.0, 12.0});
+
+    auto ans = track.FindNearestPoints(Point3D(0.0, 0.0, 0.0), 3.0, 7.0);
+    ASSERT_EQ(ans.size(), 1);
+    EXPECT_EQ(ans[0].segment, 1);
+    EXPECT_TRUE(ans[0].point == Point3D(2.0, 0.0, 0.0));
+    EXPECT_DOUBLE_EQ(ans[0].distance, 2.0);
+}
+
+TEST(TimedPolylineTests, MatchesBruteForceOnWindow) {
+    auto poly = RandomWalk(1500, 46);
+    const auto& nodes = poly.GetNodes();
+    std::mt19937 gen(47);
+    std::uniform_real_distribution<double> duration(0.1, 2.0);
+    std::vector<double> timestamps{0.0};
+    while (timestamps.size() < nodes.size()) timestamps.push_back(timestamps.back() + duration(gen));
+    TimedPolyline3D track(poly, timestamps, 4);
+
+    std::uniform_int_distribution<size_t> node(0, nodes.size() - 1);
+    for (const auto& point : RandomPoints(100, 48, 15.0)){
+        auto from = node(gen), to = node(gen);
+        if (from > to) std::swap(from, to);
+        if (from == to) continue;
+
+        /// A window from node to node equals the polyline between them
+        auto ans = track.FindNearestPoints(point, timestamps[from], timestamps[to]);
+        auto expected = FindNearestPointsToPolyline(
+            Polyline3D(std::vector<Point3D>(nodes.begin() + from, nodes.begin() + to + 1)), point);
+        ASSERT_FALSE(ans.empty());
+        ASSERT_FALSE(expected.empty());
+        EXPECT_NEAR(ans[0].distance, DistanceBetweenPoints(point, expected[0].second), 1e-9);
+        EXPECT_TRUE(ans[0].point == expected[0].second);
+        for (const auto& found : ans){
+            EXPECT_GE(found.time, timestamps[from]);
+            EXPECT_LE(found.time, timestamps[to]);
+            EXPECT_GE(found.time, timestamps[found.segment]);
+            EXPECT_LE(found.time, timestamps[found.segment + 1]);
+        }
+    }
+}
@@ -0,0 +1,101 @@
+#include "gtest/gtest.h"
+#include "static/Trace.h"
+#include "static/SegmentIndex.h"
+#include "static/GeometryObjects.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+TEST(TraceTests, NothingIsRecordedWhileOff) {
+    ClearTraceEvents();
+    {
+        TraceScope scope("ignored");
+    }
+    EXPECT_TRUE(CollectTraceEvents().empty());
+}
+
+TEST(TraceTests, ScopesOfSeveralThreads) {
+    ClearTraceEvents();
+    StartTracing();
+    {
+        TraceScope outer("outer", "test");
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 3; ++t){
+            threads.emplace_back([]{
+                TraceScope inner("inner", "test");
+            });
+        }
+        for (auto& thread : threads) thread.join();
+    }
+    SegmentIndex index(Polyline3D({{0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}, {1.0, 1.0, 0.0}}));
+    StopTracing();
+
+    /// Buffers of finished threads are still collected
+    auto events = CollectTraceEvents();
+    ASSERT_EQ(events.size(), 5);
+    EXPECT_STREQ(events[0].name, "outer");
+    EXPECT_STREQ(events.back().name, "build_segment_index");
+    std::set<uint32_t> threads;
+    for (const auto& event : events){
+        if (std::string(event.name) == "inner"){
+            threads.insert(event.thread);
+            EXPECT_GE(event.start, events[0].start);
+            EXPECT_LE(event.start + event.duration, events[0].start + events[0].duration);
+        }
+    }
+    EXPECT_EQ(threads.size(), 3);
+    EXPECT_EQ(threads.count(events[0].thread), 0);
+    ClearTraceEvents();
+}
+
+TEST(TraceTests, WritesChromeTraceFormat) {
+    std::string filename = "trace_tests.json";
+    ClearTraceEvents();
+    {
+        TraceSession session(filename);
+        SetTraceThreadName("tester \"main\"");
+        TraceScope scope("write", "test");
+    }
+    EXPECT_FALSE(IsTracing());
+
+    std::ifstream file(filename);
+    std::stringstream text;
+    text << file.rdbuf();
+    auto json = text.str();
+    EXPECT_EQ(json.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0), 0);
+    EXPECT_NE(json.find("\"ph\":\"X\",\"name\":\"write\",\"cat\":\"test\""), std::string::npos);
+    EXPECT_NE(json.find("\"args\":{\"name\":\"tester \\\"main\\\"\"}"), std::string::npos);
+    file.close();
+    std::remove(filename.c_str());
+    ClearTraceEvents();
+}
+
+TEST(TraceTests, FinishReportsWriteErrors) {
+    ClearTraceEvents();
+    TraceSession session("missing_directory/trace.json");
+    EXPECT_FALSE(session.Finish());
+    EXPECT_FALSE(IsTracing());
+    EXPECT_TRUE(session.Finish());
+    EXPECT_TRUE(TraceSession("").Finish());
+    ClearTraceEvents();
+}
+
+TEST(TraceTests, FinishReportsFullDevice) {
+    if (!std::filesystem::exists("/dev/full"))
+        GTEST_SKIP() << "No /dev/full";
+
+    /// The trace fits into the stream buffer, so the error only shows when the file is closed
+    ClearTraceEvents();
+    TraceSession session("/dev/full");
+    {
+        TraceScope scope("write", "test");
+    }
+    EXPECT_FALSE(session.Finish());
+    ClearTraceEvents();
+}